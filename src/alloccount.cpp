@@ -0,0 +1,123 @@
+#include "alloccount.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+using namespace gamespace;
+
+// constant initialized, safe to touch from operator new on any thread
+static thread_local std::uint64_t allocations{0};
+
+static void *allocate(std::size_t size) {
+  allocations++;
+  return std::malloc(size == 0 ? 1 : size);
+}
+
+static void *allocate(std::size_t size, std::align_val_t alignment) {
+  allocations++;
+  const std::size_t align{static_cast<std::size_t>(alignment)};
+  // aligned_alloc wants a multiple of the alignment
+  return std::aligned_alloc(align, (std::max<std::size_t>(size, 1) + align -
+                                    1) / align * align);
+}
+
+void *operator new(std::size_t size) {
+  if (void *p = allocate(size))
+    return p;
+  throw std::bad_alloc();
+}
+void *operator new[](std::size_t size) { return operator new(size); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  return allocate(size);
+}
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+  return allocate(size);
+}
+void *operator new(std::size_t size, std::align_val_t alignment) {
+  if (void *p = allocate(size, alignment))
+    return p;
+  throw std::bad_alloc();
+}
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+  return operator new(size, alignment);
+}
+void *operator new(std::size_t size, std::align_val_t alignment,
+                   const std::nothrow_t &) noexcept {
+  return allocate(size, alignment);
+}
+void *operator new[](std::size_t size, std::align_val_t alignment,
+                     const std::nothrow_t &) noexcept {
+  return allocate(size, alignment);
+}
+
+// malloc and aligned_alloc are both released with free
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept {
+  std::free(p);
+}
+void operator delete[](void *p, const std::nothrow_t &) noexcept {
+  std::free(p);
+}
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept {
+  std::free(p);
+}
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept {
+  std::free(p);
+}
+void operator delete(void *p, std::align_val_t,
+                     const std::nothrow_t &) noexcept {
+  std::free(p);
+}
+void operator delete[](void *p, std::align_val_t,
+                       const std::nothrow_t &) noexcept {
+  std::free(p);
+}
+
+std::uint64_t gamespace::threadAllocations() { return allocations; }
+
+AllocationCheck::AllocationCheck(int warmupTurns, int turnsToMeasure)
+    : warmupTurns(warmupTurns), turnsToMeasure(turnsToMeasure), turnsSeen(0),
+      frameStart(threadAllocations()), turnStart(threadAllocations()),
+      frames(0), allocatingFrames(0), turns(0), maxPerFrame(0),
+      maxPerTurn(0), total(0) {}
+
+// everything since the last frame: events, the game coroutine resumed by
+// the scheduler and drawing
+void AllocationCheck::frameEnded() {
+  const std::uint64_t now{threadAllocations()};
+  const std::uint64_t count{now - frameStart};
+  frameStart = now;
+  if (turnsSeen < warmupTurns)
+    return;
+  frames++;
+  if (count > 0)
+    allocatingFrames++;
+  maxPerFrame = std::max(maxPerFrame, count);
+}
+
+void AllocationCheck::turnEnded() {
+  const std::uint64_t now{threadAllocations()};
+  const std::uint64_t count{now - turnStart};
+  turnStart = now;
+  if (turnsSeen++ < warmupTurns)
+    return;
+  turns++;
+  total += count;
+  maxPerTurn = std::max(maxPerTurn, count);
+}
+
+bool AllocationCheck::report() const {
+  std::cout << "allocations after " << warmupTurns << " warm up turns: "
+            << total << " in " << turns << " turns (at most " << maxPerTurn
+            << " per turn), " << allocatingFrames << " of " << frames
+            << " frames allocated (at most " << maxPerFrame
+            << " per frame)\n";
+  return total == 0 && allocatingFrames == 0;
+}
@@ -0,0 +1,42 @@
+#ifndef ALLOCCOUNT_H
+#define ALLOCCOUNT_H
+
+#include <cstdint>
+
+namespace gamespace {
+
+/**
+ * @brief operator new calls made by the calling thread so far. Only counted
+ * in programs that link alloccount.cpp, which replaces the global operator
+ * new and delete, the game does.
+ */
+std::uint64_t threadAllocations();
+
+/**
+ * @brief What one thread allocates per frame and per turn once the first
+ * turns warmed up every buffer and pool, for --check-allocations. In a
+ * steady state both stay at zero.
+ */
+class AllocationCheck {
+public:
+  void frameEnded();
+  void turnEnded();
+  bool finished() const { return turns >= turnsToMeasure; }
+  // prints the counts, false when the steady state allocated
+  bool report() const;
+
+private:
+  int warmupTurns;
+  int turnsToMeasure;
+  int turnsSeen;
+  std::uint64_t frameStart, turnStart;
+  long frames, allocatingFrames;
+  int turns;
+  std::uint64_t maxPerFrame, maxPerTurn, total;
+
+public:
+  AllocationCheck(int warmupTurns, int turnsToMeasure);
+};
+
+} // namespace gamespace
+#endif
@@ -0,0 +1,339 @@
+#include "analysis.h"
+#include "evalcache.h"
+
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <random>
+#include <thread>
+
+using namespace gamespace;
+using namespace std::literals;
+
+// rollout rounds per position before the estimate stops refining
+static const long MAX_ROUNDS{20000};
+// rounds a task plays before checking back in with the pool
+static const int ROUNDS_PER_TASK{64};
+// a rollout that runs longer than this is abandoned
+static const int MAX_ROLLOUT_STEPS{20000};
+// rounds SpeculativeSearch wants before it trusts its best move
+static const long MIN_SEARCH_ROUNDS{500};
+
+/**
+ * One position under one dice value. Every round plays a rollout from the
+ * position itself (when baseline is set) and one after each legal move.
+ */
+struct gamespace::RolloutJob {
+  ThreadPool *pool;
+  GameState state;
+  int numPlayers;
+  RuleSet rules;
+  int diceValue;
+  unsigned legal;
+  bool baseline;
+  // looked up once when the job starts, cached.move is legal when set
+  bool hasCached{false};
+  CachedMove cached{};
+  bool owned{false}; // by a WinEstimator or SpeculativeSearch, see JobPool
+  std::atomic<bool> cancelled{false};
+  std::atomic<int> batches{0}; // queued or running
+  std::atomic<long> rounds{0};
+  std::array<std::atomic<long>, 4> wins{};
+  std::array<std::atomic<long>, 4> moveWins{};
+};
+
+namespace {
+
+std::minstd_rand &generator() {
+  thread_local std::minstd_rand g{std::random_device{}()};
+  return g;
+}
+
+// random legal piece, the simplest policy that still finishes games
+template <class R> int randomMove(const typename R::State &state, int dice) {
+  unsigned legal{R::legalMoves(state, dice)};
+  int skip = generator()() % std::popcount(legal);
+  while (skip--)
+    legal &= legal - 1;
+  return std::countr_zero(legal);
+}
+
+// plays the game out from a state waiting for a roll, returns the winner
+template <class R> int rollout(typename R::State state) {
+  std::uniform_int_distribution<int> dist(1, 6);
+  for (int steps = 0; steps < MAX_ROLLOUT_STEPS && !R::isOver(state);
+       steps++) {
+    int dice{dist(generator())};
+    if (R::roll(state, dice))
+      R::play(state, randomMove<R>(state, dice), dice);
+  }
+  return state.winner;
+}
+
+template <class R> void playRound(RolloutJob &job) {
+  const typename R::State state{toState<R>(job.state)};
+  if (job.baseline) {
+    int winner{rollout<R>(state)};
+    if (winner >= 0)
+      job.wins[winner]++;
+  }
+  for (unsigned moves = job.legal; moves != 0; moves &= moves - 1) {
+    int piece{std::countr_zero(moves)};
+    typename R::State after{state};
+    R::roll(after, job.diceValue);
+    R::play(after, piece, job.diceValue);
+    if (rollout<R>(after) == state.currentPlayer)
+      job.moveWins[piece]++;
+  }
+}
+
+RolloutJob &makeJob(JobPool &spare, ThreadPool &pool, const GameState &state,
+                    int numPlayers, RuleSet rules, int diceValue,
+                    bool baseline) {
+  RolloutJob &job = spare.take();
+  job.pool = &pool;
+  job.state = state;
+  job.numPlayers = numPlayers;
+  job.rules = rules;
+  job.diceValue = diceValue;
+  job.baseline = baseline;
+  job.hasCached = false;
+  job.legal = 0;
+  if (diceValue > 0)
+    job.legal = withRules(numPlayers, rules, [&](auto tag) {
+      using R = decltype(tag);
+      typename R::State rolled{toState<R>(state)};
+      return R::roll(rolled, diceValue) ? R::legalMoves(rolled, diceValue)
+                                        : 0u;
+    });
+  return job;
+}
+
+void submitBatch(RolloutJob &job);
+
+void runBatch(RolloutJob &job) {
+  for (int round = 0; round < ROUNDS_PER_TASK && !job.cancelled &&
+                      job.rounds < MAX_ROUNDS;
+       round++) {
+    withRules(job.numPlayers, job.rules,
+              [&](auto tag) { playRound<decltype(tag)>(job); });
+    job.rounds++;
+  }
+  if (!job.cancelled && job.rounds < MAX_ROUNDS)
+    submitBatch(job);
+  job.batches--; // last, the job may be reused right after
+}
+
+void submitBatch(RolloutJob &job) {
+  job.batches++;
+  // a lone pointer is stored inside the std::function, no allocation
+  RolloutJob *batch{&job};
+  job.pool->submit([batch] { runBatch(*batch); });
+}
+
+void startJob(RolloutJob &job, size_t tasks) {
+  for (size_t i = 0; i < tasks; i++)
+    submitBatch(job);
+}
+
+} // namespace
+
+JobPool::JobPool(size_t reserved) : jobs() {
+  jobs.reserve(2 * reserved);
+  for (size_t i = 0; i < reserved; i++)
+    jobs.push_back(std::make_unique<RolloutJob>());
+}
+
+JobPool::~JobPool() { waitIdle(); }
+
+RolloutJob &JobPool::take() {
+  RolloutJob *job{nullptr};
+  for (const std::unique_ptr<RolloutJob> &candidate : jobs)
+    if (!candidate->owned && candidate->batches == 0) {
+      job = candidate.get();
+      break;
+    }
+  if (job == nullptr) {
+    // every job is still busy, only while the pool warms up
+    jobs.push_back(std::make_unique<RolloutJob>());
+    job = jobs.back().get();
+  }
+  job->owned = true;
+  job->cancelled = false;
+  job->rounds = 0;
+  for (int i = 0; i < 4; i++)
+    job->wins[i] = job->moveWins[i] = 0;
+  return *job;
+}
+
+void JobPool::release(RolloutJob *job) {
+  if (job == nullptr)
+    return;
+  job->cancelled = true;
+  job->owned = false;
+}
+
+void JobPool::waitIdle() {
+  for (const std::unique_ptr<RolloutJob> &job : jobs) {
+    job->cancelled = true;
+    while (job->batches > 0)
+      std::this_thread::sleep_for(1ms);
+  }
+}
+
+// at most one job runs and one winds down after being replaced
+WinEstimator::WinEstimator(ThreadPool &pool, RuleSet rules)
+    : pool(pool), rules(rules), mutex(), spare(4), job(nullptr) {}
+
+WinEstimator::~WinEstimator() { cancel(); }
+
+void WinEstimator::analyze(const GameState &state, int numPlayers,
+                           int diceValue) {
+  RolloutJob *next;
+  {
+    std::lock_guard lock(mutex);
+    spare.release(job);
+    next = job =
+        &makeJob(spare, pool, state, numPlayers, rules, diceValue, true);
+  }
+  startJob(*next, pool.size());
+}
+
+void WinEstimator::cancel() {
+  std::lock_guard lock(mutex);
+  spare.release(job);
+  job = nullptr;
+}
+
+// under the lock, the job could be reused while it is read otherwise
+Analysis WinEstimator::snapshot() const {
+  std::lock_guard lock(mutex);
+  Analysis analysis;
+  if (job == nullptr)
+    return analysis;
+  const long rounds{job->rounds};
+  analysis.numPlayers = job->numPlayers;
+  analysis.rollouts = rounds;
+  if (rounds == 0)
+    return analysis;
+  for (int seat = 0; seat < job->numPlayers; seat++)
+    analysis.winProbability[seat] =
+        job->wins[seat] / static_cast<float>(rounds);
+  analysis.legalMoves = job->legal;
+  const float now{analysis.winProbability[job->state.currentPlayer]};
+  for (int piece = 0; piece < 4; piece++)
+    if (job->legal & (1u << piece))
+      analysis.moveDelta[piece] =
+          job->moveWins[piece] / static_cast<float>(rounds) - now;
+  return analysis;
+}
+
+// six jobs per turn and the six of the turn before winding down
+SpeculativeSearch::SpeculativeSearch(ThreadPool &pool, RuleSet rules)
+    : pool(pool), rules(rules), mutex(), spare(18), jobs() {
+  jobs.fill(nullptr);
+}
+
+SpeculativeSearch::~SpeculativeSearch() { cancel(); }
+
+void SpeculativeSearch::startTurn(const GameState &state, int numPlayers) {
+  std::array<RolloutJob *, 6> next;
+  {
+    std::lock_guard lock(mutex);
+    for (RolloutJob *&job : jobs) {
+      spare.release(job);
+      job = nullptr;
+    }
+    for (int dice = 1; dice <= 6; dice++)
+      next[dice - 1] =
+          &makeJob(spare, pool, state, numPlayers, rules, dice, false);
+    jobs = next;
+  }
+  // spread the workers over the outcomes that have a choice to make,
+  // outcomes another table already searched are answered by the cache
+  const std::uint64_t stateHash{
+      EvaluationCache::hash(state, numPlayers, rules)};
+  for (RolloutJob *job : next) {
+    if (std::popcount(job->legal) <= 1)
+      continue;
+    job->hasCached =
+        EvaluationCache::shared().find(stateHash, job->diceValue,
+                                       job->cached) &&
+        (job->legal & (1u << job->cached.move));
+    if (!job->hasCached)
+      startJob(*job, std::max<size_t>(1, pool.size() / 3));
+  }
+}
+
+void SpeculativeSearch::focus(int diceValue) {
+  RolloutJob *job;
+  {
+    std::lock_guard lock(mutex);
+    for (int dice = 1; dice <= 6; dice++)
+      if (dice != diceValue && jobs[dice - 1] != nullptr)
+        jobs[dice - 1]->cancelled = true;
+    job = jobs.at(diceValue - 1);
+  }
+  if (job == nullptr || std::popcount(job->legal) <= 1)
+    return;
+  if (job->hasCached) {
+    job->cancelled = true;
+    return;
+  }
+  // the five cancelled jobs free their workers for this one
+  if (job->rounds < MIN_SEARCH_ROUNDS && !job->cancelled)
+    startJob(*job, pool.size());
+}
+
+bool SpeculativeSearch::ready(int diceValue) {
+  std::lock_guard lock(mutex);
+  const RolloutJob *job{jobs.at(diceValue - 1)};
+  return job == nullptr || std::popcount(job->legal) <= 1 ||
+         job->rounds >= MIN_SEARCH_ROUNDS || job->cancelled ||
+         job->hasCached;
+}
+
+int SpeculativeSearch::currentBest(int diceValue) {
+  RolloutJob *job;
+  {
+    std::lock_guard lock(mutex);
+    job = jobs.at(diceValue - 1);
+  }
+  if (job == nullptr || job->legal == 0)
+    return -1;
+  if (std::popcount(job->legal) == 1)
+    return std::countr_zero(job->legal);
+  if (job->hasCached)
+    return job->cached.move;
+  int best{-1};
+  long bestWins{-1};
+  for (unsigned moves = job->legal; moves != 0; moves &= moves - 1) {
+    int piece{std::countr_zero(moves)};
+    if (job->moveWins[piece] > bestWins)
+      best = piece, bestWins = job->moveWins[piece];
+  }
+  // only answers that had their full budget are worth sharing
+  const long rounds{job->rounds};
+  if (rounds >= MIN_SEARCH_ROUNDS)
+    EvaluationCache::shared().store(
+        EvaluationCache::hash(job->state, job->numPlayers, rules), diceValue,
+        {best, bestWins / static_cast<float>(rounds)});
+  return best;
+}
+
+int SpeculativeSearch::bestMove(int diceValue, int moveTimeMs) {
+  focus(diceValue);
+  auto deadline{std::chrono::steady_clock::now() +
+                std::chrono::milliseconds(moveTimeMs)};
+  while (!ready(diceValue) && std::chrono::steady_clock::now() < deadline)
+    std::this_thread::sleep_for(1ms);
+  return currentBest(diceValue);
+}
+
+void SpeculativeSearch::cancel() {
+  std::lock_guard lock(mutex);
+  for (RolloutJob *&job : jobs) {
+    spare.release(job);
+    job = nullptr;
+  }
+}
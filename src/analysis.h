@@ -0,0 +1,115 @@
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+
+#include "rules.h"
+#include "threadpool.h"
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace gamespace {
+
+/**
+ * @brief What the estimator knows so far about the position it was given.
+ */
+struct Analysis {
+  int numPlayers{0};
+  std::array<float, 4> winProbability{}; // by seat
+  // change of the mover's win probability for each of its pieces, only
+  // meaningful for the bits set in legalMoves
+  std::array<float, 4> moveDelta{};
+  unsigned legalMoves{0};
+  long rollouts{0};
+};
+
+struct RolloutJob;
+
+/**
+ * @brief Rollout jobs kept for reuse. A job goes back to work once its
+ * owner let go of it and none of its batches is queued or running, so
+ * after the first turns starting a search allocates nothing.
+ */
+class JobPool {
+public:
+  // an idle job with its counters cleared, owned until release()
+  RolloutJob &take();
+  void release(RolloutJob *job);
+  void waitIdle(); // every batch finished, the pool is about to go away
+
+private:
+  std::vector<std::unique_ptr<RolloutJob>> jobs;
+
+public:
+  explicit JobPool(size_t reserved);
+  ~JobPool();
+};
+
+/**
+ * @brief Monte Carlo win probabilities computed on a thread pool.
+ *
+ * analyze() cancels whatever was running and starts rollouts from the new
+ * position, snapshot() can be called every frame and returns an estimate
+ * that keeps refining until the rollout budget is spent.
+ */
+class WinEstimator {
+public:
+  // state as it was before the roll, diceValue is 0 while nobody rolled,
+  // rows past numPlayers are ignored
+  void analyze(const GameState &state, int numPlayers, int diceValue);
+  void cancel();
+  Analysis snapshot() const;
+
+private:
+  ThreadPool &pool;
+  RuleSet rules; // the rollouts play
+  mutable std::mutex mutex;
+  JobPool spare;
+  RolloutJob *job; // nullptr when cancelled
+
+public:
+  explicit WinEstimator(ThreadPool &pool, RuleSet rules = RuleSet::CLASSIC);
+  ~WinEstimator();
+};
+
+/**
+ * @brief Move search that starts before the dice is rolled.
+ *
+ * startTurn() launches rollouts for every piece under each of the six dice
+ * values. focus() keeps the job of the value that was actually rolled and
+ * cancels the five others, the answer is usually ready() right away.
+ * bestMove() does all of it and waits, callers that must not block poll
+ * ready() and take currentBest().
+ */
+class SpeculativeSearch {
+public:
+  // state waiting for its roll, rows past numPlayers are ignored
+  void startTurn(const GameState &state, int numPlayers);
+  // gives the job of the rolled value every worker when it needs them
+  void focus(int diceValue);
+  // enough rollouts are in, or no search was needed
+  bool ready(int diceValue);
+  // piece with the best win rate so far, -1 when nothing can move
+  int currentBest(int diceValue);
+  // focus, wait at most moveTimeMs for ready, currentBest
+  int bestMove(int diceValue, int moveTimeMs);
+  void cancel();
+
+private:
+  // jobs are reused, startTurn, bestMove and cancel must come from one
+  // thread
+  ThreadPool &pool;
+  RuleSet rules; // the rollouts play, cached moves are kept apart by it
+  std::mutex mutex;
+  JobPool spare;
+  std::array<RolloutJob *, 6> jobs; // by dice value - 1
+
+public:
+  explicit SpeculativeSearch(ThreadPool &pool,
+                             RuleSet rules = RuleSet::CLASSIC);
+  ~SpeculativeSearch();
+};
+
+} // namespace gamespace
+#endif
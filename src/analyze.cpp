@@ -0,0 +1,233 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "board.h"
+#include "gamelog.h"
+#include "rules.h"
+#include "view.h"
+
+using namespace gamespace;
+
+// games longer than this land in the last bucket of the turn histogram
+static const int MAX_TURNS{1000};
+// chunks per thread, small enough that a thread finishing early steals work
+static const size_t CHUNKS_PER_THREAD{16};
+
+static void printUsage(const char *program) {
+  std::cerr << "usage: " << program
+            << " <game log>... [--threads <n>] [--out <prefix>]\n";
+}
+
+/**
+ * Everything counted over the logs, one per thread and merged at the end.
+ */
+struct Totals {
+  std::array<long, NUM_POSITIONS> landings{};
+  std::array<long, NUM_POSITIONS> captures{};
+  // by RuleSet and player count, wins also by seat
+  std::array<std::array<long, 5>, NUM_RULE_SETS> games{};
+  std::array<std::array<long, 5>, NUM_RULE_SETS> unfinished{};
+  std::array<std::array<std::array<long, 4>, 5>, NUM_RULE_SETS> wins{};
+  std::vector<long> turns = std::vector<long>(MAX_TURNS + 1, 0);
+  long corrupted{0};
+
+  void add(const Totals &other) {
+    for (int p = 0; p < NUM_POSITIONS; p++) {
+      landings[p] += other.landings[p];
+      captures[p] += other.captures[p];
+    }
+    for (int rules = 0; rules < NUM_RULE_SETS; rules++)
+      for (int n = 0; n < 5; n++) {
+        games[rules][n] += other.games[rules][n];
+        unfinished[rules][n] += other.unfinished[rules][n];
+        for (int seat = 0; seat < 4; seat++)
+          wins[rules][n][seat] += other.wins[rules][n][seat];
+      }
+    for (int t = 0; t <= MAX_TURNS; t++)
+      turns[t] += other.turns[t];
+    corrupted += other.corrupted;
+  }
+};
+
+/**
+ * Counts the games that start in [begin, end), the last one may run past
+ * end up to limit. A chunk that starts inside a game skips to the next
+ * START, that game belongs to the previous chunk.
+ */
+static void scanChunk(const GameRecord *begin, const GameRecord *end,
+                      const GameRecord *limit, Totals &totals) {
+  const GameRecord *r{begin};
+  while (r < end && r->type != GameRecord::START)
+    r++;
+  while (r < end) {
+    const int numPlayers{r->seat};
+    const bool knownRules{r->knownRules()};
+    const int rules{static_cast<int>(r->rules())};
+    r++;
+    int seat{-1}, turns{0};
+    while (r < limit && r->type == GameRecord::ROLL) {
+      if (r->seat != seat)
+        seat = r->seat, turns++;
+      if (r->moved() && r->destination < NUM_POSITIONS) {
+        totals.landings[r->destination]++;
+        if (r->captured())
+          totals.captures[r->destination]++;
+      }
+      r++;
+    }
+    if (r == limit || r->type != GameRecord::END || numPlayers < 2 ||
+        numPlayers > 4 || !knownRules) {
+      totals.corrupted++;
+    } else {
+      totals.games[rules][numPlayers]++;
+      if (r->seat < numPlayers)
+        totals.wins[rules][numPlayers][r->seat]++;
+      else
+        totals.unfinished[rules][numPlayers]++;
+      totals.turns[std::min(turns, MAX_TURNS)]++;
+      r++;
+    }
+    while (r < end && r->type != GameRecord::START)
+      r++;
+  }
+}
+
+static void scanLog(const GameLog &log, unsigned numThreads, Totals &totals) {
+  const size_t numChunks{numThreads * CHUNKS_PER_THREAD};
+  const size_t chunkSize{std::max<size_t>(1, log.size() / numChunks + 1)};
+  std::atomic<size_t> nextChunk{0};
+  std::vector<Totals> partial(numThreads);
+  std::vector<std::thread> workers;
+  for (unsigned t = 0; t < numThreads; t++)
+    workers.emplace_back([&, t] {
+      for (size_t chunk = nextChunk++; chunk * chunkSize < log.size();
+           chunk = nextChunk++) {
+        const GameRecord *begin{log.begin() + chunk * chunkSize};
+        const GameRecord *end{
+            std::min(begin + chunkSize, log.begin() + log.size())};
+        scanChunk(begin, end, log.end(), partial[t]);
+      }
+    });
+  for (std::thread &worker : workers)
+    worker.join();
+  for (const Totals &p : partial)
+    totals.add(p);
+}
+
+static bool writeCsv(const std::string &prefix, const Totals &totals) {
+  std::ofstream positions(prefix + "positions.csv");
+  positions << "position,x,y,protected,landings,captures\n";
+  for (int p = 0; p < NUM_POSITIONS; p++) {
+    auto [x, y] = BoardPosition::toXYOffset(p);
+    positions << p << ',' << x << ',' << y << ','
+              << detail::isProtectedSquare(p) << ',' << totals.landings[p]
+              << ',' << totals.captures[p] << '\n';
+  }
+  std::ofstream summary(prefix + "summary.csv");
+  summary << "rules,players,games,unfinished,seat0,seat1,seat2,seat3\n";
+  for (int rules = 0; rules < NUM_RULE_SETS; rules++)
+    for (int n = 2; n <= 4; n++) {
+      if (totals.games[rules][n] == 0)
+        continue;
+      summary << ruleSetName(static_cast<RuleSet>(rules)) << ',' << n << ','
+              << totals.games[rules][n] << ','
+              << totals.unfinished[rules][n];
+      for (int seat = 0; seat < 4; seat++)
+        summary << ',' << totals.wins[rules][n][seat];
+      summary << '\n';
+    }
+  std::ofstream turns(prefix + "turns.csv");
+  turns << "turns,games\n";
+  for (int t = 0; t <= MAX_TURNS; t++)
+    if (totals.turns[t] != 0)
+      turns << t << ',' << totals.turns[t] << '\n';
+  if (!positions || !summary || !turns) {
+    (std::cerr << "Could not write the csv files\n").flush();
+    return false;
+  }
+  return true;
+}
+
+// board with every square shaded by its share of the busiest one
+static bool drawHeatmap(View &view,
+                        const std::array<long, NUM_POSITIONS> &counts,
+                        const std::string &path) {
+  view.drawBoard();
+  const long most{std::max(1L, *std::max_element(counts.begin(),
+                                                 counts.begin() + 76))};
+  const int ts{view.getLayout().tileSize};
+  for (int p = 0; p < 76; p++) { // jail squares are never landed on
+    auto [x, y] = BoardPosition::toXYOffset(p);
+    view.drawHeat(x * ts, y * ts, static_cast<float>(counts[p]) / most);
+  }
+  return view.saveImage(path.c_str());
+}
+
+int main(int argc, char *argv[]) {
+  std::vector<std::string> paths;
+  unsigned threads{std::max(1u, std::thread::hardware_concurrency())};
+  std::string prefix{"ludo_"};
+  for (int i = 1; i < argc; i++) {
+    std::string arg{argv[i]};
+    if (arg == "--threads" && i + 1 < argc)
+      threads = std::max(1, std::atoi(argv[++i]));
+    else if (arg == "--out" && i + 1 < argc)
+      prefix = argv[++i];
+    else if (!arg.starts_with("--"))
+      paths.push_back(arg);
+    else
+      return printUsage(argv[0]), 1;
+  }
+  if (paths.empty())
+    return printUsage(argv[0]), 1;
+
+  Totals totals;
+  for (const std::string &path : paths) {
+    GameLog log;
+    if (!log.open(path))
+      return 1;
+    scanLog(log, threads, totals);
+  }
+
+  long games{0}, landings{0}, protectedLandings{0};
+  for (int rules = 0; rules < NUM_RULE_SETS; rules++)
+    for (int n = 2; n <= 4; n++) {
+      games += totals.games[rules][n];
+      if (totals.games[rules][n] == 0)
+        continue;
+      const long finished{totals.games[rules][n] -
+                          totals.unfinished[rules][n]};
+      std::cout << n << " players, "
+                << ruleSetName(static_cast<RuleSet>(rules))
+                << " rules: " << totals.games[rules][n]
+                << " games, seat 0 wins "
+                << 100.0 * totals.wins[rules][n][0] / std::max(1L, finished)
+                << "% (fair share " << 100.0 / n << "%)\n";
+    }
+  for (int p = 0; p < NUM_POSITIONS; p++) {
+    landings += totals.landings[p];
+    if (detail::isProtectedSquare(p))
+      protectedLandings += totals.landings[p];
+  }
+  std::cout << games << " games, "
+            << 100.0 * protectedLandings / std::max(1L, landings)
+            << "% of the moves end on a protected square";
+  if (totals.corrupted != 0)
+    std::cout << ", " << totals.corrupted << " damaged games skipped";
+  std::cout << "\n";
+
+  if (!writeCsv(prefix, totals))
+    return 1;
+  View view(true);
+  if (!drawHeatmap(view, totals.captures, prefix + "captures.png") ||
+      !drawHeatmap(view, totals.landings, prefix + "landings.png"))
+    return 1;
+  return 0;
+}
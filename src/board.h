@@ -0,0 +1,118 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <array>
+#include <ostream>
+#include <random>
+#include <utility>
+
+namespace gamespace {
+
+class BoardPosition;
+
+class Player {
+  /**
+   * @brief Player representation class ... done
+   *
+   */
+public:
+  enum PlayerType { HUMAN, ROBOT };
+  enum PlayerColor {
+    RED = 0,
+    GREEN = 1,
+    YELLOW = 2,
+    BLUE = 3
+  }; // order of play on the board
+  PlayerType type;
+  PlayerColor color; // used as an id field
+  const std::array<int, 4> &getJailPositions() const;
+  // just used to satisfy defaultConstructible in 0 length
+  // std::vector::constructor--(4)
+  Player(PlayerType type = ROBOT, PlayerColor color = RED)
+      : type(type), color(color) {}
+  ~Player() = default;
+  friend std::ostream &operator<<(std::ostream &os, const Player &p);
+};
+
+std::ostream &operator<<(std::ostream &os, const Player &p);
+std::ostream &operator<<(std::ostream &os, const Player::PlayerColor &c);
+std::ostream &operator<<(std::ostream &os, const Player::PlayerType &t);
+
+class BoardPosition {
+  /**
+   * @brief Board position representation class ... done
+   *
+   */
+public:
+  int pos;
+  static int getNext(int pos, const Player::PlayerColor &color);
+  BoardPosition(int position = 0);
+  constexpr bool isInitialPosition() const {
+    // stuck on square
+    return pos >= 76 && pos <= 91;
+  }
+  static int defaultPosition(const Player::PlayerColor &color);
+  static std::pair<int, int> toXYOffset(int pos);
+  std::pair<int, int> toXYOffset() const;
+  static constexpr bool isFinalPosition(int position) {
+    return position == 69 || position == 63 || position == 75 ||
+           position == 57;
+  }
+  constexpr bool isFinalPosition() const { return isFinalPosition(pos); }
+  static BoardPosition fromScreenFloats(float x, float y);
+  friend std::ostream &operator<<(std::ostream &os, const BoardPosition &p);
+  bool isProtectedPosition() const;
+
+private:
+  static int toPositionId(int x, int y);         // from x, y offsets
+  static BoardPosition toPosition(int x, int y); // from x, y offsets
+};
+
+constexpr bool operator==(const BoardPosition &a, const BoardPosition &b) {
+  return a.pos == b.pos;
+}
+std::ostream &operator<<(std::ostream &os, const BoardPosition &p);
+
+class Piece {
+  /**
+   * @brief  ... done
+   *
+   */
+private:
+  Player _player;
+
+public:
+  BoardPosition pos;
+  bool canAdvance(int diceValue) const;
+  void advance(int diceValue);
+  Player::PlayerColor getColor() const { return _player.color; };
+  /**
+   * @brief TODO: set position later depending on other similar colored pieces
+   * @param p
+   */
+  // just used to satisfy defaultConstructible in 0 length
+  // std::vector::constructor--(4)
+  Piece(const Player &player = defaultPlayer,
+        const BoardPosition &position = BoardPosition(0))
+      : _player(player), pos(position) {}
+  static const Player defaultPlayer;
+  friend std::ostream &operator<<(std::ostream &os, Piece const &p);
+};
+
+std::ostream &operator<<(std::ostream &os, Piece const &p);
+
+class Dice {
+public:
+  int roll() { return value = dist(rd); }
+
+private:
+  std::random_device rd;
+  std::uniform_int_distribution<int> dist;
+
+public:
+  int value;
+  Dice() : rd(), dist(1, 6), value(6) {} // TODO: change to -1 later
+  ~Dice() = default;
+};
+} // namespace gamespace
+#endif
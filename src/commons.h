@@ -1,12 +1,9 @@
 #ifndef COMMONS_H
 #define COMMONS_H
 namespace gamespace {
-void syncSizes(int w, int h);
 
-// width and height at the same time
-extern int WINDOW_SIZE; // is divisible by 15 ... :)
-extern int TS;
-extern int TSmall;
+// width and height of a new window, the layout follows its real size
+static const int WINDOW_SIZE{810}; // is divisible by 15 ... :)
 
 static const int NUM_POSITIONS{92};
 
@@ -0,0 +1,110 @@
+#include "config.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace gamespace;
+
+static int seatFromName(const std::string &name) {
+  if (name == "red")
+    return 0;
+  if (name == "green")
+    return 1;
+  if (name == "yellow")
+    return 2;
+  if (name == "blue")
+    return 3;
+  return -1;
+}
+
+static void printUsage(const char *program) {
+  std::cerr << "usage: " << program
+            << " [--engine <red|green|yellow|blue>=<command>]..."
+               " [--bot <red|green|yellow|blue>]... [--movetime <ms>]"
+               " [--players 2|3|4] [--rules classic|house] [--analysis]"
+               " [--hints] [--headless]"
+               " [--thumbnail <png>] [--renderer sdl|software]"
+               " [--check-allocations <turns>] [--latency]"
+               " [--warp <factor>|max] [--journal <file>]"
+               " [--model <network>] [--spectate <port>]\n";
+}
+
+GameConfig gamespace::parseArguments(int argc, char *argv[]) {
+  GameConfig config;
+  for (int i = 1; i < argc; i++) {
+    std::string arg{argv[i]};
+    if (arg == "--engine" && i + 1 < argc) {
+      std::string value{argv[++i]};
+      size_t separator{value.find('=')};
+      int seat{separator == std::string::npos
+                   ? -1
+                   : seatFromName(value.substr(0, separator))};
+      if (seat < 0) {
+        std::cerr << "Invalid engine seat [" << value << "]\n";
+        continue;
+      }
+      config.engines[seat] = value.substr(separator + 1);
+    } else if (arg == "--bot" && i + 1 < argc) {
+      int seat{seatFromName(argv[++i])};
+      if (seat < 0) {
+        std::cerr << "Invalid bot seat [" << argv[i] << "]\n";
+        continue;
+      }
+      config.bots[seat] = true;
+    } else if (arg == "--movetime" && i + 1 < argc) {
+      config.moveTimeMs = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--players" && i + 1 < argc) {
+      config.numPlayers = std::clamp(std::atoi(argv[++i]), 2, 4);
+    } else if (arg == "--rules" && i + 1 < argc) {
+      std::string name{argv[++i]};
+      if (name != "classic" && name != "house") {
+        std::cerr << "Invalid rules [" << name << "]\n";
+        continue;
+      }
+      config.rules = name == "house" ? RuleSet::HOUSE : RuleSet::CLASSIC;
+    } else if (arg == "--analysis") {
+      config.showAnalysis = true;
+    } else if (arg == "--hints") {
+      config.hints = true;
+    } else if (arg == "--headless") {
+      config.headless = true;
+    } else if (arg == "--thumbnail" && i + 1 < argc) {
+      config.thumbnailPath = argv[++i];
+    } else if (arg == "--renderer" && i + 1 < argc) {
+      std::string name{argv[++i]};
+      if (name != "sdl" && name != "software") {
+        std::cerr << "Invalid renderer [" << name << "]\n";
+        continue;
+      }
+      config.softwareRenderer = name == "software";
+    } else if (arg == "--check-allocations" && i + 1 < argc) {
+      config.checkAllocationTurns = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--latency") {
+      config.measureLatency = true;
+    } else if (arg == "--warp" && i + 1 < argc) {
+      std::string value{argv[++i]};
+      const double factor{value == "max" ? 0 : std::atof(value.c_str())};
+      if (value != "max" && !(factor > 0)) {
+        std::cerr << "Invalid time warp [" << value << "]\n";
+        continue;
+      }
+      config.timeWarp = factor;
+    } else if (arg == "--journal" && i + 1 < argc) {
+      config.journalPath = argv[++i];
+    } else if (arg == "--model" && i + 1 < argc) {
+      config.modelPath = argv[++i];
+    } else if (arg == "--spectate" && i + 1 < argc) {
+      const int port{std::atoi(argv[++i])};
+      if (port <= 0 || port > 65535) {
+        std::cerr << "Invalid spectator port [" << argv[i] << "]\n";
+        continue;
+      }
+      config.spectatePort = port;
+    } else {
+      printUsage(argv[0]);
+    }
+  }
+  return config;
+}
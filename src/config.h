@@ -0,0 +1,48 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include "rules.h"
+
+#include <array>
+#include <string>
+
+namespace gamespace {
+
+/**
+ * @brief Startup configuration, filled from the command line.
+ */
+struct GameConfig {
+  // one shell command per seat (RED, GREEN, YELLOW, BLUE), an empty command
+  // means the seat is played by a human
+  std::array<std::string, 4> engines;
+  // seats played by the built in search, by color
+  std::array<bool, 4> bots{};
+  int moveTimeMs{1000};
+  int numPlayers{4}; // 2 players sit at opposite corners (red and yellow)
+  RuleSet rules{RuleSet::CLASSIC}; // the variant every move is played by
+  bool showAnalysis{false}; // win probability overlay
+  bool hints{false};        // H suggests a move to human seats
+  // no display: offscreen video driver, software renderer, no sound
+  bool headless{false};
+  std::string thumbnailPath; // PNG of the board rewritten after every move
+  bool softwareRenderer{false}; // draw into our own framebuffer, see raster.h
+  // turns to count heap allocations over after warming up, then quit,
+  // 0 for a normal game, see alloccount.h
+  int checkAllocationTurns{0};
+  // input to present percentiles on screen and at exit, see latency.h
+  bool measureLatency{false};
+  // bot games only: how many times faster than real time turns are played,
+  // 0 for as fast as the bots decide, see Game::playTurns
+  double timeWarp{1};
+  // game in progress restored from and recorded to, see journal.h
+  std::string journalPath;
+  // --bot seats pick with this network instead of searching, see network.h
+  std::string modelPath;
+  // TCP port spectators connect to, 0 for none, see spectate.h
+  int spectatePort{0};
+};
+
+GameConfig parseArguments(int argc, char *argv[]);
+
+} // namespace gamespace
+#endif
@@ -4,21 +4,23 @@
 
 using namespace gamespace;
 
-Controller::Controller() {}
+Controller::Controller(const GameConfig &config)
+    : scheduler(), model(scheduler, config) {}
 
 bool Controller::startMainLoop() {
   bool done{false};
   SDL_Event event;
-  while (!done) {
+  while (!done && !model.finished()) {
     while (SDL_PollEvent(&event)) {
       if (event.type == SDL_EVENT_QUIT)
         done = true;
       else
         model.handleEvent(event);
     }
+    scheduler.run();
     model.render();
   }
-  return true;
+  return model.reportAllocations();
 }
 
 Controller::~Controller(){}
\ No newline at end of file
@@ -9,10 +9,11 @@ public:
   bool startMainLoop();
 
 private:
+  Scheduler scheduler; // drives the game's turns, see Game::playTurns
   Game model;
 
 public:
-  Controller();
+  Controller(const GameConfig &config = GameConfig());
   ~Controller();
 };
 
@@ -0,0 +1,275 @@
+#include "engine.h"
+#include "log.h"
+
+#include <algorithm>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sstream>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace gamespace;
+using namespace std::literals;
+
+// time an engine gets to answer the handshake
+static const int HANDSHAKE_TIMEOUT_MS{5000};
+
+EngineProcess::EngineProcess(const std::string &command)
+    : command(command), pid(-1), toEngine(-1), fromEngine(-1), nextId(0),
+      readBuffer(), pending(), answers(), stats() {}
+
+EngineProcess::~EngineProcess() {
+  if (stats.requests > 0)
+    LOG_INFO("Engine [%s] requests %ld, timeouts %ld, errors %ld, mean %gms, "
+             "max %gms",
+             command.c_str(), stats.requests, stats.timeouts, stats.errors,
+             stats.totalMs / std::max(1L, stats.requests - stats.timeouts),
+             stats.maxMs);
+  stop();
+}
+
+bool EngineProcess::start() {
+  if (isAlive())
+    return true;
+  int hostToEngine[2], engineToHost[2];
+  if (pipe(hostToEngine) != 0) {
+    LOG_ERROR("Could not create engine pipe [%s]", strerror(errno));
+    return false;
+  }
+  if (pipe(engineToHost) != 0) {
+    LOG_ERROR("Could not create engine pipe [%s]", strerror(errno));
+    close(hostToEngine[0]), close(hostToEngine[1]);
+    return false;
+  }
+  pid = fork();
+  if (pid < 0) {
+    LOG_ERROR("Could not fork engine [%s]", strerror(errno));
+    close(hostToEngine[0]), close(hostToEngine[1]);
+    close(engineToHost[0]), close(engineToHost[1]);
+    return false;
+  }
+  if (pid == 0) {
+    dup2(hostToEngine[0], STDIN_FILENO);
+    dup2(engineToHost[1], STDOUT_FILENO);
+    close(hostToEngine[0]), close(hostToEngine[1]);
+    close(engineToHost[0]), close(engineToHost[1]);
+    execl("/bin/sh", "sh", "-c", command.c_str(), static_cast<char *>(nullptr));
+    _exit(127);
+  }
+  close(hostToEngine[0]), close(engineToHost[1]);
+  toEngine = hostToEngine[1];
+  fromEngine = engineToHost[0];
+  fcntl(fromEngine, F_SETFL, fcntl(fromEngine, F_GETFL) | O_NONBLOCK);
+
+  if (!writeLine("ludo") || !waitForLine("ludook", HANDSHAKE_TIMEOUT_MS)) {
+    LOG_ERROR("Engine [%s] did not answer the handshake", command.c_str());
+    stop();
+    return false;
+  }
+  return true;
+}
+
+bool EngineProcess::newGame() {
+  pending.clear();
+  answers.clear();
+  return writeLine("newgame");
+}
+
+int EngineProcess::send(const EngineRequest &request) {
+  if (!isAlive() && !start())
+    return -1;
+  int id{nextId++};
+  std::ostringstream line;
+  line << "go " << id << " player " << request.player << " dice "
+       << request.diceValue << " pieces";
+  for (int position : request.positions)
+    line << ' ' << position;
+  line << " movetime " << request.moveTimeMs;
+  if (!writeLine(line.str()))
+    return -1;
+  pending[id] = Clock::now();
+  stats.requests++;
+  return id;
+}
+
+int EngineProcess::await(int id, int timeoutMs) {
+  if (!pending.contains(id) && !answers.contains(id))
+    return -1;
+  Clock::time_point deadline{Clock::now() +
+                             std::chrono::milliseconds(timeoutMs)};
+  while (!answers.contains(id)) {
+    auto remaining{std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - Clock::now())};
+    if (remaining <= 0ms || !isAlive()) {
+      pending.erase(id);
+      stats.timeouts++;
+      return -1;
+    }
+    readLines(static_cast<int>(remaining.count()));
+  }
+  int move{answers.at(id)};
+  answers.erase(id);
+  return move;
+}
+
+bool EngineProcess::answered(int id) {
+  if (!answers.contains(id) && pending.contains(id))
+    readLines(0);
+  return answers.contains(id) || !pending.contains(id) || !isAlive();
+}
+
+int EngineProcess::bestMove(const EngineRequest &request) {
+  int id{send(request)};
+  if (id < 0)
+    return -1;
+  return await(id, request.moveTimeMs + MOVE_TIME_SLACK_MS);
+}
+
+bool EngineProcess::writeLine(const std::string &line) {
+  if (toEngine < 0)
+    return false;
+  std::string buffer{line + '\n'};
+  const char *data{buffer.data()};
+  size_t left{buffer.size()};
+  while (left > 0) {
+    ssize_t written{write(toEngine, data, left)};
+    if (written < 0) {
+      if (errno == EINTR)
+        continue;
+      LOG_ERROR("Engine [%s] write error [%s]", command.c_str(),
+                strerror(errno));
+      stop();
+      return false;
+    }
+    data += written, left -= written;
+  }
+  return true;
+}
+
+bool EngineProcess::readLines(int timeoutMs) {
+  if (fromEngine < 0)
+    return false;
+  pollfd pfd{fromEngine, POLLIN, 0};
+  if (poll(&pfd, 1, timeoutMs) <= 0)
+    return false;
+  char chunk[4096];
+  ssize_t n{read(fromEngine, chunk, sizeof(chunk))};
+  if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+    LOG_ERROR("Engine [%s] exited", command.c_str());
+    stop();
+    return false;
+  }
+  if (n < 0)
+    return false;
+  readBuffer.append(chunk, n);
+  size_t end;
+  while ((end = readBuffer.find('\n')) != std::string::npos) {
+    std::string line{readBuffer.substr(0, end)};
+    readBuffer.erase(0, end + 1);
+    if (!line.empty() && line.back() == '\r')
+      line.pop_back();
+    handleLine(line);
+  }
+  return true;
+}
+
+void EngineProcess::handleLine(const std::string &line) {
+  std::istringstream tokens{line};
+  std::string keyword;
+  tokens >> keyword;
+  if (keyword != "bestmove")
+    return; // info lines and the like are ignored
+  int id, move;
+  if (!(tokens >> id >> move)) {
+    stats.errors++;
+    return;
+  }
+  if (!pending.contains(id))
+    return; // answer to a request that already timed out
+  double ms{std::chrono::duration<double, std::milli>(Clock::now() -
+                                                      pending.at(id))
+                .count()};
+  stats.totalMs += ms;
+  stats.maxMs = std::max(stats.maxMs, ms);
+  pending.erase(id);
+  answers[id] = move;
+}
+
+bool EngineProcess::waitForLine(const std::string &expected, int timeoutMs) {
+  Clock::time_point deadline{Clock::now() +
+                             std::chrono::milliseconds(timeoutMs)};
+  while (Clock::now() < deadline) {
+    size_t end{readBuffer.find('\n')};
+    if (end != std::string::npos) {
+      std::string line{readBuffer.substr(0, end)};
+      readBuffer.erase(0, end + 1);
+      if (!line.empty() && line.back() == '\r')
+        line.pop_back();
+      if (line == expected)
+        return true;
+      continue;
+    }
+    if (fromEngine < 0)
+      return false;
+    pollfd pfd{fromEngine, POLLIN, 0};
+    if (poll(&pfd, 1, 10) <= 0)
+      continue;
+    char chunk[4096];
+    ssize_t n{read(fromEngine, chunk, sizeof(chunk))};
+    if (n == 0)
+      return false;
+    if (n > 0)
+      readBuffer.append(chunk, n);
+  }
+  return false;
+}
+
+void EngineProcess::stop() {
+  if (pid <= 0)
+    return;
+  if (toEngine >= 0) {
+    static const char quit[]{"quit\n"};
+    [[maybe_unused]] ssize_t ignored{write(toEngine, quit, sizeof(quit) - 1)};
+    close(toEngine);
+  }
+  if (fromEngine >= 0)
+    close(fromEngine);
+  toEngine = fromEngine = -1;
+  // give the engine a moment to leave on its own before killing it
+  for (int i = 0; i < 20; i++) {
+    if (waitpid(pid, nullptr, WNOHANG) == pid) {
+      pid = -1;
+      return;
+    }
+    std::this_thread::sleep_for(10ms);
+  }
+  kill(pid, SIGKILL);
+  waitpid(pid, nullptr, 0);
+  pid = -1;
+}
+
+EnginePool::EnginePool() : engines() {
+  // a dead engine must not take the whole game down with it
+  std::signal(SIGPIPE, SIG_IGN);
+}
+
+EnginePool::~EnginePool() {}
+
+EnginePool &EnginePool::shared() {
+  static EnginePool pool;
+  return pool;
+}
+
+EngineProcess *EnginePool::get(const std::string &command) {
+  if (command.empty())
+    return nullptr;
+  if (!engines.contains(command)) {
+    engines[command] = std::make_unique<EngineProcess>(command);
+    if (!engines.at(command)->start())
+      LOG_ERROR("Could not start engine [%s]", command.c_str());
+  }
+  return engines.at(command).get();
+}
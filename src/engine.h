@@ -0,0 +1,97 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <sys/types.h>
+#include <unordered_map>
+
+namespace gamespace {
+
+/**
+ * @brief Everything an external bot needs to pick a move.
+ * positions holds the 16 BoardPosition ids, 4 per color in color order.
+ */
+struct EngineRequest {
+  int player;
+  int diceValue;
+  std::array<int, 16> positions;
+  int moveTimeMs;
+};
+
+/**
+ * @brief One external bot process talking the line based ludo protocol.
+ *
+ * host   -> engine : ludo
+ * engine -> host   : ludook
+ * host   -> engine : newgame
+ * host   -> engine : go <id> player <c> dice <d> pieces <16 ids> movetime <ms>
+ * engine -> host   : bestmove <id> <piece index 0-3>
+ * host   -> engine : quit
+ *
+ * Requests carry an id so several of them can be in flight at once, answers
+ * to requests that already timed out are dropped.
+ */
+class EngineProcess {
+public:
+  // how late an answer may be past the move time, pipe and scheduling
+  // overhead
+  static constexpr int MOVE_TIME_SLACK_MS{50};
+  struct Stats {
+    long requests{0}, timeouts{0}, errors{0};
+    double totalMs{0}, maxMs{0};
+  };
+  bool start();
+  bool isAlive() const { return pid > 0; }
+  bool newGame();
+  int send(const EngineRequest &request); // returns the request id or -1
+  int await(int id, int timeoutMs);       // piece index or -1 on timeout
+  // reads what the engine sent so far without waiting, true once await(id,
+  // 0) has nothing left to wait for
+  bool answered(int id);
+  int bestMove(const EngineRequest &request);
+  const Stats &getStats() const { return stats; }
+  const std::string &getCommand() const { return command; }
+
+private:
+  using Clock = std::chrono::steady_clock;
+  std::string command;
+  pid_t pid;
+  int toEngine, fromEngine;
+  int nextId;
+  std::string readBuffer;
+  std::unordered_map<int, Clock::time_point> pending;
+  std::unordered_map<int, int> answers;
+  Stats stats;
+  bool writeLine(const std::string &line);
+  bool readLines(int timeoutMs);
+  void handleLine(const std::string &line);
+  bool waitForLine(const std::string &expected, int timeoutMs);
+  void stop();
+
+public:
+  explicit EngineProcess(const std::string &command);
+  ~EngineProcess();
+  EngineProcess(const EngineProcess &) = delete;
+  EngineProcess &operator=(const EngineProcess &) = delete;
+};
+
+/**
+ * @brief Keeps engine processes alive for the whole program, games ask the
+ * pool instead of spawning their own so engines survive between games.
+ */
+class EnginePool {
+public:
+  static EnginePool &shared();
+  EngineProcess *get(const std::string &command);
+
+private:
+  std::unordered_map<std::string, std::unique_ptr<EngineProcess>> engines;
+  EnginePool();
+  ~EnginePool();
+};
+
+} // namespace gamespace
+#endif
@@ -0,0 +1,138 @@
+#include "environment.h"
+
+#include <algorithm>
+#include <bit>
+
+using namespace gamespace;
+
+BatchedEnvironment::BatchedEnvironment(size_t batchSize, unsigned numThreads,
+                                       std::uint64_t seed)
+    : states(batchSize), diceValues(batchSize, 0), generators(), workers(),
+      mutex(), wakeUp(), finished(), generation(0), busyWorkers(0),
+      stopping(false), resetting(false), buffers() {
+  generators.reserve(batchSize);
+  std::seed_seq seeds{static_cast<std::uint32_t>(seed),
+                      static_cast<std::uint32_t>(seed >> 32)};
+  std::vector<std::uint32_t> gameSeeds(batchSize);
+  seeds.generate(gameSeeds.begin(), gameSeeds.end());
+  for (std::uint32_t gameSeed : gameSeeds)
+    generators.emplace_back(gameSeed);
+  numThreads = std::clamp<unsigned>(numThreads, 1,
+                                    std::max<size_t>(1, batchSize));
+  // the calling thread runs slice 0 itself
+  for (size_t slice = 1; slice < numThreads; slice++)
+    workers.emplace_back(&BatchedEnvironment::workerLoop, this, slice);
+}
+
+BatchedEnvironment::~BatchedEnvironment() {
+  {
+    std::lock_guard lock(mutex);
+    stopping = true;
+  }
+  wakeUp.notify_all();
+  for (std::thread &worker : workers)
+    worker.join();
+}
+
+void BatchedEnvironment::reset(float *observations,
+                               std::uint8_t *actionMasks) {
+  runBatch(true, {nullptr, observations, actionMasks, nullptr, nullptr});
+}
+
+void BatchedEnvironment::step(const std::int32_t *actions, float *observations,
+                              std::uint8_t *actionMasks, float *rewards,
+                              std::uint8_t *dones) {
+  runBatch(false, {actions, observations, actionMasks, rewards, dones});
+}
+
+void BatchedEnvironment::runBatch(bool reset, const Buffers &b) {
+  {
+    std::lock_guard lock(mutex);
+    resetting = reset;
+    buffers = b;
+    busyWorkers = workers.size();
+    generation++;
+  }
+  wakeUp.notify_all();
+  runSlice(0);
+  std::unique_lock lock(mutex);
+  finished.wait(lock, [this] { return busyWorkers == 0; });
+}
+
+void BatchedEnvironment::workerLoop(size_t slice) {
+  unsigned long seen{0};
+  while (true) {
+    {
+      std::unique_lock lock(mutex);
+      wakeUp.wait(lock, [&] { return stopping || generation != seen; });
+      if (stopping)
+        return;
+      seen = generation;
+    }
+    runSlice(slice);
+    std::lock_guard lock(mutex);
+    if (--busyWorkers == 0)
+      finished.notify_one();
+  }
+}
+
+void BatchedEnvironment::runSlice(size_t slice) {
+  const size_t numSlices{workers.size() + 1};
+  const size_t begin{states.size() * slice / numSlices};
+  const size_t end{states.size() * (slice + 1) / numSlices};
+  for (size_t game = begin; game < end; game++) {
+    if (resetting) {
+      resetGame(game);
+      writeOutputs(game, buffers);
+      continue;
+    }
+    GameState &state{states[game]};
+    const int dice{diceValues[game]};
+    const unsigned legal{Rules::legalMoves(state, dice)};
+    int piece{buffers.actions[game]};
+    if (piece < 0 || piece >= NUM_ACTIONS || !(legal & (1u << piece)))
+      piece = std::countr_zero(legal);
+    Rules::play(state, piece, dice);
+    const bool done{Rules::isOver(state)};
+    buffers.rewards[game] = done ? 1.0f : 0.0f;
+    buffers.dones[game] = done;
+    if (done)
+      resetGame(game);
+    else
+      rollUntilDecision(game);
+    writeOutputs(game, buffers);
+  }
+}
+
+void BatchedEnvironment::resetGame(size_t game) {
+  Rules::reset(states[game]);
+  rollUntilDecision(game);
+}
+
+void BatchedEnvironment::rollUntilDecision(size_t game) {
+  std::uniform_int_distribution<int> dist(1, 6);
+  while (true) {
+    int dice{dist(generators[game])};
+    if (Rules::roll(states[game], dice)) {
+      diceValues[game] = dice;
+      return;
+    }
+  }
+}
+
+void BatchedEnvironment::writeOutputs(size_t game, const Buffers &b) {
+  const GameState &state{states[game]};
+  float *observation{b.observations + game * OBSERVATION_SIZE};
+  for (int seat = 0; seat < Rules::NUM_PLAYERS; seat++) {
+    int other{(state.currentPlayer + seat) % Rules::NUM_PLAYERS};
+    for (int i = 0; i < Rules::PIECES_PER_COLOR; i++)
+      *observation++ = Rules::progress(other, state.pieces[other][i]) /
+                       static_cast<float>(Rules::FINAL_PROGRESS);
+  }
+  for (int face = 1; face <= 6; face++)
+    *observation++ = diceValues[game] == face ? 1.0f : 0.0f;
+  const unsigned legal{Rules::legalMoves(state, diceValues[game])};
+  std::uint8_t *mask{b.actionMasks + game * NUM_ACTIONS};
+  for (int i = 0; i < NUM_ACTIONS; i++)
+    mask[i] = (legal >> i) & 1u;
+}
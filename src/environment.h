@@ -0,0 +1,77 @@
+#ifndef ENVIRONMENT_H
+#define ENVIRONMENT_H
+
+#include "rules.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace gamespace {
+
+/**
+ * @brief Steps a batch of independent games at once for policy training.
+ *
+ * Every game always waits on a decision: the dice is already rolled and the
+ * player to move has at least one legal piece. step() plays the chosen
+ * pieces, rolls until the next decision and restarts finished games.
+ * All output goes to caller owned buffers laid out game after game,
+ * nothing is allocated once the environment is constructed.
+ */
+class BatchedEnvironment {
+public:
+  // progress of the 16 pieces, seen from the player to move, then the dice
+  static constexpr int OBSERVATION_SIZE{16 + 6};
+  static constexpr int NUM_ACTIONS{4};
+
+  // observations: size() * OBSERVATION_SIZE, actionMasks: size() * NUM_ACTIONS
+  void reset(float *observations, std::uint8_t *actionMasks);
+  // rewards are +1 for the move that wins a game, dones flag the games that
+  // ended and were restarted, illegal actions play the first legal piece
+  void step(const std::int32_t *actions, float *observations,
+            std::uint8_t *actionMasks, float *rewards, std::uint8_t *dones);
+  size_t size() const { return states.size(); }
+  const GameState &state(size_t game) const { return states.at(game); }
+  int diceValue(size_t game) const { return diceValues.at(game); }
+
+private:
+  struct Buffers {
+    const std::int32_t *actions;
+    float *observations;
+    std::uint8_t *actionMasks;
+    float *rewards;
+    std::uint8_t *dones;
+  };
+  std::vector<GameState> states;
+  std::vector<std::uint8_t> diceValues;
+  std::vector<std::minstd_rand> generators;
+  // workers run one slice of the batch each, generation wakes them up
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable wakeUp, finished;
+  unsigned long generation;
+  unsigned busyWorkers;
+  bool stopping;
+  bool resetting;
+  Buffers buffers;
+  void runBatch(bool reset, const Buffers &b);
+  void runSlice(size_t slice);
+  void workerLoop(size_t slice);
+  void resetGame(size_t game);
+  void rollUntilDecision(size_t game);
+  void writeOutputs(size_t game, const Buffers &b);
+
+public:
+  BatchedEnvironment(size_t batchSize, unsigned numThreads = 1,
+                     std::uint64_t seed = 0);
+  ~BatchedEnvironment();
+  BatchedEnvironment(const BatchedEnvironment &) = delete;
+  BatchedEnvironment &operator=(const BatchedEnvironment &) = delete;
+};
+
+} // namespace gamespace
+#endif
@@ -0,0 +1,131 @@
+#include "evalcache.h"
+
+#include <algorithm>
+#include <bit>
+
+using namespace gamespace;
+
+// splitmix64 finalizer, cheap and mixes every input bit into every output bit
+static std::uint64_t mix(std::uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ull;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebull;
+  return x ^ (x >> 31);
+}
+
+EvaluationCache::EvaluationCache(size_t capacity)
+    : shardCapacity(std::max<size_t>(1, capacity / NUM_SHARDS)),
+      indexMask(std::bit_ceil(2 * shardCapacity) - 1), shards(), hits(0),
+      misses(0), evictions(0) {
+  for (Shard &shard : shards) {
+    shard.entries.reserve(shardCapacity);
+    shard.index.assign(indexMask + 1, 0);
+  }
+}
+
+// the slot holding key, or the empty one where it would go
+size_t EvaluationCache::Shard::findSlot(std::uint64_t key, size_t mask) const {
+  size_t slot{key & mask};
+  while (index[slot] != 0 && entries[index[slot] - 1].key != key)
+    slot = (slot + 1) & mask;
+  return slot;
+}
+
+// linear probing without tombstones: later keys of the run move back
+void EvaluationCache::Shard::eraseSlot(size_t slot, size_t mask) {
+  for (size_t next = (slot + 1) & mask; index[next] != 0;
+       next = (next + 1) & mask) {
+    const size_t home{entries[index[next] - 1].key & mask};
+    if (((next - home) & mask) >= ((next - slot) & mask)) {
+      index[slot] = index[next];
+      slot = next;
+    }
+  }
+  index[slot] = 0;
+}
+
+EvaluationCache &EvaluationCache::shared() {
+  static EvaluationCache cache;
+  return cache;
+}
+
+std::uint64_t EvaluationCache::hash(const GameState &state, int numPlayers,
+                                    RuleSet rules) {
+  std::uint64_t h{mix(numPlayers | static_cast<std::uint64_t>(rules) << 8)};
+  for (int seat = 0; seat < numPlayers; seat++) {
+    std::uint64_t row{0};
+    for (int i = 0; i < 4; i++)
+      row = row << 8 | state.pieces[seat][i];
+    h = mix(h ^ row);
+  }
+  return mix(h ^ state.currentPlayer ^
+             static_cast<std::uint64_t>(state.repetitionCounter) << 8);
+}
+
+std::uint64_t EvaluationCache::key(std::uint64_t stateHash, int diceValue) {
+  return mix(stateHash + diceValue);
+}
+
+EvaluationCache::Shard &EvaluationCache::shardFor(std::uint64_t key) {
+  return shards[key >> 60]; // top bits, the slot map uses the low ones
+}
+
+bool EvaluationCache::find(std::uint64_t stateHash, int diceValue,
+                           CachedMove &result) {
+  const std::uint64_t k{key(stateHash, diceValue)};
+  Shard &shard = shardFor(k);
+  std::lock_guard lock(shard.mutex);
+  const std::uint32_t found{shard.index[shard.findSlot(k, indexMask)]};
+  if (found == 0) {
+    misses++;
+    return false;
+  }
+  Entry &entry = shard.entries[found - 1];
+  entry.referenced = true;
+  result = entry.value;
+  hits++;
+  return true;
+}
+
+void EvaluationCache::store(std::uint64_t stateHash, int diceValue,
+                            const CachedMove &value) {
+  const std::uint64_t k{key(stateHash, diceValue)};
+  Shard &shard = shardFor(k);
+  std::lock_guard lock(shard.mutex);
+  const size_t slot{shard.findSlot(k, indexMask)};
+  if (shard.index[slot] != 0) {
+    shard.entries[shard.index[slot] - 1].value = value;
+    return;
+  }
+  if (shard.entries.size() < shardCapacity) {
+    shard.entries.push_back({k, value, false});
+    shard.index[slot] = static_cast<std::uint32_t>(shard.entries.size());
+    return;
+  }
+  // clock: second chance for every entry hit since the hand last passed
+  while (shard.entries[shard.hand].referenced) {
+    shard.entries[shard.hand].referenced = false;
+    shard.hand = (shard.hand + 1) % shardCapacity;
+  }
+  Entry &victim = shard.entries[shard.hand];
+  shard.eraseSlot(shard.findSlot(victim.key, indexMask), indexMask);
+  victim = {k, value, false};
+  shard.index[shard.findSlot(k, indexMask)] =
+      static_cast<std::uint32_t>(shard.hand + 1);
+  shard.hand = (shard.hand + 1) % shardCapacity;
+  evictions++;
+}
+
+EvaluationCache::Stats EvaluationCache::getStats() const {
+  Stats stats;
+  stats.hits = hits;
+  stats.misses = misses;
+  stats.evictions = evictions;
+  stats.capacity = shardCapacity * NUM_SHARDS;
+  for (const Shard &shard : shards) {
+    std::lock_guard lock(shard.mutex);
+    stats.size += shard.entries.size();
+  }
+  return stats;
+}
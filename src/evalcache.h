@@ -0,0 +1,75 @@
+#ifndef EVALCACHE_H
+#define EVALCACHE_H
+
+#include "rules.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace gamespace {
+
+/**
+ * @brief Result of a finished search, what the cache hands out.
+ */
+struct CachedMove {
+  int move;         // piece index
+  float evaluation; // win rate of the mover after playing it
+};
+
+/**
+ * @brief Bounded move cache shared by every search in the process.
+ *
+ * Keys are a 64 bit state hash combined with the dice value. The table is
+ * split in shards with their own lock so tables searching at the same time
+ * rarely wait on each other, and each shard evicts with the clock policy:
+ * a hit marks its entry, the hand skips marked entries once before
+ * reusing them. Everything is allocated up front, storing never allocates.
+ */
+class EvaluationCache {
+public:
+  struct Stats {
+    long hits{0}, misses{0}, evictions{0};
+    size_t size{0}, capacity{0};
+  };
+  static EvaluationCache &shared();
+  // rows past numPlayers are ignored, the piece order matters
+  static std::uint64_t hash(const GameState &state, int numPlayers,
+                            RuleSet rules);
+  bool find(std::uint64_t stateHash, int diceValue, CachedMove &result);
+  void store(std::uint64_t stateHash, int diceValue, const CachedMove &entry);
+  Stats getStats() const;
+
+private:
+  static constexpr int NUM_SHARDS{16};
+  struct Entry {
+    std::uint64_t key;
+    CachedMove value;
+    bool referenced;
+  };
+  struct Shard {
+    mutable std::mutex mutex;
+    std::vector<Entry> entries;
+    // open addressing on the key's low bits, entries slot + 1, 0 is empty
+    std::vector<std::uint32_t> index;
+    size_t hand{0};
+    size_t findSlot(std::uint64_t key, size_t mask) const;
+    void eraseSlot(size_t slot, size_t mask);
+  };
+  size_t shardCapacity;
+  size_t indexMask; // index size - 1, at least twice the capacity
+  std::array<Shard, NUM_SHARDS> shards;
+  std::atomic<long> hits, misses, evictions;
+  static std::uint64_t key(std::uint64_t stateHash, int diceValue);
+  Shard &shardFor(std::uint64_t key);
+
+public:
+  explicit EvaluationCache(size_t capacity = 1 << 16);
+  EvaluationCache(const EvaluationCache &) = delete;
+  EvaluationCache &operator=(const EvaluationCache &) = delete;
+};
+
+} // namespace gamespace
+#endif
@@ -0,0 +1,122 @@
+#include "gamelog.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace gamespace;
+
+// "LUDOLOG" and a format version, padded to 16 bytes so records stay
+// aligned in the mapping
+static const char MAGIC[8]{'L', 'U', 'D', 'O', 'L', 'O', 'G', '\0'};
+static const std::uint32_t VERSION{1};
+static const std::size_t HEADER_SIZE{16};
+static const std::size_t BUFFER_RECORDS{1 << 14};
+
+GameLogWriter::GameLogWriter(const std::string &path)
+    : file(path, std::ios::binary | std::ios::trunc), buffer() {
+  if (!file) {
+    (std::cerr << "Could not create game log [" << path << "]\n").flush();
+    return;
+  }
+  char header[HEADER_SIZE]{};
+  std::memcpy(header, MAGIC, sizeof(MAGIC));
+  std::memcpy(header + sizeof(MAGIC), &VERSION, sizeof(VERSION));
+  file.write(header, sizeof(header));
+  buffer.reserve(BUFFER_RECORDS);
+}
+
+GameLogWriter::~GameLogWriter() { flush(); }
+
+void GameLogWriter::push(const GameRecord &record) {
+  buffer.push_back(record);
+  if (buffer.size() == BUFFER_RECORDS)
+    flush();
+}
+
+void GameLogWriter::flush() {
+  if (file.is_open())
+    file.write(reinterpret_cast<const char *>(buffer.data()),
+               buffer.size() * sizeof(GameRecord));
+  buffer.clear();
+}
+
+void GameLogWriter::startGame(int numPlayers, RuleSet rules) {
+  push({GameRecord::START, static_cast<std::uint8_t>(numPlayers),
+        static_cast<std::uint8_t>(rules), 0});
+}
+
+void GameLogWriter::roll(int seat, int dice, int piece, int destination,
+                         bool captured) {
+  std::uint8_t move = dice;
+  if (piece >= 0)
+    move |= piece << 3 | GameRecord::MOVED;
+  if (captured)
+    move |= GameRecord::CAPTURED;
+  push({GameRecord::ROLL, static_cast<std::uint8_t>(seat), move,
+        piece >= 0 ? static_cast<std::uint8_t>(destination)
+                   : GameRecord::NONE});
+}
+
+void GameLogWriter::endGame(int winner) {
+  push({GameRecord::END,
+        winner >= 0 ? static_cast<std::uint8_t>(winner) : GameRecord::NONE,
+        0, 0});
+}
+
+GameLog::GameLog()
+    : mapping(nullptr), mappingSize(0), records(nullptr), numRecords(0) {}
+
+GameLog::~GameLog() { close(); }
+
+void GameLog::close() {
+  if (mapping != nullptr)
+    munmap(mapping, mappingSize);
+  mapping = nullptr;
+  records = nullptr;
+  numRecords = 0;
+}
+
+bool GameLog::open(const std::string &path) {
+  close();
+  int fd{::open(path.c_str(), O_RDONLY)};
+  if (fd < 0) {
+    (std::cerr << "Could not open game log [" << path << "]\n").flush();
+    return false;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 ||
+      static_cast<std::size_t>(info.st_size) < HEADER_SIZE) {
+    (std::cerr << "Game log [" << path << "] is too short\n").flush();
+    ::close(fd);
+    return false;
+  }
+  const std::size_t size{static_cast<std::size_t>(info.st_size)};
+  void *data{mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0)};
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    (std::cerr << "Could not map game log [" << path << "]\n").flush();
+    return false;
+  }
+  std::uint32_t version;
+  std::memcpy(&version, static_cast<const char *>(data) + sizeof(MAGIC),
+              sizeof(version));
+  if (std::memcmp(data, MAGIC, sizeof(MAGIC)) != 0 || version != VERSION) {
+    (std::cerr << "[" << path << "] is not a game log of this version\n")
+        .flush();
+    munmap(data, size);
+    return false;
+  }
+  madvise(data, size, MADV_SEQUENTIAL);
+  mapping = data;
+  mappingSize = size;
+  records = reinterpret_cast<const GameRecord *>(static_cast<const char *>(
+                                                     data) +
+                                                 HEADER_SIZE);
+  // a truncated last record is ignored
+  numRecords = (size - HEADER_SIZE) / sizeof(GameRecord);
+  return true;
+}
@@ -0,0 +1,92 @@
+#ifndef GAMELOG_H
+#define GAMELOG_H
+
+#include "rules.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace gamespace {
+
+/**
+ * @brief One fixed size entry of a game log.
+ *
+ * A game is a START record, one ROLL record per dice roll and an END
+ * record. Fixed size records let readers split a memory-mapped log at any
+ * record boundary and resynchronize on the next START.
+ */
+struct GameRecord {
+  enum Type : std::uint8_t { START = 1, ROLL = 2, END = 3 };
+  static constexpr std::uint8_t MOVED{1 << 5};
+  static constexpr std::uint8_t CAPTURED{1 << 6};
+  static constexpr std::uint8_t NONE{255};
+
+  std::uint8_t type;
+  // START: player count, ROLL: seat that rolled, END: winner or NONE
+  std::uint8_t seat;
+  // START: the RuleSet played (0, classic, in logs from before it was
+  // stored), ROLL: dice value in the low 3 bits, piece index in bits 3-4,
+  // MOVED and CAPTURED flags
+  std::uint8_t move;
+  std::uint8_t destination; // ROLL: BoardPosition reached, NONE if nothing
+
+  int dice() const { return move & 7; }
+  int piece() const { return (move >> 3) & 3; }
+  bool moved() const { return move & MOVED; }
+  bool captured() const { return move & CAPTURED; }
+  RuleSet rules() const { return static_cast<RuleSet>(move); }
+  bool knownRules() const { return move < NUM_RULE_SETS; }
+};
+static_assert(sizeof(GameRecord) == 4);
+
+/**
+ * @brief Appends games to a log file, buffered.
+ */
+class GameLogWriter {
+public:
+  bool isOpen() const { return file.is_open() && file.good(); }
+  void startGame(int numPlayers, RuleSet rules);
+  // piece < 0 when the roll had no legal move
+  void roll(int seat, int dice, int piece, int destination, bool captured);
+  void endGame(int winner);
+
+private:
+  std::ofstream file;
+  std::vector<GameRecord> buffer;
+  void push(const GameRecord &record);
+  void flush();
+
+public:
+  explicit GameLogWriter(const std::string &path);
+  ~GameLogWriter();
+};
+
+/**
+ * @brief Read only, memory-mapped view of a log file.
+ */
+class GameLog {
+public:
+  bool open(const std::string &path);
+  const GameRecord *begin() const { return records; }
+  const GameRecord *end() const { return records + numRecords; }
+  size_t size() const { return numRecords; }
+
+private:
+  void *mapping;
+  std::size_t mappingSize;
+  const GameRecord *records;
+  std::size_t numRecords;
+  void close();
+
+public:
+  GameLog();
+  ~GameLog();
+  GameLog(const GameLog &) = delete;
+  GameLog &operator=(const GameLog &) = delete;
+};
+
+} // namespace gamespace
+#endif
@@ -0,0 +1,56 @@
+#include "history.h"
+
+using namespace gamespace;
+
+static_assert(sizeof(GameHistory::Node) == 32);
+
+GameHistory::GameHistory(size_t reserved) : nodes(), cursor(0) {
+  nodes.reserve(reserved);
+  GameState start;
+  Rules::reset(start);
+  reset(start);
+}
+
+// clear() keeps the capacity, a new game reuses it
+void GameHistory::reset(const GameState &state) {
+  nodes.clear();
+  nodes.push_back({state, NONE, NONE, 0, -1});
+  cursor = 0;
+}
+
+std::uint32_t GameHistory::play(const GameState &state, int dice,
+                                int piece) {
+  const std::uint32_t next{nodes[cursor].next};
+  if (next != NONE && nodes[next].dice == dice && nodes[next].piece == piece)
+    return cursor = next;
+  const std::uint32_t id{branch(cursor, state, dice, piece)};
+  nodes[cursor].next = id;
+  return cursor = id;
+}
+
+std::uint32_t GameHistory::branch(std::uint32_t from, const GameState &state,
+                                  int dice, int piece) {
+  const std::uint32_t id{static_cast<std::uint32_t>(nodes.size())};
+  nodes.push_back({state, from, NONE, static_cast<std::uint8_t>(dice),
+                   static_cast<std::int8_t>(piece)});
+  return id;
+}
+
+// the parent remembers where we came from, so redo comes back here even
+// after a jump to another line
+bool GameHistory::undo() {
+  const std::uint32_t parent{nodes[cursor].parent};
+  if (parent == NONE)
+    return false;
+  nodes[parent].next = cursor;
+  cursor = parent;
+  return true;
+}
+
+bool GameHistory::redo() {
+  const std::uint32_t next{nodes[cursor].next};
+  if (next == NONE)
+    return false;
+  cursor = next;
+  return true;
+}
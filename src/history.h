@@ -0,0 +1,66 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include "rules.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gamespace {
+
+/**
+ * @brief Every position a game went through, as a tree: undo, redo and
+ * jumping to any position are O(1), and playing something else after an
+ * undo starts a new line instead of overwriting the old one.
+ *
+ * Positions are GameState value copies that never change once added, a
+ * line shares every position before its fork with the line it forked
+ * from. A position costs 32 bytes, so analysis tools can branch() off
+ * thousands of hypothetical lines from any node without touching the
+ * game being played.
+ *
+ * Not thread safe.
+ */
+class GameHistory {
+public:
+  static constexpr std::uint32_t NONE{UINT32_MAX};
+
+  struct Node {
+    GameState state;      // before the roll, rows past the players unused
+    std::uint32_t parent; // NONE for the first position
+    std::uint32_t next;   // the child redo goes to, NONE for none
+    std::uint8_t dice;    // rolled in the parent to get here
+    std::int8_t piece;    // moved with it, -1 when the roll passed
+  };
+
+  // forgets every position, state becomes the first one
+  void reset(const GameState &state);
+  // state is where rolling dice and moving piece leads from the current
+  // position, it becomes the current one. Replaying the move redo would
+  // follow just moves there.
+  std::uint32_t play(const GameState &state, int dice, int piece);
+  // adds a position after from and leaves the current one alone
+  std::uint32_t branch(std::uint32_t from, const GameState &state, int dice,
+                       int piece);
+  // false at the first position
+  bool undo();
+  // false at the end of the line
+  bool redo();
+  void jump(std::uint32_t id) { cursor = id; }
+  std::uint32_t current() const { return cursor; }
+  const Node &node(std::uint32_t id) const { return nodes[id]; }
+  const Node &position() const { return nodes[cursor]; }
+  size_t size() const { return nodes.size(); }
+
+private:
+  std::vector<Node> nodes;
+  std::uint32_t cursor;
+
+public:
+  // room for that many positions before anything allocates
+  explicit GameHistory(size_t reserved);
+};
+
+} // namespace gamespace
+#endif
@@ -0,0 +1,350 @@
+#include "journal.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+
+#include "log.h"
+
+using namespace gamespace;
+
+// "LUDOJRNL" and a format version, padded to 16 bytes like the game log
+static const char MAGIC[8]{'L', 'U', 'D', 'O', 'J', 'R', 'N', 'L'};
+static const std::uint32_t VERSION{1};
+static const std::size_t HEADER_SIZE{16};
+// 512KB, a few hundred games
+static const std::size_t INITIAL_RECORDS{1 << 16};
+
+GameJournal::GameJournal()
+    : path(), fd(-1), mapping(nullptr), capacity(0), numRecords(0),
+      nextGame(0), full(false), restoredGames() {}
+
+GameJournal::~GameJournal() { close(); }
+
+void GameJournal::close() {
+  if (mapping != nullptr)
+    munmap(mapping, HEADER_SIZE + capacity * sizeof(JournalRecord));
+  if (fd >= 0)
+    ::close(fd);
+  mapping = nullptr;
+  fd = -1;
+  capacity = numRecords = 0;
+}
+
+JournalRecord *GameJournal::records() const {
+  return reinterpret_cast<JournalRecord *>(static_cast<char *>(mapping) +
+                                           HEADER_SIZE);
+}
+
+// sizes the file for capacity records and maps all of it, new space reads
+// as zeros, which is the end marker
+bool GameJournal::map(int file, std::size_t records) {
+  const std::size_t size{HEADER_SIZE + records * sizeof(JournalRecord)};
+  struct stat info;
+  if (fstat(file, &info) != 0 ||
+      (static_cast<std::size_t>(info.st_size) < size &&
+       ftruncate(file, static_cast<off_t>(size)) != 0))
+    return false;
+  void *data{
+      mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0)};
+  if (data == MAP_FAILED)
+    return false;
+  close();
+  fd = file;
+  mapping = data;
+  capacity = records;
+  return true;
+}
+
+bool GameJournal::open(const std::string &journalPath) {
+  close();
+  path = journalPath;
+  int file{::open(path.c_str(), O_RDWR | O_CREAT, 0644)};
+  if (file < 0) {
+    LOG_ERROR("Could not open journal [%s]", path.c_str());
+    return false;
+  }
+  struct stat info;
+  if (fstat(file, &info) != 0) {
+    ::close(file);
+    return false;
+  }
+  const std::size_t size{static_cast<std::size_t>(info.st_size)};
+  const bool created{size == 0};
+  std::size_t records{INITIAL_RECORDS};
+  if (!created) {
+    char header[HEADER_SIZE]{};
+    std::uint32_t version{0};
+    if (size >= HEADER_SIZE &&
+        pread(file, header, HEADER_SIZE, 0) ==
+            static_cast<ssize_t>(HEADER_SIZE))
+      std::memcpy(&version, header + sizeof(MAGIC), sizeof(version));
+    if (std::memcmp(header, MAGIC, sizeof(MAGIC)) != 0 ||
+        version != VERSION) {
+      LOG_ERROR("[%s] is not a journal of this version", path.c_str());
+      ::close(file);
+      return false;
+    }
+    records = std::max<std::size_t>(
+        1, (size - HEADER_SIZE) / sizeof(JournalRecord));
+  }
+  if (!map(file, records)) {
+    LOG_ERROR("Could not map journal [%s]", path.c_str());
+    ::close(file);
+    return false;
+  }
+  if (created) {
+    std::memcpy(mapping, MAGIC, sizeof(MAGIC));
+    std::memcpy(static_cast<char *>(mapping) + sizeof(MAGIC), &VERSION,
+                sizeof(VERSION));
+  }
+  numRecords = replay(restoredGames);
+  return true;
+}
+
+// the rolls of one game, checked against the rules like ludo_replay does
+template <int N>
+static bool replayRoll(GameJournal::RunningGame &game,
+                       const GameRecord &record) {
+  using R = BasicRules<N>;
+  typename R::State state;
+  for (int seat = 0; seat < N; seat++)
+    state.pieces[seat] = game.state.pieces[seat];
+  state.currentPlayer = game.state.currentPlayer;
+  state.repetitionCounter = game.state.repetitionCounter;
+  state.winner = game.state.winner;
+  if (R::isOver(state) || record.seat != state.currentPlayer ||
+      record.dice() < 1 || record.dice() > 6)
+    return false;
+  const bool canMove{R::roll(state, record.dice())};
+  if (canMove != record.moved() ||
+      (canMove && !(R::legalMoves(state, record.dice()) >> record.piece() & 1)))
+    return false;
+  if (canMove)
+    R::play(state, record.piece(), record.dice());
+  for (int seat = 0; seat < N; seat++)
+    game.state.pieces[seat] = state.pieces[seat];
+  game.state.currentPlayer = state.currentPlayer;
+  game.state.repetitionCounter = state.repetitionCounter;
+  game.state.winner = state.winner;
+  return true;
+}
+
+// a PLACE or TURN record of a compacted journal
+static bool applySnapshot(GameJournal::RunningGame &game,
+                          const GameRecord &record) {
+  if (record.type == JournalRecord::TURN) {
+    if (record.seat >= game.numPlayers || record.move > 3)
+      return false;
+    game.state.currentPlayer = record.seat;
+    game.state.repetitionCounter = record.move;
+    return true;
+  }
+  if (record.seat >= game.numPlayers || record.move > 3 ||
+      record.destination >= NUM_POSITIONS)
+    return false;
+  game.state.pieces[record.seat][record.move] = record.destination;
+  return true;
+}
+
+// the games the journal leaves running, returns the records it has
+size_t GameJournal::replay(std::vector<RunningGame> &games) {
+  games.clear();
+  nextGame = 0;
+  std::unordered_map<std::uint32_t, size_t> byId;
+  std::vector<bool> dropped;
+  const JournalRecord *r{records()};
+  size_t n{0};
+  for (; n < capacity && r[n].record.type != 0; n++) {
+    const JournalRecord &entry{r[n]};
+    nextGame = std::max(nextGame, entry.game + 1);
+    if (entry.record.type == GameRecord::START) {
+      const int numPlayers{entry.record.seat};
+      if (numPlayers < 2 || numPlayers > 4)
+        continue;
+      RunningGame game{entry.game, numPlayers, {}};
+      Rules::reset(game.state);
+      // 2 players sit at opposite corners, see BasicRules::seatColor
+      for (int seat = 0; seat < numPlayers; seat++)
+        for (int i = 0; i < 4; i++)
+          game.state.pieces[seat][i] = Rules::jailPosition(
+              numPlayers == 2 ? 2 * seat : seat, i);
+      byId[entry.game] = games.size();
+      games.push_back(game);
+      dropped.push_back(false);
+      continue;
+    }
+    auto found{byId.find(entry.game)};
+    if (found == byId.end() || dropped[found->second])
+      continue;
+    RunningGame &game{games[found->second]};
+    bool followed{false};
+    switch (entry.record.type) {
+    case GameRecord::END:
+      dropped[found->second] = true; // not running any more
+      continue;
+    case JournalRecord::PLACE:
+    case JournalRecord::TURN:
+      followed = applySnapshot(game, entry.record);
+      break;
+    case GameRecord::ROLL:
+      if (game.numPlayers == 2)
+        followed = replayRoll<2>(game, entry.record);
+      else if (game.numPlayers == 3)
+        followed = replayRoll<3>(game, entry.record);
+      else
+        followed = replayRoll<4>(game, entry.record);
+      break;
+    }
+    if (!followed) {
+      LOG_WARNING("Journal [%s] game %u does not follow the rules, dropped",
+                  path.c_str(), entry.game);
+      dropped[found->second] = true;
+    }
+  }
+  size_t kept{0};
+  for (size_t i = 0; i < games.size(); i++)
+    if (!dropped[i] && games[i].state.winner < 0)
+      games[kept++] = games[i];
+  games.resize(kept);
+  return n;
+}
+
+/**
+ * One aligned 8 byte store, a crash leaves either the whole record or the
+ * zeros that end the journal. A full journal is compacted first, and grows
+ * when the games still running need more than half of it.
+ */
+void GameJournal::append(const JournalRecord &record) {
+  if (mapping == nullptr)
+    return;
+  if (numRecords == capacity && !compact()) {
+    if (!full)
+      LOG_WARNING("Journal [%s] is full, dropping records", path.c_str());
+    full = true;
+    return;
+  }
+  std::uint64_t word;
+  std::memcpy(&word, &record, sizeof(word));
+  std::atomic_ref<std::uint64_t>(
+      *reinterpret_cast<std::uint64_t *>(records() + numRecords))
+      .store(word, std::memory_order_relaxed);
+  numRecords++;
+}
+
+// a START, a PLACE for every piece that left its jail slot and a TURN
+static void snapshot(std::uint32_t game, int numPlayers,
+                     const GameState &state,
+                     std::vector<JournalRecord> &records) {
+  records.push_back(
+      {game,
+       {GameRecord::START, static_cast<std::uint8_t>(numPlayers), 0, 0}});
+  for (int seat = 0; seat < numPlayers; seat++)
+    for (int i = 0; i < 4; i++) {
+      const int position{state.pieces[seat][i]};
+      if (position !=
+          Rules::jailPosition(numPlayers == 2 ? 2 * seat : seat, i))
+        records.push_back({game,
+                           {JournalRecord::PLACE,
+                            static_cast<std::uint8_t>(seat),
+                            static_cast<std::uint8_t>(i),
+                            static_cast<std::uint8_t>(position)}});
+    }
+  records.push_back({game,
+                     {JournalRecord::TURN, state.currentPlayer,
+                      state.repetitionCounter, 0}});
+}
+
+std::uint32_t GameJournal::startGame(int numPlayers) {
+  const std::uint32_t game{nextGame++};
+  append({game,
+          {GameRecord::START, static_cast<std::uint8_t>(numPlayers), 0, 0}});
+  return game;
+}
+
+std::uint32_t GameJournal::startGame(int numPlayers,
+                                     const GameState &state) {
+  const std::uint32_t game{nextGame++};
+  std::vector<JournalRecord> saved;
+  snapshot(game, numPlayers, state, saved);
+  for (const JournalRecord &record : saved)
+    append(record);
+  return game;
+}
+
+void GameJournal::roll(std::uint32_t game, int seat, int dice, int piece,
+                       int destination, bool captured) {
+  std::uint8_t move = dice;
+  if (piece >= 0)
+    move |= piece << 3 | GameRecord::MOVED;
+  if (captured)
+    move |= GameRecord::CAPTURED;
+  append({game,
+          {GameRecord::ROLL, static_cast<std::uint8_t>(seat), move,
+           piece >= 0 ? static_cast<std::uint8_t>(destination)
+                      : GameRecord::NONE}});
+}
+
+void GameJournal::endGame(std::uint32_t game, int winner) {
+  append({game,
+          {GameRecord::END,
+           winner >= 0 ? static_cast<std::uint8_t>(winner) : GameRecord::NONE,
+           0, 0}});
+}
+
+/**
+ * Every running game becomes a snapshot, a few dozen bytes however long
+ * it has been played. Written to a new file then renamed over the
+ * journal: a crash at any point leaves either the old journal or the
+ * compacted one. Nothing is synced, the journal only has to outlive the
+ * process and the rolls are played on this thread.
+ */
+bool GameJournal::compact() {
+  if (mapping == nullptr)
+    return false;
+  std::vector<RunningGame> games;
+  replay(games);
+  std::vector<JournalRecord> saved;
+  saved.reserve(games.size() * 18);
+  for (const RunningGame &game : games)
+    snapshot(game.id, game.numPlayers, game.state, saved);
+
+  const std::string temporary{path + ".compact"};
+  const std::size_t records{std::max(INITIAL_RECORDS, 2 * saved.size())};
+  const std::size_t size{HEADER_SIZE + records * sizeof(JournalRecord)};
+  int file{::open(temporary.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644)};
+  void *data{MAP_FAILED};
+  if (file >= 0 && ftruncate(file, static_cast<off_t>(size)) == 0)
+    data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+  if (data == MAP_FAILED) {
+    LOG_ERROR("Could not compact journal [%s]", path.c_str());
+    if (file >= 0)
+      ::close(file), std::remove(temporary.c_str());
+    return false;
+  }
+  std::memcpy(data, mapping, HEADER_SIZE);
+  std::memcpy(static_cast<char *>(data) + HEADER_SIZE, saved.data(),
+              saved.size() * sizeof(JournalRecord));
+  if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+    LOG_ERROR("Could not compact journal [%s]", path.c_str());
+    munmap(data, size);
+    ::close(file);
+    std::remove(temporary.c_str());
+    return false;
+  }
+  const std::uint32_t next{nextGame};
+  close();
+  fd = file;
+  mapping = data;
+  capacity = records;
+  numRecords = saved.size();
+  nextGame = next; // ids of ended games are not reused
+  full = false;
+  return true;
+}
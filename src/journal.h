@@ -0,0 +1,94 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "gamelog.h"
+#include "rules.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gamespace {
+
+/**
+ * @brief A game log record tagged with the game it belongs to, so one
+ * journal can hold any number of games played side by side.
+ *
+ * Compaction adds two types: PLACE puts piece move of seat on destination,
+ * TURN makes seat the mover with move rolls taken.
+ */
+struct JournalRecord {
+  static constexpr std::uint8_t PLACE{16};
+  static constexpr std::uint8_t TURN{17};
+
+  std::uint32_t game;
+  GameRecord record; // type 0 marks the end of the journal
+};
+static_assert(sizeof(JournalRecord) == 8);
+
+/**
+ * @brief Memory-mapped, append only journal of games in progress, so a
+ * host that crashes or gets redeployed picks them up where they were.
+ *
+ * Every roll is one 8 byte record stored straight into a shared mapping
+ * of the file: it survives the process dying the moment the store is
+ * done, not the machine losing power. open() replays the games that did
+ * not end through the rules. A full journal is compacted into a new file
+ * holding a snapshot of every game still running and room for as many
+ * records again, so a restore never reads more than about twice the
+ * snapshots however long the games have been running.
+ *
+ * One process per journal, nothing here is thread safe.
+ */
+class GameJournal {
+public:
+  struct RunningGame {
+    std::uint32_t id;
+    int numPlayers;
+    GameState state; // rows past numPlayers are unused
+  };
+
+  // maps the journal, creating it when missing, and replays it
+  bool open(const std::string &path);
+  bool isOpen() const { return mapping != nullptr; }
+  // games of the journal that had not ended when it was opened
+  const std::vector<RunningGame> &restored() const { return restoredGames; }
+  std::uint32_t startGame(int numPlayers);
+  // a game that starts from a position, written as a snapshot like
+  // compact() does. A crash halfway through the snapshot restores the game
+  // with some pieces still in jail.
+  std::uint32_t startGame(int numPlayers, const GameState &state);
+  // piece < 0 when the roll had no legal move, same as GameLogWriter
+  void roll(std::uint32_t game, int seat, int dice, int piece,
+            int destination, bool captured);
+  // winner < 0 for a game given up
+  void endGame(std::uint32_t game, int winner);
+  // rewrites the journal with only the games that did not end
+  bool compact();
+  size_t size() const { return numRecords; }
+
+private:
+  std::string path;
+  int fd;
+  void *mapping;
+  std::size_t capacity; // records the file has room for
+  std::size_t numRecords;
+  std::uint32_t nextGame;
+  bool full; // records are being dropped, warned about once
+  std::vector<RunningGame> restoredGames;
+  JournalRecord *records() const;
+  bool map(int fd, std::size_t capacity);
+  void append(const JournalRecord &record);
+  size_t replay(std::vector<RunningGame> &games);
+  void close();
+
+public:
+  GameJournal();
+  ~GameJournal();
+  GameJournal(const GameJournal &) = delete;
+  GameJournal &operator=(const GameJournal &) = delete;
+};
+
+} // namespace gamespace
+#endif
@@ -0,0 +1,46 @@
+#include "latency.h"
+
+#include <algorithm>
+#include <cstdio>
+
+using namespace gamespace;
+
+LatencyStats::LatencyStats()
+    : histogram(), pending(), numPending(0), samples(0), maxTime(0) {}
+
+// more changes than that between two frames only lose samples
+void LatencyStats::changed(std::uint64_t eventTime) {
+  if (numPending < pending.size())
+    pending[numPending++] = eventTime;
+}
+
+void LatencyStats::presented(std::uint64_t presentTime) {
+  for (size_t i = 0; i < numPending; i++) {
+    const std::uint64_t latency{
+        presentTime > pending[i] ? presentTime - pending[i] : 0};
+    histogram[std::min<std::uint64_t>(latency / BUCKET_TIME, BUCKETS - 1)]++;
+    maxTime = std::max(maxTime, latency);
+    samples++;
+  }
+  numPending = 0;
+}
+
+double LatencyStats::percentile(double fraction) const {
+  if (samples == 0)
+    return 0;
+  const long rank{std::max(1L, static_cast<long>(fraction * samples + 0.5))};
+  long seen{0};
+  for (int bucket = 0; bucket < BUCKETS; bucket++) {
+    seen += histogram[bucket];
+    // the last bucket has no upper bound but the slowest sample
+    if (seen >= rank && bucket < BUCKETS - 1)
+      return std::min((bucket + 1) * BUCKET_TIME / 1e6, maxMs());
+  }
+  return maxMs();
+}
+
+void LatencyStats::format(char *text, size_t size) const {
+  std::snprintf(text, size,
+                "%ld inputs p50 %.1f p90 %.1f p99 %.1f max %.1f ms", samples,
+                percentile(0.5), percentile(0.9), percentile(0.99), maxMs());
+}
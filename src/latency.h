@@ -0,0 +1,47 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace gamespace {
+
+/**
+ * @brief Input to present latency: from the timestamp of an input event to
+ * the first frame presented after the screen changed because of it.
+ *
+ * Samples go into a histogram of quarter milliseconds up to a quarter
+ * second, slower ones share the last bucket, so recording never allocates
+ * and percentiles are cheap enough to show every frame. Times are
+ * nanoseconds on the clock that stamps the events.
+ */
+class LatencyStats {
+public:
+  // the screen changed because of an event stamped eventTime
+  void changed(std::uint64_t eventTime);
+  // a frame reached the screen, every change before it is a sample
+  void presented(std::uint64_t presentTime);
+  long getSamples() const { return samples; }
+  // upper bound of the bucket holding that fraction of the samples, in
+  // milliseconds, 0 without samples
+  double percentile(double fraction) const;
+  double maxMs() const { return maxTime / 1e6; }
+  // one line: samples, p50, p90, p99 and max
+  void format(char *text, size_t size) const;
+
+private:
+  static constexpr int BUCKETS{1000};
+  static constexpr std::uint64_t BUCKET_TIME{250000}; // ns
+  std::array<long, BUCKETS> histogram;
+  std::array<std::uint64_t, 16> pending; // changes not presented yet
+  size_t numPending;
+  long samples;
+  std::uint64_t maxTime;
+
+public:
+  LatencyStats();
+};
+
+} // namespace gamespace
+#endif
@@ -0,0 +1,243 @@
+#include "lockstep.h"
+
+#include <cstring>
+#include <random>
+
+using namespace gamespace;
+
+namespace {
+
+const std::uint8_t NO_WINNER{0xFF};
+// BoardPosition ids of the track squares where nobody can be captured,
+// see BoardPosition::isProtectedPosition
+const std::uint8_t PROTECTED_SQUARES[]{0, 47, 39, 34, 8, 13, 26, 21};
+
+} // namespace
+
+inline LockstepSimulator::Lanes LockstepSimulator::splat(std::uint8_t value) {
+  return Lanes{} + value;
+}
+
+inline LockstepSimulator::Lanes LockstepSimulator::blend(Mask mask, Lanes a,
+                                                  Lanes b) {
+  return (a & (Lanes)mask) | (b & ~(Lanes)mask);
+}
+
+// BoardPosition id of a piece on the common track, only meaningful for
+// progress values between 1 and 51
+inline LockstepSimulator::Lanes LockstepSimulator::trackSquare(Lanes progress,
+                                                        Lanes color) {
+  Lanes square = progress - 1 + color * 13;
+  return blend(square >= 52, square - 52, square);
+}
+
+LockstepSimulator::LockstepSimulator(size_t numGames, Policy policy,
+                                     std::uint32_t seed)
+    : blocks((numGames + LANES - 1) / LANES), numGames(numGames),
+      policy(policy) {
+  std::seed_seq seeds{seed};
+  std::vector<std::uint32_t> laneSeeds(blocks.size() * LANES);
+  seeds.generate(laneSeeds.begin(), laneSeeds.end());
+  for (size_t b = 0; b < blocks.size(); b++) {
+    Block &block{blocks[b]};
+    std::memset(&block, 0, sizeof(Block));
+    for (int lane = 0; lane < LANES; lane++) {
+      // lanes past the last game start finished so they never move
+      block.winner[lane] = b * LANES + lane < numGames ? NO_WINNER : 0;
+      block.random[lane] = laneSeeds[b * LANES + lane] | 1u; // never 0
+    }
+  }
+}
+
+std::uint32_t LockstepSimulator::nextRandom(std::uint32_t &state) {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+bool LockstepSimulator::step() {
+  bool running{false};
+  for (Block &block : blocks)
+    running |= stepBlock(block);
+  return running;
+}
+
+size_t LockstepSimulator::run(size_t maxSteps) {
+  size_t steps{0};
+  while (steps < maxSteps && !isFinished()) {
+    steps++;
+    if (!step())
+      break;
+  }
+  return steps;
+}
+
+bool LockstepSimulator::isFinished() const {
+  for (const Block &block : blocks)
+    for (int lane = 0; lane < LANES; lane++)
+      if (block.winner[lane] == NO_WINNER)
+        return false;
+  return true;
+}
+
+int LockstepSimulator::winner(size_t game) const {
+  std::uint8_t w{blocks.at(game / LANES).winner[game % LANES]};
+  return w == NO_WINNER ? -1 : w;
+}
+
+int LockstepSimulator::progress(size_t game, int color, int piece) const {
+  return blocks.at(game / LANES).progress[color][piece][game % LANES];
+}
+
+bool LockstepSimulator::stepBlock(Block &b) const {
+  const Mask active = b.winner == NO_WINNER;
+  bool anyActive{false};
+  for (int lane = 0; lane < LANES; lane++)
+    anyActive |= active[lane] != 0;
+  if (!anyActive)
+    return false;
+
+  // nextRandom in every lane at once
+  Words random{b.random};
+  random ^= random << 13;
+  random ^= random >> 17;
+  random ^= random << 5;
+  b.random = random;
+  const Lanes dice{__builtin_convertvector(random % 6 + 1, Lanes)};
+  const Lanes rotation{__builtin_convertvector((random >> 16) & 3, Lanes)};
+
+  const Lanes player = b.currentPlayer;
+  Mask isPlayer[Rules::NUM_PLAYERS];
+  for (int c = 0; c < Rules::NUM_PLAYERS; c++)
+    isPlayer[c] = player == splat(c);
+  b.repetitionCounter =
+      blend(active, b.repetitionCounter + 1, b.repetitionCounter);
+
+  // the current player's pieces and which of them can move
+  Lanes mine[Rules::PIECES_PER_COLOR];
+  Mask legal[Rules::PIECES_PER_COLOR];
+  Mask anyLegal = {};
+  for (int i = 0; i < Rules::PIECES_PER_COLOR; i++) {
+    mine[i] = Lanes{};
+    for (int c = 0; c < Rules::NUM_PLAYERS; c++)
+      mine[i] |= b.progress[c][i] & (Lanes)isPlayer[c];
+    legal[i] = ((mine[i] == 0) & (dice == 6)) |
+               ((mine[i] != 0) & (mine[i] + dice <= Rules::FINAL_PROGRESS));
+    legal[i] &= active;
+    anyLegal |= legal[i];
+  }
+
+  // policy, same choices as choosePiece
+  Lanes choice = {};
+  Mask found = {};
+  if (policy == FURTHEST_PIECE) {
+    Lanes best = {};
+    for (int i = 0; i < Rules::PIECES_PER_COLOR; i++) {
+      Mask better = legal[i] & (~found | (mine[i] > best));
+      choice = blend(better, splat(i), choice);
+      best = blend(better, mine[i], best);
+      found |= legal[i];
+    }
+  } else {
+    for (int j = 0; j < Rules::PIECES_PER_COLOR; j++) {
+      Lanes index = (rotation + splat(j)) & 3;
+      Mask legalAtIndex = {};
+      for (int i = 0; i < Rules::PIECES_PER_COLOR; i++)
+        legalAtIndex |= legal[i] & (index == splat(i));
+      Mask take = legalAtIndex & ~found;
+      choice = blend(take, index, choice);
+      found |= take;
+    }
+  }
+
+  // move the chosen piece
+  Lanes landing = {};
+  for (int i = 0; i < Rules::PIECES_PER_COLOR; i++) {
+    Mask moving = anyLegal & (choice == splat(i));
+    Lanes moved = blend(mine[i] == 0, splat(1), mine[i] + dice);
+    landing = blend(moving, moved, landing);
+    for (int c = 0; c < Rules::NUM_PLAYERS; c++)
+      b.progress[c][i] = blend(moving & isPlayer[c], moved, b.progress[c][i]);
+  }
+
+  // send opponents sharing the landing square back to jail
+  const Lanes square = trackSquare(landing, player);
+  Mask safe = {};
+  for (std::uint8_t protectedSquare : PROTECTED_SQUARES)
+    safe |= square == protectedSquare;
+  const Mask canCapture = anyLegal & (landing >= 1) & (landing <= 51) & ~safe;
+  Mask captured = {};
+  for (int o = 0; o < Rules::NUM_PLAYERS; o++) {
+    Mask opponent = canCapture & ~isPlayer[o];
+    for (int j = 0; j < Rules::PIECES_PER_COLOR; j++) {
+      Lanes theirs = b.progress[o][j];
+      Mask hit = opponent & (theirs >= 1) & (theirs <= 51) &
+                 (trackSquare(theirs, splat(o)) == square);
+      b.progress[o][j] = blend(hit, Lanes{}, theirs);
+      captured |= hit;
+    }
+  }
+
+  // all four pieces home wins the game
+  Mask won = anyLegal;
+  for (int i = 0; i < Rules::PIECES_PER_COLOR; i++) {
+    Lanes after = {};
+    for (int c = 0; c < Rules::NUM_PLAYERS; c++)
+      after |= b.progress[c][i] & (Lanes)isPlayer[c];
+    won &= after == Rules::FINAL_PROGRESS;
+  }
+  b.winner = blend(won, player, b.winner);
+
+  // turn passing of Rules::roll and Rules::play
+  const Mask exhausted = b.repetitionCounter >= 3;
+  const Mask notSix = dice != 6;
+  const Mask pass =
+      active & ~won &
+      ((~anyLegal & (notSix | exhausted)) |
+       (anyLegal & ((notSix & ~captured) | exhausted)));
+  b.currentPlayer = blend(pass, (player + 1) & 3, player);
+  b.repetitionCounter = blend(pass, Lanes{}, b.repetitionCounter);
+  return true;
+}
+
+bool LockstepSimulator::verify(size_t numGames, Policy policy,
+                               std::uint32_t seed, std::ostream &log) {
+  LockstepSimulator simulator(numGames, policy, seed);
+  std::vector<GameState> states(numGames);
+  std::vector<std::uint32_t> randoms(numGames);
+  for (size_t g = 0; g < numGames; g++) {
+    Rules::reset(states[g]);
+    randoms[g] = simulator.blocks[g / LANES].random[g % LANES];
+  }
+  size_t steps{0};
+  while (simulator.step()) {
+    steps++;
+    for (size_t g = 0; g < numGames; g++) {
+      GameState &state{states[g]};
+      if (!Rules::isOver(state)) {
+        std::uint32_t random{nextRandom(randoms[g])};
+        int dice = random % 6 + 1;
+        if (Rules::roll(state, dice))
+          Rules::play(state, choosePiece<Rules>(state, dice, random, policy),
+                     dice);
+      }
+      const Block &block{simulator.blocks[g / LANES]};
+      bool same{simulator.winner(g) == state.winner &&
+                block.currentPlayer[g % LANES] == state.currentPlayer &&
+                block.repetitionCounter[g % LANES] == state.repetitionCounter};
+      for (int c = 0; c < Rules::NUM_PLAYERS; c++)
+        for (int i = 0; i < Rules::PIECES_PER_COLOR; i++)
+          same &= simulator.progress(g, c, i) ==
+                  Rules::progress(c, state.pieces[c][i]);
+      if (!same) {
+        log << "Lockstep and scalar rules disagree on game " << g
+            << " after step " << steps << '\n';
+        return false;
+      }
+    }
+  }
+  log << "Lockstep matches the scalar rules on " << numGames << " games over "
+      << steps << " steps\n";
+  return true;
+}
@@ -0,0 +1,95 @@
+#ifndef LOCKSTEP_H
+#define LOCKSTEP_H
+
+#include "rules.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace gamespace {
+
+/**
+ * @brief Plays many games side by side, one game per byte lane.
+ *
+ * Pieces are stored as progress along their color's path (0 in jail,
+ * Rules::FINAL_PROGRESS once home) in structure of arrays blocks of 16
+ * lanes, so moving, capturing and sending pieces back to jail are plain
+ * vector adds, compares and masked blends over a whole block.
+ * Every step rolls once in every running game and plays the move picked by
+ * a fixed policy, exactly like Rules::roll followed by Rules::play. Only the
+ * classic 4 player rules are implemented.
+ *
+ * Against scalar mode this is about 3.7 times the games per second, not
+ * 16: every lane pays for every branch of the rules (pieces in jail and
+ * on the track, captures of all 16 pieces, turn passing), and about a fifth
+ * of the lanes idle in each block once their game is over. 32 lanes
+ * would give about 5 times with AVX2, but baseline x86-64 splits 32 byte
+ * vectors into scalar code and runs 13 times slower.
+ */
+class LockstepSimulator {
+public:
+  enum Policy { FURTHEST_PIECE, RANDOM_LEGAL };
+  static constexpr int LANES{16};
+
+  // returns wether some game is still running afterwards
+  bool step();
+  // steps until every game is over or maxSteps is reached
+  size_t run(size_t maxSteps);
+  size_t size() const { return numGames; }
+  bool isFinished() const;
+  int winner(size_t game) const;
+  int progress(size_t game, int color, int piece) const;
+  // reference implementation of the policies on the scalar rules
+  template <class R>
+  static int choosePiece(const typename R::State &state, int diceValue,
+                         std::uint32_t random, Policy policy) {
+    const unsigned legal{R::legalMoves(state, diceValue)};
+    const int seat{state.currentPlayer};
+    int choice{-1};
+    if (policy == FURTHEST_PIECE) {
+      int best{-1};
+      for (int i = 0; i < R::PIECES_PER_COLOR; i++) {
+        int p{R::progress(seat, state.pieces[seat][i])};
+        if ((legal & (1u << i)) && p > best)
+          best = p, choice = i;
+      }
+      return choice;
+    }
+    int rotation = (random >> 16) & 3;
+    for (int j = 0; j < R::PIECES_PER_COLOR; j++) {
+      int index{(rotation + j) & 3};
+      if (legal & (1u << index))
+        return index;
+    }
+    return choice;
+  }
+  // runs the same games on the scalar rules and compares after each step
+  static bool verify(size_t numGames, Policy policy, std::uint32_t seed,
+                     std::ostream &log);
+
+private:
+  typedef std::uint8_t Lanes __attribute__((vector_size(LANES)));
+  typedef std::int8_t Mask __attribute__((vector_size(LANES)));
+  typedef std::uint32_t Words __attribute__((vector_size(4 * LANES)));
+  struct Block {
+    Lanes progress[Rules::NUM_PLAYERS][Rules::PIECES_PER_COLOR];
+    Lanes currentPlayer, repetitionCounter, winner;
+    Words random; // xorshift32 state per lane
+  };
+  std::vector<Block> blocks;
+  size_t numGames;
+  Policy policy;
+  static std::uint32_t nextRandom(std::uint32_t &state);
+  static Lanes splat(std::uint8_t value);
+  static Lanes blend(Mask mask, Lanes a, Lanes b);
+  static Lanes trackSquare(Lanes progress, Lanes color);
+  bool stepBlock(Block &block) const;
+
+public:
+  LockstepSimulator(size_t numGames, Policy policy, std::uint32_t seed);
+};
+
+} // namespace gamespace
+#endif
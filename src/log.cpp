@@ -0,0 +1,150 @@
+#include "log.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace gamespace;
+
+namespace {
+
+const std::size_t RING_ENTRIES{256}; // per thread
+const int MESSAGE_SIZE{248};
+const auto DRAIN_INTERVAL{std::chrono::milliseconds(20)};
+
+struct Entry {
+  LogLevel level;
+  int length;
+  char text[MESSAGE_SIZE];
+};
+
+/**
+ * Single producer, single consumer: the thread that owns it writes head,
+ * the drain, always under the logger mutex, writes tail.
+ */
+struct Ring {
+  std::array<Entry, RING_ENTRIES> entries;
+  std::atomic<std::uint64_t> head{0};
+  std::atomic<std::uint64_t> tail{0};
+  std::atomic<long> dropped{0};
+  bool owned{false}; // guarded by the logger mutex
+};
+
+class Logger {
+public:
+  std::mutex mutex;
+  std::condition_variable wake;
+  // rings of finished threads are handed to new ones, never freed
+  std::vector<std::unique_ptr<Ring>> rings;
+  std::string output;
+  std::thread drainer;
+
+  Logger() : mutex(), wake(), rings(), output(), drainer() {
+    output.reserve(1 << 16);
+    drainer = std::thread([this] {
+      std::unique_lock lock(mutex);
+      while (true) {
+        wake.wait_for(lock, DRAIN_INTERVAL);
+        drain();
+      }
+    });
+    drainer.detach();
+    std::atexit(flushLog);
+  }
+
+  // caller holds the mutex
+  void drain() {
+    static const char *prefixes[4]{"debug: ", "", "warning: ", "error: "};
+    for (const std::unique_ptr<Ring> &ring : rings) {
+      const std::uint64_t tail{ring->tail.load(std::memory_order_relaxed)};
+      const std::uint64_t head{ring->head.load(std::memory_order_acquire)};
+      for (std::uint64_t i = tail; i < head; i++) {
+        const Entry &entry{ring->entries[i % RING_ENTRIES]};
+        output += prefixes[static_cast<int>(entry.level)];
+        output.append(entry.text, entry.length);
+        output += '\n';
+      }
+      ring->tail.store(head, std::memory_order_release);
+      if (long dropped = ring->dropped.exchange(0); dropped != 0)
+        output += "warning: " + std::to_string(dropped) +
+                  " log messages dropped\n";
+    }
+    if (output.empty())
+      return;
+    std::fwrite(output.data(), 1, output.size(), stderr);
+    std::fflush(stderr);
+    output.clear();
+  }
+
+  Ring *acquire() {
+    std::lock_guard lock(mutex);
+    drain(); // a ring left by a finished thread may be full
+    for (const std::unique_ptr<Ring> &ring : rings)
+      if (!ring->owned) {
+        ring->owned = true;
+        return ring.get();
+      }
+    rings.push_back(std::make_unique<Ring>());
+    rings.back()->owned = true;
+    return rings.back().get();
+  }
+
+  void release(Ring *ring) {
+    std::lock_guard lock(mutex);
+    ring->owned = false; // entries left in it are still drained
+  }
+};
+
+// never destroyed, threads may log while statics are torn down
+Logger &logger() {
+  static Logger *instance{new Logger()};
+  return *instance;
+}
+
+struct ThreadRing {
+  Ring *ring{nullptr};
+  ~ThreadRing() {
+    if (ring != nullptr)
+      logger().release(ring);
+  }
+};
+thread_local ThreadRing threadRing;
+
+} // namespace
+
+void gamespace::logMessage(LogLevel level, const char *format, ...) {
+  if (threadRing.ring == nullptr)
+    threadRing.ring = logger().acquire();
+  Ring &ring{*threadRing.ring};
+  const std::uint64_t head{ring.head.load(std::memory_order_relaxed)};
+  if (head - ring.tail.load(std::memory_order_acquire) == RING_ENTRIES) {
+    ring.dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  Entry &entry{ring.entries[head % RING_ENTRIES]};
+  va_list arguments;
+  va_start(arguments, format);
+  const int length{std::vsnprintf(entry.text, MESSAGE_SIZE, format, arguments)};
+  va_end(arguments);
+  entry.length = length < 0 ? 0 : std::min(length, MESSAGE_SIZE - 1);
+  entry.level = level;
+  ring.head.store(head + 1, std::memory_order_release);
+  if (level == LogLevel::ERROR)
+    logger().wake.notify_one();
+}
+
+void gamespace::flushLog() {
+  Logger &l{logger()};
+  std::lock_guard lock(l.mutex);
+  l.drain();
+}
@@ -0,0 +1,46 @@
+#ifndef LOG_H
+#define LOG_H
+
+// messages below this level are compiled out: 0 debug, 1 info, 2 warning,
+// 3 error. Debug builds keep everything, release builds start at info.
+#ifndef LUDO_LOG_LEVEL
+#ifdef NDEBUG
+#define LUDO_LOG_LEVEL 1
+#else
+#define LUDO_LOG_LEVEL 0
+#endif
+#endif
+
+namespace gamespace {
+
+enum class LogLevel { DEBUG, INFO, WARNING, ERROR };
+
+/**
+ * @brief printf style message, formatted on the calling thread into a ring
+ * buffer that only this thread writes, so logging never takes a lock or
+ * allocates. A background thread writes the rings to stderr every few
+ * milliseconds, right away for errors. Messages are in order per thread,
+ * a full ring drops messages and says how many.
+ *
+ * Use the LOG_ macros, they skip the call and its arguments entirely below
+ * LUDO_LOG_LEVEL.
+ */
+void logMessage(LogLevel level, const char *format, ...)
+    __attribute__((format(printf, 2, 3)));
+
+// writes everything logged so far, also runs at exit
+void flushLog();
+
+} // namespace gamespace
+
+#define LUDO_LOG(level, ...)                                                   \
+  do {                                                                         \
+    if constexpr (static_cast<int>(level) >= LUDO_LOG_LEVEL)                   \
+      ::gamespace::logMessage(level, __VA_ARGS__);                             \
+  } while (false)
+#define LOG_DEBUG(...) LUDO_LOG(::gamespace::LogLevel::DEBUG, __VA_ARGS__)
+#define LOG_INFO(...) LUDO_LOG(::gamespace::LogLevel::INFO, __VA_ARGS__)
+#define LOG_WARNING(...) LUDO_LOG(::gamespace::LogLevel::WARNING, __VA_ARGS__)
+#define LOG_ERROR(...) LUDO_LOG(::gamespace::LogLevel::ERROR, __VA_ARGS__)
+
+#endif
@@ -1,10 +1,17 @@
 #include <SDL3/SDL.h>
+#include "config.h"
 #include "controller.h"
 
 using namespace gamespace;
 
-int main(){
-  Controller game;
-  game.startMainLoop();
-  return 0;
+int main(int argc, char *argv[]){
+  const GameConfig config{parseArguments(argc, argv)};
+  if (config.headless) {
+    // must be set before the View initializes SDL
+    SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen");
+    SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+    SDL_SetHint(SDL_HINT_AUDIO_DRIVER, "dummy");
+  }
+  Controller game(config);
+  return game.startMainLoop() ? 0 : 1;
 }
\ No newline at end of file
@@ -1,167 +1,141 @@
+#include <algorithm>
 #include <array>
 #include <chrono>
-#include <iostream>
+#include <cstdio>
+#include <functional>
 
 #include <SDL3/SDL_events.h>
+#include <SDL3/SDL_timer.h>
 #include <chrono>
-#include <limits>
+#include <bit>
 #include <string>
-#include <thread>
 #include <unistd.h>
 #include <unordered_map>
-#include <unordered_set>
 
 #include "SDL3/SDL_error.h"
 #include "SDL3/SDL_keycode.h"
+#include "alloccount.h"
+#include "analysis.h"
 #include "commons.h"
+#include "engine.h"
+#include "evalcache.h"
+#include "history.h"
+#include "journal.h"
+#include "latency.h"
+#include "log.h"
 #include "model.h"
+#include "network.h"
+#include "spectate.h"
 #include "view.h"
 
 using namespace std::literals;
 using namespace gamespace;
 
-// IDK WHY, but this requires the gamespace namespace prefix, otherwise not
-// declared properly, see https://stackoverflow.com/a/29067357 for more details
-std::ostream &gamespace::operator<<(std::ostream &os, const Player &p) {
-  return os << "Player{" << p.type << ',' << p.color << '}';
-}
-std::ostream &gamespace::operator<<(std::ostream &os,
-                                    const Player::PlayerColor &c) {
-  os << "GColor{";
-  if (c == Player::PlayerColor::RED)
-    os << "RED";
-  if (c == Player::PlayerColor::GREEN)
-    os << "GREEN";
-  if (c == Player::PlayerColor::YELLOW)
-    os << "YELLOW";
-  if (c == Player::PlayerColor::BLUE)
-    os << "BLUE";
-  return os << '}';
-}
-std::ostream &gamespace::operator<<(std::ostream &os,
-                                    const Player::PlayerType &t) {
-  os << "PlayerType{";
-  if (t == Player::PlayerType::HUMAN)
-    os << "HUMAN";
-  if (t == Player::PlayerType::ROBOT)
-    os << "ROBOT";
-  return os << '}';
-}
-std::ostream &gamespace::operator<<(std::ostream &os, const BoardPosition &p) {
-  return os << "BoardPosition{" << p.pos << '}';
-}
-std::ostream &gamespace::operator<<(std::ostream &os, Piece const &p) {
-  return os << "Piece{" << (p._player) << ',' << p.pos << '}';
-}
-
-BoardPosition::BoardPosition(int position) : pos(position) {
-  if (pos > 91 || pos < 0)
-    (std::cerr << "Invalid position " << pos).flush();
-}
-
-constexpr bool BoardPosition::isInitialPosition() const {
-  // stuck on square
-  return pos >= 76 && pos <= 91;
-}
-
-constexpr bool BoardPosition::isFinalPosition(int position) {
-  return position == 69 || position == 63 || position == 75 || position == 57;
-}
-
-constexpr bool BoardPosition::isFinalPosition() const {
-  return BoardPosition::isFinalPosition(pos);
-}
-
-// #GoofyEncoding
-int BoardPosition::getNext(int pos, const Player::PlayerColor &color) {
-  // TODO: handle erroneous positions
-  if (pos > 91 || pos < 0) {
-    (std::cerr << "Invalid position " << pos).flush();
-    return -1;
-  }
-  if (pos >= 76 && pos <= 79)
-    return 0;
-  if (pos >= 80 && pos <= 83)
-    return 13;
-  if (pos >= 84 && pos <= 87)
-    return 26;
-  if (pos >= 88 && pos <= 91)
-    return 39;
-  if (pos == 50 && color == Player::PlayerColor::RED)
-    return 52;
-  if (pos == 11 && color == Player::PlayerColor::GREEN)
-    return 58;
-  if (pos == 24 && color == Player::PlayerColor::YELLOW)
-    return 64;
-  if (pos == 37 && color == Player::PlayerColor::BLUE)
-    return 70;
-  if (pos <= 56 && pos >= 52 && color == Player::PlayerColor::RED)
-    return pos + 1;
-  if (pos <= 62 && pos >= 58 && color == Player::PlayerColor::GREEN)
-    return pos + 1;
-  if (pos <= 68 && pos >= 64 && color == Player::PlayerColor::YELLOW)
-    return pos + 1;
-  if (pos <= 74 && pos >= 70 && color == Player::PlayerColor::BLUE)
-    return pos + 1;
-  return (pos + 1) % 52;
-}
-
-bool Piece::canAdvance(int diceValue) const {
-  // brief assuming diceValue \in [1,6]
-  // TODO: verify
-  if (pos.isFinalPosition())
-    return false;
-  if (pos.isInitialPosition())
-    return diceValue == 6;
-  int _pos{pos.pos};
-  int nextPos;
-  while (diceValue--) { // >0
-    nextPos = BoardPosition::getNext(_pos, _player.color);
-    if (nextPos == _pos)
-      return false;
-  }
-  return true;
-}
-
-void Piece::advance(int diceValue) {
-  // TODO check
-  if (pos.isInitialPosition()) {
-    pos.pos = BoardPosition::getNext(pos.pos, _player.color);
-    return;
-  }
-  while (diceValue--)
-    pos.pos = BoardPosition::getNext(pos.pos, _player.color);
-}
-
-const Player Piece::defaultPlayer(Player::PlayerType::ROBOT,
-                                  Player::PlayerColor::RED);
-Game::Game()
-    : view(), audioManager(), playerIdToPieces(), players(0),
-      hightLightedPieces(0), dice(), phase(Phase::CONFIG), currentPlayer(0),
-      repetitionCounter(0), currentPlayerPlayed(false),
-      currentPlayerRolled(false), canAdvance(false) {
-  // change later to use the config phase, for now assume 4 players
+// positions the history holds before it allocates, a long 4 player game
+// has about a thousand
+static const size_t HISTORY_POSITIONS{1 << 12};
+
+Game::Game(Scheduler &scheduler, const GameConfig &config)
+    : view(false, config.softwareRenderer ? Backend::SOFTWARE : Backend::SDL),
+      audioManager(), playerIdToPieces(), players(0), rules(config.rules),
+      highlightedPieces(0), dice(), phase(Phase::CONFIG), currentPlayer(0),
+      repetitionCounter(0), currentPlayerRolled(false),
+      moveTimeMs(config.moveTimeMs), timeWarp(1), gamesPlayed(0), engines(),
+      hints(config.hints), hintedPiece(-1), workers(),
+      estimator(config.showAnalysis
+                    ? std::make_unique<WinEstimator>(workers, config.rules)
+                    : nullptr),
+      search(std::make_unique<SpeculativeSearch>(workers, config.rules)),
+      network(),
+      thumbnailPath(config.thumbnailPath),
+      thumbnailTemporary(config.thumbnailPath + ".tmp.png"),
+      thumbnailStale(true), nextThumbnail(),
+      allocationCheck(config.checkAllocationTurns > 0
+                          ? std::make_unique<AllocationCheck>(
+                                2 * config.numPlayers,
+                                config.checkAllocationTurns)
+                          : nullptr),
+      journal(config.journalPath.empty() ? nullptr
+                                         : std::make_unique<GameJournal>()),
+      spectators(config.spectatePort > 0 ? std::make_unique<SpectatorHub>()
+                                         : nullptr),
+      journalGame(0), history(HISTORY_POSITIONS), scheduler(scheduler),
+      input(scheduler),
+      latency(config.measureLatency ? std::make_unique<LatencyStats>()
+                                    : nullptr),
+      turns() {
+  // the config phase is the command line for now, see GameConfig
   // --------------------------------------------------------------
-  players.push_back(
-      Player(Player::PlayerType::HUMAN, Player::PlayerColor::RED));
-  players.push_back(
-      Player(Player::PlayerType::HUMAN, Player::PlayerColor::GREEN));
-  players.push_back(
-      Player(Player::PlayerType::HUMAN, Player::PlayerColor::YELLOW));
-  players.push_back(
-      Player(Player::PlayerType::HUMAN, Player::PlayerColor::BLUE));
+  static const Player::PlayerColor colors[4]{
+      Player::PlayerColor::RED, Player::PlayerColor::GREEN,
+      Player::PlayerColor::YELLOW, Player::PlayerColor::BLUE};
+  for (int seat = 0; seat < config.numPlayers; seat++) {
+    // same seating as Rules::seatColor
+    Player::PlayerColor color{
+        colors[config.numPlayers == 2 ? 2 * seat : seat]};
+    engines[color] = EnginePool::shared().get(config.engines[color]);
+    if (engines[color] != nullptr)
+      engines[color]->newGame();
+    const bool robot{!config.engines[color].empty() || config.bots[color]};
+    players.push_back(Player(
+        robot ? Player::PlayerType::ROBOT : Player::PlayerType::HUMAN, color));
+  }
   phase = Phase::PLAY;
   // --------------------------------------------------------------
+  if (!config.modelPath.empty()) {
+    network = std::make_unique<ValueNetwork>();
+    if (!network->load(config.modelPath)) {
+      LOG_WARNING("Bots search instead of using [%s]",
+                  config.modelPath.c_str());
+      network.reset();
+    }
+  }
+  if (config.timeWarp != 1) {
+    if (std::all_of(players.begin(), players.end(), [](const Player &p) {
+          return p.type == Player::PlayerType::ROBOT;
+        }))
+      timeWarp = config.timeWarp;
+    else
+      LOG_WARNING("--warp needs a bot or an engine on every seat, playing "
+                  "in real time");
+  }
+  if (journal != nullptr && rules != RuleSet::CLASSIC) {
+    // its rolls are checked against the classic rules when restoring
+    LOG_WARNING("The journal replays classic games only, playing without");
+    journal.reset();
+  }
+  if (spectators != nullptr && !spectators->start(config.spectatePort)) {
+    LOG_WARNING("Playing without spectators");
+    spectators.reset();
+  }
   setUpPieces();
+  restoreGame(config.journalPath);
+  resetHistory();
+  startAnalysis();
+  turns = playTurns();
+  scheduler.post(turns.handle());
 }
 
-const std::array<int, 4> &Player::getJailPositions() const {
-  static const std::unordered_map<Player::PlayerColor, std::array<int, 4>>
-      jailPositions{{{Player::PlayerColor::RED, {76, 77, 78, 79}},
-                     {Player::PlayerColor::GREEN, {80, 81, 82, 83}},
-                     {Player::PlayerColor::YELLOW, {84, 85, 86, 87}},
-                     {Player::PlayerColor::BLUE, {88, 89, 90, 91}}}};
-  return jailPositions.at(color);
+Game::~Game() {
+  scheduler.forget(turns.handle());
+  const EvaluationCache::Stats cache{EvaluationCache::shared().getStats()};
+  if (cache.hits + cache.misses > 0)
+    LOG_INFO("move cache: %ld hits, %ld misses, %ld evictions, %zu of %zu "
+             "entries",
+             cache.hits, cache.misses, cache.evictions, cache.size,
+             cache.capacity);
+  if (spectators != nullptr) {
+    const SpectatorHub::Stats stats{spectators->getStats()};
+    LOG_INFO("spectators: %ld connected, %ld skipped ahead, %ld frames "
+             "dropped",
+             stats.spectators, stats.skips, stats.dropped);
+  }
+  if (latency != nullptr) {
+    char text[96];
+    latency->format(text, sizeof(text));
+    LOG_INFO("input to present latency: %s, %ld inputs dropped", text,
+             input.getDropped());
+  }
 }
 
 void Game::setUpPieces() {
@@ -172,98 +146,6 @@ void Game::setUpPieces() {
   }
 }
 
-// #GoofyEncoding
-int BoardPosition::toPositionId(int x, int y) {
-  // this code is shit, the circles are not aligned to the tiles
-  if ((x == 1 || x == 2) && (y == 1 || y == 2))
-    return 82;
-  if ((x == 3 || x == 4) && (y == 1 || y == 2))
-    return 83;
-  if ((x == 1 || x == 2) && (y == 3 || y == 4))
-    return 81;
-  if ((x == 3 || x == 4) && (y == 3 || y == 4))
-    return 80;
-  if ((x == 10 || x == 11) && (y == 1 || y == 2))
-    return 84;
-  if ((x == 12 || x == 13) && (y == 1 || y == 2))
-    return 85;
-  if ((x == 10 || x == 11) && (y == 3 || y == 4))
-    return 86;
-  if ((x == 12 || x == 13) && (y == 3 || y == 4))
-    return 87;
-  if ((x == 3 || x == 4) && (y == 10 || y == 11))
-    return 76;
-  if ((x == 3 || x == 4) && (y == 13 || y == 12))
-    return 77;
-  if ((x == 1 || x == 2) && (y == 12 || y == 13))
-    return 78;
-  if ((x == 1 || x == 2) && (y == 10 || y == 11))
-    return 79;
-
-  if ((x == 12 || x == 13) && (y == 10 || y == 11))
-    return 88;
-  if ((x == 10 || x == 11) && (y == 10 || y == 11))
-    return 89;
-  if ((x == 10 || x == 11) && (y == 12 || y == 13))
-    return 90;
-  if ((x == 12 || x == 13) && (y == 12 || y == 13))
-    return 91;
-
-  static const std::unordered_map<std::string, int> offsetToPosition{
-      {"6-13", 0},   {"6-12", 1},  {"6-11", 2},  {"6-10", 3},   {"6-9", 4},
-      {"5-8", 5},    {"4-8", 6},   {"3-8", 7},   {"2-8", 8},    {"1-8", 9},
-      {"0-8", 10},   {"0-7", 11},  {"0-6", 12},  {"1-6", 13},   {"2-6", 14},
-      {"3-6", 15},   {"4-6", 16},  {"5-6", 17},  {"6-5", 18},   {"6-4", 19},
-      {"6-3", 20},   {"6-2", 21},  {"6-1", 22},  {"6-0", 23},   {"7-0", 24},
-      {"8-0", 25},   {"8-1", 26},  {"8-2", 27},  {"8-3", 28},   {"8-4", 29},
-      {"8-5", 30},   {"9-6", 31},  {"10-6", 32}, {"11-6", 33},  {"12-6", 34},
-      {"13-6", 35},  {"14-6", 36}, {"14-7", 37}, {"14-8", 38},  {"13-8", 39},
-      {"12-8", 40},  {"11-8", 41}, {"10-8", 42}, {"9-8", 43},   {"8-9", 44},
-      {"8-10", 45},  {"8-11", 46}, {"8-12", 47}, {"8-13", 48},  {"8-14", 49},
-      {"7-14", 50},  {"6-14", 51}, {"7-13", 52}, {"7-12", 53},  {"7-11", 54},
-      {"7-10", 55},  {"7-9", 56},  {"7-8", 57},  {"1-7", 58},   {"2-7", 59},
-      {"3-7", 60},   {"4-7", 61},  {"5-7", 62},  {"6-7", 63},   {"7-1", 64},
-      {"7-2", 65},   {"7-3", 66},  {"7-4", 67},  {"7-5", 68},   {"7-6", 69},
-      {"13-7", 70},  {"12-7", 71}, {"11-7", 72}, {"10-7", 73},  {"9-7", 74},
-      {"8-7", 75},   {"4-11", 76}, {"4-13", 77}, {"2-13", 78},  {"2-11", 79},
-      {"4-4", 80},   {"2-4", 81},  {"2-2", 82},  {"4-2", 83},   {"11-2", 84},
-      {"13-2", 85},  {"11-4", 86}, {"13-4", 87}, {"13-11", 88}, {"11-11", 89},
-      {"11-13", 90}, {"13-13", 91}};
-  std::string key{std::to_string(x) + '-' + std::to_string(y)};
-  if (offsetToPosition.contains(key))
-    return offsetToPosition.at(key);
-  else
-    return -1;
-}
-
-BoardPosition BoardPosition::toPosition(int x, int y) {
-  return BoardPosition(BoardPosition::toPositionId(x, y));
-}
-
-std::pair<int, int> BoardPosition::toXYOffset(int pos) {
-  static constexpr std::array<std::pair<int, int>, NUM_POSITIONS>
-      positionToXYOffset(
-          {{6, 13}, {6, 12}, {6, 11}, {6, 10}, {6, 9},   {5, 8},   {4, 8},
-           {3, 8},  {2, 8},  {1, 8},  {0, 8},  {0, 7},   {0, 6},   {1, 6},
-           {2, 6},  {3, 6},  {4, 6},  {5, 6},  {6, 5},   {6, 4},   {6, 3},
-           {6, 2},  {6, 1},  {6, 0},  {7, 0},  {8, 0},   {8, 1},   {8, 2},
-           {8, 3},  {8, 4},  {8, 5},  {9, 6},  {10, 6},  {11, 6},  {12, 6},
-           {13, 6}, {14, 6}, {14, 7}, {14, 8}, {13, 8},  {12, 8},  {11, 8},
-           {10, 8}, {9, 8},  {8, 9},  {8, 10}, {8, 11},  {8, 12},  {8, 13},
-           {8, 14}, {7, 14}, {6, 14}, {7, 13}, {7, 12},  {7, 11},  {7, 10},
-           {7, 9},  {7, 8},  {1, 7},  {2, 7},  {3, 7},   {4, 7},   {5, 7},
-           {6, 7},  {7, 1},  {7, 2},  {7, 3},  {7, 4},   {7, 5},   {7, 6},
-           {13, 7}, {12, 7}, {11, 7}, {10, 7}, {9, 7},   {8, 7},   {4, 11},
-           {4, 13}, {2, 13}, {2, 11}, {4, 4},  {2, 4},   {2, 2},   {4, 2},
-           {11, 2}, {13, 2}, {11, 4}, {13, 4}, {13, 11}, {11, 11}, {11, 13},
-           {13, 13}});
-  return positionToXYOffset.at(pos);
-}
-
-std::pair<int, int> BoardPosition::toXYOffset() const {
-  return BoardPosition::toXYOffset(pos);
-}
-
 Color gamespace::toPhysicalColor(const Player::PlayerColor &c) {
   if (c == Player::PlayerColor::BLUE)
     return Color::BLUE;
@@ -280,264 +162,629 @@ Color gamespace::toPhysicalColor(const Player::PlayerColor &c) {
  * Assumes the pieces are at the same BoardPosition.
  * At most 4 pieces can be displayed on one tile
  */
-void Game::arrangePiecesAtPosition(std::vector<Piece> &pieces) {
-  size_t n{pieces.size()};
-  if (n < 1)
-    std::cerr << "Goofy error" << std::endl, exit(0);
-  BoardPosition &position = pieces[0].pos;
-  auto [x, y] = position.toXYOffset();
-
-  if (n <= 4) {
-    view.drawPiece(x * TS + TS / 4, y * TS + TS / 4,
-                   toPhysicalColor(pieces[0].getColor()));
-    if (n >= 2)
-      view.drawPiece(x * TS + 3 * TS / 4, y * TS + TS / 4,
-                     toPhysicalColor(pieces[1].getColor()));
-    if (n >= 3)
-      view.drawPiece(x * TS + TS / 4, y * TS + 3 * TS / 4,
-                     toPhysicalColor(pieces[2].getColor()));
-    if (n >= 4)
-      view.drawPiece(x * TS + 3 * TS / 4, y * TS + 3 * TS / 4,
-                     toPhysicalColor(pieces[3].getColor()));
-    return;
+void Game::arrangePiecesAtPosition(std::span<const Piece *const> pieces) {
+  if (pieces.empty()) {
+    LOG_ERROR("Goofy error");
+    exit(0);
   }
-
-  // at most 4 pieces are shown
-  Piece *piecesSample[4];
-  for (int i = 0; i < 4; i++)
-    piecesSample[i] = nullptr;
-  int counter{0};
-  counter = 0;
-  std::unordered_set<Player::PlayerColor> seenColors;
-  for (Piece &piece : pieces) {
-    if (seenColors.contains(piece.getColor()))
-      continue;
-    seenColors.insert(piece.getColor());
-    piecesSample[counter++] = &piece;
+  auto [x, y] = pieces[0]->pos.toXYOffset();
+
+  // at most 4 pieces are shown, one of every color first
+  const Piece *sample[4];
+  size_t shown{0};
+  if (pieces.size() <= 4) {
+    for (const Piece *piece : pieces)
+      sample[shown++] = piece;
+  } else {
+    unsigned seenColors{0};
+    for (const Piece *piece : pieces) {
+      const unsigned color{1u << piece->getColor()};
+      if (seenColors & color)
+        continue;
+      seenColors |= color;
+      sample[shown++] = piece;
+    }
+    for (const Piece *piece : pieces) {
+      if (shown == 4)
+        break;
+      if (std::find(sample, sample + shown, piece) == sample + shown)
+        sample[shown++] = piece;
+    }
   }
-  view.drawPiece(x * TS + TS / 4, y * TS + TS / 4,
-                 toPhysicalColor(piecesSample[0]->getColor()));
-  view.drawPiece(x * TS + 3 * TS / 4, y * TS + TS / 4,
-                 toPhysicalColor(piecesSample[1]->getColor()));
-  view.drawPiece(x * TS + TS / 4, y * TS + 3 * TS / 4,
-                 toPhysicalColor(piecesSample[2]->getColor()));
-  view.drawPiece(x * TS + 3 * TS / 4, y * TS + 3 * TS / 4,
-                 toPhysicalColor(piecesSample[3]->getColor()));
+  static const int offsets[4][2]{{1, 1}, {3, 1}, {1, 3}, {3, 3}};
+  const int ts{view.getLayout().tileSize};
+  for (size_t i = 0; i < shown; i++)
+    view.drawPiece(x * ts + offsets[i][0] * ts / 4,
+                   y * ts + offsets[i][1] * ts / 4,
+                   toPhysicalColor(sample[i]->getColor()));
 }
 
 void Game::drawPieces() {
-  // VADE RETRO SATANA
-  // 17 is the smallest prime larger than 16, there will be at most 16
-  // pieces in a game
-  std::unordered_map<int, std::vector<Piece>> positionToPieces(17);
-  for (const auto &[id, pieces] : playerIdToPieces) {
+  // at most 16 pieces, sorted so the ones sharing a tile are next to each
+  // other
+  std::array<const Piece *, 16> sorted;
+  size_t n{0};
+  for (const auto &[id, pieces] : playerIdToPieces)
     for (const Piece &p : pieces)
-      positionToPieces[p.pos.pos].push_back(p);
-  }
-  for (auto [position, piecesHere] : positionToPieces) {
-    if (piecesHere.empty())
-      std::cerr << "Bruh goofed up big time" << std::endl;
+      sorted[n++] = &p;
+  std::sort(sorted.begin(), sorted.begin() + n,
+            [](const Piece *a, const Piece *b) {
+              if (a->pos.pos != b->pos.pos)
+                return a->pos.pos < b->pos.pos;
+              return std::less<const Piece *>()(a, b);
+            });
+  for (size_t first = 0, last; first < n; first = last) {
+    const int position{sorted[first]->pos.pos};
+    for (last = first + 1; last < n && sorted[last]->pos.pos == position;
+         last++)
+      ;
     if (position >= 76) { // home square positions
-      if (piecesHere.size() != 1) {
-        (std::cerr << "Invalid board configuration at position " << position)
-            .flush();
+      if (last - first != 1) {
+        LOG_ERROR("Invalid board configuration at position %d", position);
         return;
       }
       auto [x, y] = BoardPosition::toXYOffset(position);
-      view.drawPiece(x * TS, y * TS, toPhysicalColor(piecesHere[0].getColor()));
+      const int ts{view.getLayout().tileSize};
+      view.drawPiece(x * ts, y * ts,
+                     toPhysicalColor(sorted[first]->getColor()));
       continue;
     } // else if
-    arrangePiecesAtPosition(piecesHere);
+    arrangePiecesAtPosition(
+        std::span<const Piece *const>(sorted.data() + first, last - first));
   }
 }
 
-BoardPosition BoardPosition::fromScreenFloats(float x, float y) {
-  // ignore inter circle space
-  if (((x >= 2.5 && x <= 3.4) || (x >= 11.5 && x <= 12.40)) &&
-      ((y >= 2.5 && y <= 3.4) || (y >= 11.5 && y <= 12.40)))
-    return BoardPosition(-1);
-  x = std::floor(x), y = std::floor(y);
-  return BoardPosition::toPosition(x, y);
-}
-
 void Game::render() {
-  view.updateWindowDimensions();
   if (phase == Phase::PLAY) {
+    const int ts{view.getLayout().tileSize};
     view.drawBoard();
     drawPieces();
     view.preparePlayerDice(toPhysicalColor(players.at(currentPlayer).color));
     if (currentPlayerRolled) {
       view.drawDice(toPhysicalColor(players[currentPlayer].color), dice.value);
-      if (hightLightedPieces.size() > 0) {
-        for (const Piece &p : hightLightedPieces) {
-          if (p.pos.isInitialPosition())
-            continue;
-          auto [x, y] = p.pos.toXYOffset();
-          view.highLightPosition(
-              x * TS, y * TS,
-              toPhysicalColor(
-                  players.at(currentPlayer).color)); // TS width and height
-        }
+      if (hintedPiece >= 0) {
+        const std::vector<Piece> &pieces =
+            playerIdToPieces.at(players.at(currentPlayer).color);
+        auto [x, y] = pieces.at(hintedPiece).pos.toXYOffset();
+        view.highLightPosition(x * ts, y * ts, Color::BLACK);
+      }
+      const std::vector<Piece> &pieces =
+          playerIdToPieces.at(players.at(currentPlayer).color);
+      for (int i = 0; i < 4; i++) {
+        if (!(highlightedPieces & (1u << i)) ||
+            pieces[i].pos.isInitialPosition())
+          continue;
+        auto [x, y] = pieces[i].pos.toXYOffset();
+        view.highLightPosition(
+            x * ts, y * ts,
+            toPhysicalColor(
+                players.at(currentPlayer).color)); // a tile wide and high
       }
     }
+    drawAnalysis();
+    saveThumbnail();
+  }
+  if (latency != nullptr) {
+    char text[64];
+    latency->format(text, sizeof(text));
+    view.drawStatus(text);
   }
   view.render();
+  if (latency != nullptr)
+    latency->presented(SDL_GetTicksNS());
+  if (allocationCheck != nullptr)
+    allocationCheck->frameEnded();
 }
 
-constexpr bool gamespace::operator==(const BoardPosition &a,
-                                     const BoardPosition &b) {
-  return a.pos == b.pos;
+// for --latency, the next present shows what the event did
+void Game::screenChanged(std::uint64_t eventTime) {
+  if (latency != nullptr)
+    latency->changed(eventTime);
 }
 
-void Game::handleMouseEvent() {
-  if (currentPlayerPlayed || !currentPlayerRolled)
+// the piece under the click when it happened, the game may still be
+// animating the roll and take it later
+void Game::handleMouseEvent(SDL_Event event) {
+  if (!currentPlayerRolled)
     return;
-  float x, y;
-  if (!SDL_GetMouseState(&x, &y)) {
-    (std::cerr << "Could not read mouse state [" << SDL_GetError() << "]")
-        .flush();
+  if (!view.toRenderCoordinates(event)) {
+    LOG_ERROR("Could not convert mouse position [%s]", SDL_GetError());
     return;
   }
-  x /= TS;
-  y /= TS;
+  const float ts(view.getLayout().tileSize);
+  const float x{event.button.x / ts}, y{event.button.y / ts};
   const BoardPosition clickedPosition = BoardPosition::fromScreenFloats(x, y);
-  std::vector<Piece> &playerPieces = playerIdToPieces.at(currentPlayer);
-  Piece *pieceToMove{nullptr};
-  for (Piece &p : playerPieces)
-    if (p.pos == clickedPosition) {
-      pieceToMove = &p;
-      break;
+  const std::vector<Piece> &playerPieces =
+      playerIdToPieces.at(players.at(currentPlayer).color);
+  for (int i = 0; i < 4; i++) {
+    if (playerPieces[i].pos != clickedPosition)
+      continue;
+    if (highlightedPieces & (1u << i)) {
+      input.push(i, event.button.timestamp);
+      return;
     }
-  if (pieceToMove == nullptr || !pieceToMove->canAdvance(dice.value)) {
-    (std::cerr << "No movable piece at clicked position").flush();
-    return;
+    break;
   }
+  LOG_DEBUG("No movable piece at clicked position");
+}
 
-  pieceToMove->advance(dice.value);
+// BasicRules does the moving, capturing and turn passing on a copy of
+// the position, the pieces are then put where it says
+bool Game::playMove(int piece) {
+  GameState state;
+  fillState(state); // from before the roll
+  bool captured{false}, over{false};
+  withRules(players.size(), rules, [&](auto tag) {
+    using R = decltype(tag);
+    typename R::State after{toState<R>(state)};
+    if (R::roll(after, dice.value) && piece >= 0)
+      captured = R::play(after, piece, dice.value);
+    over = R::isOver(after);
+    toGameState<R>(after, state);
+  });
+  for (size_t seat = 0; seat < players.size(); seat++) {
+    std::vector<Piece> &pieces = playerIdToPieces.at(players[seat].color);
+    for (int i = 0; i < 4; i++)
+      pieces[i].pos = BoardPosition(state.pieces[seat][i]);
+  }
+  // the others play on after a win, only --warp games end
+  if (state.currentPlayer != currentPlayer || over)
+    nextPlayer();
+  currentPlayerRolled = false;
+  hintedPiece = -1;
+  startAnalysis();
+  return captured;
+}
 
-  bool captured{false};
-  if (!pieceToMove->pos.isProtectedPosition()) {
-    std::vector<Piece *> capturedPieces;
-    capturedPieces.reserve(16);
-    for (auto &[id, pieces] : playerIdToPieces) {
-      for (Piece &p : pieces) {
-        if (p.pos != pieceToMove->pos ||
-            p.getColor() == pieceToMove->getColor())
-          continue;
-        capturedPieces.push_back(&p);
-        captured = true;
+static const auto ROLL_TIME{750ms}; // the dice animation
+static const auto HINT_TIME{100ms};
+static const auto POLL_TIME{1ms}; // between looks at a search in progress
+// of warped turns played before the main loop gets to draw a frame
+static const auto FRAME_TIME{16ms};
+// between two thumbnails, the last position is written once it is up
+static const auto THUMBNAIL_INTERVAL{1s};
+// what handleEvent delivers besides piece indices
+static const int ROLL_INPUT{-1};
+static const int HINT_INPUT{-2};
+static const int UNDO_INPUT{-3};
+static const int REDO_INPUT{-4};
+
+void Game::rollDice() {
+  dice.roll();
+  showRoll();
+  audioManager.playDiceRoll(); // only queues the sound, SDL plays it
+}
+
+void Game::showRoll() {
+  repetitionCounter++;
+  currentPlayerRolled = true;
+  GameState state;
+  fillState(state);
+  highlightedPieces = withRules(players.size(), rules, [&](auto tag) {
+    using R = decltype(tag);
+    typename R::State rolled{toState<R>(state)};
+    return R::roll(rolled, dice.value) ? R::legalMoves(rolled, dice.value)
+                                       : 0u;
+  });
+}
+
+/**
+ * The whole game as one coroutine. Every co_await hands the thread back to
+ * the main loop, which keeps drawing frames until the scheduler resumes
+ * the game: a human seat rolled or picked a piece, the dice animation
+ * ended or the search has an answer for a bot.
+ * Everything runs in this one frame, a nested coroutine would allocate
+ * its own on every call.
+ * Undo and redo start the turn over from wherever they went, which may be
+ * a roll that is waiting for its move.
+ */
+TurnLoop Game::playTurns() {
+  Clock::time_point rollsEnd{Clock::now()};
+  Clock::time_point frameEnd{Clock::now() + FRAME_TIME};
+  while (true) {
+    const int seat{currentPlayer};
+    const Player &player = players.at(seat);
+    const bool human{player.type == Player::PlayerType::HUMAN};
+    // a key pressed before the turn started is not for this turn
+    std::uint64_t rolledAt{SDL_GetTicksNS()};
+    bool travelled{false};
+    while (human && !currentPlayerRolled) {
+      const auto roll{co_await input.next(rolledAt)};
+      if (roll.value == ROLL_INPUT) {
+        rolledAt = roll.timestamp;
+        break;
+      }
+      if (travel(roll.value)) {
+        screenChanged(roll.timestamp);
+        travelled = true;
+        break;
+      }
+    }
+    if (travelled)
+      continue;
+    if (!currentPlayerRolled) {
+      rollDice();
+      if (human)
+        screenChanged(rolledAt);
+      if (timeWarp == 1) {
+        co_await scheduler.sleep(ROLL_TIME);
+      } else {
+        // the animations run on a clock of their own that may fall behind
+        // real time by a frame, a turn only waits when that clock is
+        // ahead. Turns that do not wait still let a frame through now and
+        // then.
+        rollsEnd = std::max(rollsEnd, Clock::now() - FRAME_TIME) +
+                   warped(ROLL_TIME);
+        if (rollsEnd > Clock::now() || Clock::now() >= frameEnd) {
+          co_await Scheduler::Sleep{scheduler, rollsEnd};
+          frameEnd = Clock::now() + FRAME_TIME;
+        }
+      }
+    }
+    if (highlightedPieces == 0) {
+      if (journal != nullptr)
+        journal->roll(journalGame, seat, dice.value, -1, 0, false);
+      playMove(-1); // a six with nothing to move still rolls again
+      remember(-1);
+      if (spectators != nullptr) {
+        GameState state;
+        fillState(state);
+        spectators->roll(state, players.size(), seat, dice.value, -1, 0,
+                         false);
+      }
+      continue;
+    }
+    startAnalysis();
+
+    int move{-1};
+    std::uint64_t chosenAt{0};
+    if (human) {
+      // clicks during the roll animation count, they come right after it
+      while (move < 0 && !travelled) {
+        const auto choice{co_await input.next(rolledAt)};
+        chosenAt = choice.timestamp;
+        if (choice.value >= 0 && (highlightedPieces & (1u << choice.value))) {
+          move = choice.value;
+        } else if (travel(choice.value)) {
+          screenChanged(chosenAt);
+          travelled = true;
+        } else if (choice.value == HINT_INPUT && hints) {
+          // the search had the whole roll animation to get ahead
+          search->focus(dice.value);
+          const Clock::time_point deadline{Clock::now() + HINT_TIME};
+          while (!search->ready(dice.value) && Clock::now() < deadline)
+            co_await scheduler.sleep(POLL_TIME);
+          hintedPiece = search->currentBest(dice.value);
+          screenChanged(chosenAt);
+        }
       }
+    } else if (EngineProcess *engine = engines.at(player.color)) {
+      // the engine keeps to its move time, frames go on meanwhile
+      const int id{askEngine(*engine)};
+      const Clock::time_point deadline{
+          Clock::now() +
+          std::chrono::milliseconds(moveTimeMs +
+                                    EngineProcess::MOVE_TIME_SLACK_MS)};
+      while (id >= 0 && !engine->answered(id) && Clock::now() < deadline)
+        co_await scheduler.sleep(POLL_TIME);
+      move = engineMove(*engine, id);
+    } else if (network != nullptr) {
+      // one batch over the legal moves, nothing to wait for
+      GameState state;
+      fillState(state);
+      state.repetitionCounter++; // fillState is from before the roll
+      move = network->chooseMove(state, players.size(), rules, dice.value);
+    } else {
+      search->focus(dice.value);
+      const Clock::time_point deadline{Clock::now() +
+                                       std::chrono::milliseconds(moveTimeMs)};
+      while (!search->ready(dice.value) && Clock::now() < deadline)
+        co_await scheduler.sleep(POLL_TIME);
+      move = search->currentBest(dice.value);
     }
-    for (Piece *capturedPiece : capturedPieces) {
-      capture(*capturedPiece);
+    if (travelled)
+      continue;
+    if (move < 0 || !(highlightedPieces & (1u << move)))
+      move = std::countr_zero(highlightedPieces); // the first movable piece
+    const bool captured{playMove(move)};
+    const Piece &piece = playerIdToPieces.at(player.color)[move];
+    if (journal != nullptr)
+      journal->roll(journalGame, seat, dice.value, move, piece.pos.pos,
+                    captured);
+    remember(move);
+    if (spectators != nullptr) {
+      GameState state;
+      fillState(state);
+      spectators->roll(state, players.size(), seat, dice.value, move,
+                       piece.pos.pos, captured);
+    }
+    if (human)
+      screenChanged(chosenAt);
+    if (hasWon(player.color)) {
+      if (journal != nullptr)
+        journal->endGame(journalGame, seat);
+      if (timeWarp != 1) {
+        LOG_INFO("game %ld won by seat %d", gamesPlayed + 1, seat);
+        newGame();
+      }
     }
   }
+}
 
-  if ((dice.value != 6 && !captured) || repetitionCounter >= 3)
-    currentPlayer = (currentPlayer + 1) % 4, repetitionCounter = 0;
-  currentPlayerPlayed = currentPlayerRolled = false;
-}
-
-bool BoardPosition::isProtectedPosition() const {
-  const static std::unordered_set<int> protectedPieces{0, 47, 39, 34,
-                                                       8, 13, 26, 21};
-  return protectedPieces.contains(pos);
-}
-
-void Game::capture(Piece &p) {
-  const static int redHomePositions[4]{76, 77, 78, 79};
-  const static int greenHomePositions[4]{80, 81, 82, 83};
-  const static int yellowHomePositions[4]{84, 85, 86, 87};
-  const static int blueHomePositions[4]{88, 89, 90, 91};
-  const int *homePositions;
-  Player::PlayerColor color = p.getColor();
-  if (color == Player::PlayerColor::RED)
-    homePositions = redHomePositions;
-  else if (color == Player::PlayerColor::GREEN)
-    homePositions = greenHomePositions;
-  else if (color == Player::PlayerColor::BLUE)
-    homePositions = blueHomePositions;
-  else if (color == Player::PlayerColor::YELLOW)
-    homePositions = yellowHomePositions;
-  else {
-    (std::cerr << "Invalid piece color detected during capture" << std::endl)
-        .flush();
-    return;
+void Game::nextPlayer() {
+  currentPlayer = (currentPlayer + 1) % players.size();
+  repetitionCounter = 0;
+  if (allocationCheck != nullptr)
+    allocationCheck->turnEnded();
+}
+
+bool Game::hasWon(Player::PlayerColor color) const {
+  const std::vector<Piece> &pieces = playerIdToPieces.at(color);
+  return std::all_of(pieces.begin(), pieces.end(), [](const Piece &p) {
+    return p.pos.isFinalPosition();
+  });
+}
+
+// only --warp games end, the next one starts right away
+void Game::newGame() {
+  gamesPlayed++;
+  for (const Player &player : players) {
+    std::vector<Piece> &pieces = playerIdToPieces.at(player.color);
+    const std::array<int, 4> &jailPositions = player.getJailPositions();
+    for (int i = 0; i < 4; i++)
+      pieces[i].pos = BoardPosition(jailPositions[i]);
+    if (EngineProcess *engine = engines.at(player.color))
+      engine->newGame();
   }
-  std::unordered_map<int, std::vector<Piece>> positionToPieces(5);
-  for (const Piece &p : playerIdToPieces.at(p.getColor())) {
-    if (positionToPieces.contains(p.pos.pos))
-      positionToPieces.at(p.pos.pos).push_back(p);
-    else
-      positionToPieces[p.pos.pos] = {p};
+  currentPlayer = 0;
+  repetitionCounter = 0;
+  currentPlayerRolled = false;
+  highlightedPieces = 0;
+  if (journal != nullptr)
+    journalGame = journal->startGame(players.size());
+  resetHistory();
+  startAnalysis();
+}
+
+// the last game of the journal with as many players carries on, a new one
+// is started otherwise. The others are given up, nothing would ever end
+// them and they would be carried through every compaction.
+void Game::restoreGame(const std::string &journalPath) {
+  if (journal == nullptr)
+    return;
+  if (!journal->open(journalPath)) {
+    journal.reset();
+    return;
   }
-  int position;
-  for (int i = 0; i < 4; i++) {
-    position = homePositions[i];
-    if (positionToPieces.contains(position))
-      continue;
-    p.pos = BoardPosition(position);
+  const std::vector<GameJournal::RunningGame> &games{journal->restored()};
+  auto resumed{std::find_if(
+      games.rbegin(), games.rend(), [&](const GameJournal::RunningGame &g) {
+        return g.numPlayers == static_cast<int>(players.size());
+      })};
+  for (auto game = games.rbegin(); game != games.rend(); game++)
+    if (game != resumed)
+      journal->endGame(game->id, -1);
+  if (resumed == games.rend()) {
+    journalGame = journal->startGame(players.size());
     return;
   }
-  // crashes if reaches this point without returning
-  (std::cerr << "Could not return piece to home position" << std::endl).flush();
-  exit(0);
+  loadState(resumed->state);
+  journalGame = resumed->id;
+  LOG_INFO("Restored game %u from [%s]", resumed->id, journalPath.c_str());
 }
 
-static int ROLL_TIME{750};
+// pieces and turn as in state, nobody has rolled yet
+void Game::loadState(const GameState &state) {
+  for (size_t seat = 0; seat < players.size(); seat++) {
+    std::vector<Piece> &pieces = playerIdToPieces.at(players[seat].color);
+    for (int i = 0; i < 4; i++)
+      pieces[i].pos = BoardPosition(state.pieces[seat][i]);
+  }
+  currentPlayer = state.currentPlayer;
+  repetitionCounter = state.repetitionCounter;
+  currentPlayerRolled = false;
+  highlightedPieces = 0;
+  hintedPiece = -1;
+}
 
-void Game::handleSpaceKeyDown() {
-  if (currentPlayerRolled)
-    return;
-  dice.roll();
-  repetitionCounter++;
-  currentPlayerRolled = true;
-  hightLightedPieces.clear();
-  canAdvance = false;
-  for (const Piece &p : playerIdToPieces.at(currentPlayer)) {
-    if (p.canAdvance(dice.value)) {
-      hightLightedPieces.push_back(p);
-      canAdvance = true;
+// the current position becomes the first one, undo stops there
+void Game::resetHistory() {
+  GameState state;
+  fillState(state);
+  history.reset(state);
+  if (spectators != nullptr)
+    spectators->position(state, players.size());
+}
+
+// after every roll, piece is the one it moved or -1
+void Game::remember(int piece) {
+  GameState state;
+  fillState(state);
+  history.play(state, dice.value, piece);
+}
+
+bool Game::isHuman(int seat) const {
+  return players.at(seat).type == Player::PlayerType::HUMAN;
+}
+
+/**
+ * Undo goes back to the last move of a human seat with its dice showing,
+ * so another piece can be tried, what was played after it stays in the
+ * history. Redo follows the line played last up to the next turn of a
+ * human seat. False when there is nowhere to go.
+ * The journal cannot take back rolls, its game is given up and a new one
+ * starts from the position travelled to.
+ */
+bool Game::travel(int direction) {
+  const std::uint32_t from{history.current()};
+  int rolled{0}; // the dice of the move undone
+  if (direction == UNDO_INPUT) {
+    while (rolled == 0) {
+      const GameHistory::Node &left{history.position()};
+      if (!history.undo())
+        break;
+      if (left.piece >= 0 && isHuman(history.position().state.currentPlayer))
+        rolled = left.dice;
     }
+    if (rolled == 0) {
+      history.jump(from);
+      return false;
+    }
+  } else if (direction == REDO_INPUT) {
+    if (!history.redo())
+      return false;
+    while (!isHuman(history.position().state.currentPlayer) && history.redo())
+      ;
+  } else {
+    return false;
+  }
+  const GameState &state{history.position().state};
+  loadState(state);
+  if (spectators != nullptr)
+    spectators->position(state, players.size());
+  if (journal != nullptr) {
+    journal->endGame(journalGame, -1);
+    journalGame = journal->startGame(players.size(), state);
   }
+  startAnalysis(); // the search starts from before the roll
+  if (rolled != 0) {
+    dice.value = rolled;
+    showRoll();
+  }
+  return true;
+}
+
+// --warp 0 waits for nothing
+Clock::duration Game::warped(Clock::duration duration) const {
+  if (timeWarp == 0)
+    return Clock::duration::zero();
+  return std::chrono::duration_cast<Clock::duration>(duration / timeWarp);
+}
 
-  // yes it's inefficient, look idc, this projects is taking too long
-  auto audioCallBack = [this](){audioManager.playDiceRoll();};
-  std::thread audioThread(audioCallBack);
-  renderFor(ROLL_TIME);
-  audioThread.join();
-
-  // flush all events that may have happened during the timeout
-  SDL_PumpEvents(); // dark magic to transfer all os events to the queue
-                    // still no clue how events internally work in SDL,
-                    // life is short
-  SDL_FlushEvents(std::numeric_limits<uint32_t>::min(),
-                  std::numeric_limits<uint32_t>::max());
-
-  if (!canAdvance && (dice.value != 6 || repetitionCounter >= 3)) {
-    repetitionCounter = 0;
-    currentPlayer = (currentPlayer + 1) % 4;
-    currentPlayerPlayed = currentPlayerRolled = false;
+bool Game::finished() const {
+  return allocationCheck != nullptr && allocationCheck->finished();
+}
+
+bool Game::reportAllocations() const {
+  return allocationCheck == nullptr || allocationCheck->report();
+}
+
+// position from before the roll, which is what the search and the
+// estimator both start from
+void Game::fillState(GameState &state) const {
+  for (size_t seat = 0; seat < players.size(); seat++) {
+    const std::vector<Piece> &pieces = playerIdToPieces.at(players[seat].color);
+    for (int i = 0; i < 4; i++)
+      state.pieces[seat][i] = pieces[i].pos.pos;
   }
+  state.currentPlayer = currentPlayer;
+  state.repetitionCounter = repetitionCounter - (currentPlayerRolled ? 1 : 0);
+  state.winner = -1;
 }
 
-void Game::renderFor(int milliseconds) {
-  std::chrono::time_point start = std::chrono::system_clock::now();
-  while (true) {
-    render();
-    if (std::chrono::system_clock::now() - start >
-        std::chrono::milliseconds(milliseconds))
-      break;
+// built in bots and human seats with --hints, engine seats search themselves
+// and --model bots do not need to
+bool Game::wantsSearch() const {
+  const Player &player = players.at(currentPlayer);
+  if (player.type == Player::PlayerType::HUMAN)
+    return hints;
+  return engines.at(player.color) == nullptr && network == nullptr;
+}
+
+/**
+ * Hands the current position to the estimator, which drops whatever it was
+ * still computing for the previous one. Before the roll the search also
+ * starts on all six dice values so the answer is ready when the dice lands.
+ */
+void Game::startAnalysis() {
+  thumbnailStale = true;
+  GameState state;
+  fillState(state);
+  if (!currentPlayerRolled) {
+    if (wantsSearch())
+      search->startTurn(state, players.size());
+    else
+      search->cancel();
   }
+  if (estimator != nullptr)
+    estimator->analyze(state, players.size(),
+                       currentPlayerRolled ? dice.value : 0);
+}
+
+void Game::drawAnalysis() {
+  if (estimator == nullptr)
+    return;
+  const Analysis analysis{estimator->snapshot()};
+  if (analysis.rollouts == 0)
+    return;
+  for (size_t seat = 0; seat < players.size(); seat++)
+    view.drawWinProbability(toPhysicalColor(players[seat].color),
+                            analysis.winProbability[seat]);
+  if (!currentPlayerRolled)
+    return;
+  const std::vector<Piece> &pieces =
+      playerIdToPieces.at(players.at(currentPlayer).color);
+  const int ts{view.getLayout().tileSize};
+  for (int i = 0; i < 4; i++) {
+    if (!(analysis.legalMoves & (1u << i)))
+      continue;
+    auto [x, y] = pieces[i].pos.toXYOffset();
+    view.drawMoveDelta(x * ts, y * ts, analysis.moveDelta[i]);
+  }
+}
+
+// written next to the old one and renamed over it, so whoever serves the
+// thumbnail never sees half a file
+void Game::saveThumbnail() {
+  if (thumbnailPath.empty() || !thumbnailStale || Clock::now() < nextThumbnail)
+    return;
+  // encoding a PNG takes a good part of a frame, under --warp the board
+  // changes on nearly every one
+  thumbnailStale = false;
+  nextThumbnail = Clock::now() + THUMBNAIL_INTERVAL;
+  if (view.saveImage(thumbnailTemporary.c_str()))
+    std::rename(thumbnailTemporary.c_str(), thumbnailPath.c_str());
+}
+
+// sends the position to the engine, returns the request id or -1
+int Game::askEngine(EngineProcess &engine) {
+  const int color{players.at(currentPlayer).color};
+  EngineRequest request{color, dice.value, {}, moveTimeMs};
+  request.positions.fill(-1); // colors nobody plays
+  for (const auto &[id, pieces] : playerIdToPieces)
+    for (int i = 0; i < 4; i++)
+      request.positions[4 * id + i] = pieces[i].pos.pos;
+  return engine.send(request);
+}
+
+// the answer to request id if it came in time and is legal, -1 otherwise
+int Game::engineMove(EngineProcess &engine, int id) {
+  const int move{id >= 0 ? engine.await(id, 0) : -1};
+  if (move >= 0 && move < 4 && (highlightedPieces & (1u << move)))
+    return move;
+  LOG_WARNING("Engine [%s] gave no legal move, playing the first one",
+              engine.getCommand().c_str());
+  return -1;
 }
 
 void Game::handleEvent(const SDL_Event &event) {
+  if (view.handleWindowEvent(event)) {
+    screenChanged(event.common.timestamp);
+    return;
+  }
+  if (players.at(currentPlayer).type == Player::PlayerType::ROBOT)
+    return;
   if (event.type == SDL_EVENT_KEY_DOWN) {
     SDL_Keycode key = event.key.key;
-    if (key == SDLK_SPACE && !currentPlayerRolled) {
-      handleSpaceKeyDown();
-    }
+    if (key == SDLK_SPACE)
+      input.push(ROLL_INPUT, event.key.timestamp);
+    else if (key == SDLK_H)
+      input.push(HINT_INPUT, event.key.timestamp);
+    else if (key == SDLK_Z)
+      input.push(UNDO_INPUT, event.key.timestamp);
+    else if (key == SDLK_Y)
+      input.push(REDO_INPUT, event.key.timestamp);
   } else if (event.type == SDL_EVENT_MOUSE_BUTTON_DOWN) {
-    handleMouseEvent();
+    handleMouseEvent(event);
   }
 }
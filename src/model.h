@@ -1,138 +1,112 @@
 #ifndef MODEL_H
 #define MODEL_H
 
+#include "board.h"
+#include "config.h"
+#include "history.h"
+#include "rules.h"
+#include "threadpool.h"
+#include "turnflow.h"
 #include "view.h"
-#include <ostream>
-#include <random>
+#include <array>
+#include <memory>
+#include <span>
 #include <unordered_map>
 #include <vector>
 
 namespace gamespace {
 
-class BoardPosition;
-
-class Player {
-  /**
-   * @brief Player representation class ... done
-   *
-   */
-public:
-  enum PlayerType { HUMAN, ROBOT };
-  enum PlayerColor {
-    RED = 0,
-    GREEN = 1,
-    YELLOW = 2,
-    BLUE = 3
-  }; // order of play on the board
-  PlayerType type;
-  PlayerColor color; // used as an id field
-  const std::array<int, 4> &getJailPositions() const;
-  // just used to satisfy defaultConstructible in 0 length
-  // std::vector::constructor--(4)
-  Player(PlayerType type = ROBOT, PlayerColor color = RED)
-      : type(type), color(color) {}
-  ~Player() = default;
-  friend std::ostream &operator<<(std::ostream &os, const Player &p);
-};
-
 Color toPhysicalColor(const Player::PlayerColor &c);
-std::ostream &operator<<(std::ostream &os, const Player::PlayerColor &c);
-std::ostream &operator<<(std::ostream &os, const Player::PlayerType &t);
-
-class BoardPosition {
-  /**
-   * @brief Board position representation class ... done
-   *
-   */
-public:
-  int pos;
-  static int getNext(int pos, const Player::PlayerColor &color);
-  BoardPosition(int position = 0);
-  constexpr bool isInitialPosition() const;
-  static int defaultPosition(const Player::PlayerColor &color);
-  static std::pair<int, int> toXYOffset(int pos);
-  std::pair<int, int> toXYOffset() const;
-  static constexpr bool isFinalPosition(int position);
-  constexpr bool isFinalPosition() const;
-  static BoardPosition fromScreenFloats(float x, float y);
-  friend std::ostream &operator<<(std::ostream &os, const BoardPosition &p);
-  bool isProtectedPosition() const;
 
-private:
-  static int toPositionId(int x, int y);         // from x, y offsets
-  static BoardPosition toPosition(int x, int y); // from x, y offsets
-};
-
-constexpr bool operator==(const BoardPosition &a, const BoardPosition &b);
-
-class Piece {
-  /**
-   * @brief  ... done
-   *
-   */
-private:
-  Player _player;
-
-public:
-  BoardPosition pos;
-  bool canAdvance(int diceValue) const;
-  void advance(int diceValue);
-  Player::PlayerColor getColor() const { return _player.color; };
-  /**
-   * @brief TODO: set position later depending on other similar colored pieces
-   * @param p
-   */
-  // just used to satisfy defaultConstructible in 0 length
-  // std::vector::constructor--(4)
-  Piece(const Player &player = defaultPlayer,
-        const BoardPosition &position = BoardPosition(0))
-      : _player(player), pos(position) {}
-  static const Player defaultPlayer;
-  friend std::ostream &operator<<(std::ostream &os, Piece const &p);
-};
-
-class Dice {
-public:
-  int roll() { return value = dist(rd); }
-
-private:
-  std::random_device rd;
-  std::uniform_int_distribution<int> dist;
-
-public:
-  int value;
-  Dice() : rd(), dist(1, 6), value(6) {} // TODO: change to -1 later
-  ~Dice() = default;
-};
+class EngineProcess;
+class WinEstimator;
+class SpeculativeSearch;
+class AllocationCheck;
+class LatencyStats;
+class GameJournal;
+class ValueNetwork;
+class SpectatorHub;
 
 class Game {
   enum Phase { CONFIG, PLAY };
 
 public:
   void render();
+  // input for a human seat, dropped unless the game waits for it
   void handleEvent(const SDL_Event &event);
-  Game();
+  // the --check-allocations run measured all its turns
+  bool finished() const;
+  // prints what --check-allocations saw, false when the steady state
+  // allocated, true without the flag
+  bool reportAllocations() const;
+  // the game runs as a coroutine on the scheduler, see playTurns()
+  Game(Scheduler &scheduler, const GameConfig &config = GameConfig());
+  ~Game();
 
 private:
   View view;
   AudioManager audioManager;
   std::unordered_map<int, std::vector<Piece>> playerIdToPieces;
   std::vector<Player> players;
-  std::vector<Piece> hightLightedPieces;
+  RuleSet rules; // every roll is played by BasicRules with this variant
+  unsigned highlightedPieces; // bit i: the mover's piece i can advance
   Dice dice;
   Phase phase;
   int currentPlayer;
   int repetitionCounter;
-  bool currentPlayerPlayed;
-  bool currentPlayerRolled;
-  bool canAdvance;
+  bool currentPlayerRolled; // the dice shows, the mover has to play it
+  int moveTimeMs;
+  // --warp when every seat is a bot, 1 everywhere else, 0 for no waiting
+  double timeWarp;
+  long gamesPlayed; // finished ones, games only end under --warp
+  std::array<EngineProcess *, 4> engines; // by color, nullptr for humans
+  bool hints;
+  int hintedPiece; // index into the mover's pieces, -1 for none
+  ThreadPool workers; // shared by the estimator and the search
+  std::unique_ptr<WinEstimator> estimator; // nullptr without --analysis
+  std::unique_ptr<SpeculativeSearch> search;
+  std::unique_ptr<ValueNetwork> network; // nullptr without --model
+  std::string thumbnailPath;
+  std::string thumbnailTemporary; // written first, then renamed
+  bool thumbnailStale; // the position changed since the last thumbnail
+  Clock::time_point nextThumbnail; // no thumbnail is written before
+  std::unique_ptr<AllocationCheck> allocationCheck; // nullptr without flag
+  std::unique_ptr<GameJournal> journal; // nullptr without --journal
+  std::unique_ptr<SpectatorHub> spectators; // nullptr without --spectate
+  std::uint32_t journalGame; // id of this game in the journal
+  GameHistory history; // every position since the game started, for undo
+  Scheduler &scheduler;
+  // a piece index, ROLL_INPUT or HINT_INPUT, stamped by SDL
+  InputQueue<int, 16> input;
+  std::unique_ptr<LatencyStats> latency; // nullptr without --latency
+  TurnLoop turns;
+  TurnLoop playTurns();
   void drawPieces();
   void setUpPieces();
-  void arrangePiecesAtPosition(std::vector<Piece> &pieces);
-  void handleMouseEvent();
-  void handleSpaceKeyDown();
-  void capture(Piece &p);
-  void renderFor(int milliseconds);
+  void arrangePiecesAtPosition(std::span<const Piece *const> pieces);
+  void handleMouseEvent(SDL_Event event); // copied, converted to pixels
+  void rollDice();
+  void showRoll(); // the mover has dice.value to play
+  // the roll showing, piece -1 when nothing moves, true when it captured
+  bool playMove(int piece);
+  int askEngine(EngineProcess &engine);
+  int engineMove(EngineProcess &engine, int id);
+  void nextPlayer();
+  bool hasWon(Player::PlayerColor color) const;
+  void newGame();
+  void restoreGame(const std::string &journalPath);
+  void loadState(const GameState &state);
+  void resetHistory();
+  void remember(int piece);
+  bool travel(int direction);
+  bool isHuman(int seat) const;
+  Clock::duration warped(Clock::duration duration) const;
+  void screenChanged(std::uint64_t eventTime);
+  void startAnalysis();
+  bool wantsSearch() const;
+  void fillState(GameState &state) const;
+  void drawAnalysis();
+  void saveThumbnail();
 };
 } // namespace gamespace
 #endif
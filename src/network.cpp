@@ -0,0 +1,174 @@
+#include "network.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+using namespace gamespace;
+
+static const char MAGIC[8]{'L', 'U', 'D', 'O', 'N', 'N', 'E', 'T'};
+
+namespace {
+
+typedef float Floats __attribute__((vector_size(32)));
+constexpr int LANES{8};
+constexpr int VECTORS{ValueNetwork::HIDDEN / LANES};
+static_assert(ValueNetwork::HIDDEN % LANES == 0);
+
+// only x86 has the clones, other targets build the plain vector code for
+// whatever SIMD they have, or scalar code without any
+#if defined(__x86_64__) || defined(__i386__)
+#define FORWARD_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define FORWARD_CLONES
+#endif
+
+/**
+ * The forward pass over a batch, built twice on x86: the AVX2 clone does
+ * every vector operation in one instruction, the default one in two SSE
+ * halves. AVX2 does not bring FMA, so both round every add and multiply
+ * alike. Everything is written out in here, a helper taking or returning
+ * a vector would be called with a different ABI by each clone.
+ */
+FORWARD_CLONES void forward(const ValueNetwork::Weights &w,
+                            const ValueNetwork::Input *inputs,
+                            ValueNetwork::Output *outputs, size_t n) {
+  using Net = ValueNetwork;
+  for (size_t k = 0; k < n; k++) {
+    const Net::Input &input{inputs[k]};
+    Floats hidden[VECTORS];
+    std::memcpy(hidden, w.hiddenBias, sizeof(hidden));
+    std::array<int, Net::MAX_ACTIVE> features;
+    const int active{Net::activeFeatures(input, features)};
+    for (int f = 0; f < active; f++)
+      for (int v = 0; v < VECTORS; v++) {
+        Floats row;
+        std::memcpy(&row, w.input[features[f]] + v * LANES, sizeof(row));
+        hidden[v] += row;
+      }
+    const Floats zero{};
+    for (int v = 0; v < VECTORS; v++)
+      hidden[v] = hidden[v] > zero ? hidden[v] : zero;
+
+    const int seats{input.numPlayers >= 2 && input.numPlayers <= 4
+                        ? input.numPlayers
+                        : Net::SEATS};
+    float logits[Net::SEATS];
+    float top{-INFINITY};
+    for (int s = 0; s < seats; s++) {
+      Floats sum{};
+      for (int v = 0; v < VECTORS; v++) {
+        Floats row;
+        std::memcpy(&row, w.output[s] + v * LANES, sizeof(row));
+        sum += hidden[v] * row;
+      }
+      float logit{w.outputBias[s]};
+      for (int lane = 0; lane < LANES; lane++)
+        logit += sum[lane];
+      logits[s] = logit;
+      top = std::max(top, logit);
+    }
+    float total{0};
+    for (int s = 0; s < seats; s++)
+      total += logits[s] = std::exp(logits[s] - top);
+    for (int s = 0; s < Net::SEATS; s++)
+      outputs[k][s] = s < seats ? logits[s] / total : 0.0f;
+  }
+}
+
+} // namespace
+
+int ValueNetwork::activeFeatures(const Input &input,
+                                 std::array<int, MAX_ACTIVE> &features) {
+  int n{0};
+  for (int seat = 0; seat < SEATS; seat++)
+    for (int i = 0; i < 4; i++)
+      if (input.progress[seat][i] < NUM_PROGRESS)
+        features[n++] = seat * NUM_PROGRESS + input.progress[seat][i];
+  if (input.numPlayers >= 2 && input.numPlayers <= 4)
+    features[n++] = SEATS * NUM_PROGRESS + input.numPlayers - 2;
+  return n;
+}
+
+ValueNetwork::ValueNetwork() : w(std::make_unique<Weights>()) {}
+
+ValueNetwork::~ValueNetwork() = default;
+
+void ValueNetwork::evaluate(std::span<const Input> inputs,
+                            std::span<Output> outputs) const {
+  forward(*w, inputs.data(), outputs.data(),
+          std::min(inputs.size(), outputs.size()));
+}
+
+int ValueNetwork::chooseMove(const GameState &state, int numPlayers,
+                             RuleSet rules, int dice) const {
+  return withRules(numPlayers, rules, [&](auto tag) {
+    using R = decltype(tag);
+    return chooseMove<R>(toState<R>(state), dice);
+  });
+}
+
+void ValueNetwork::initialize(std::uint32_t seed) {
+  std::minstd_rand generator(seed);
+  std::uniform_real_distribution<float> small(-0.1f, 0.1f);
+  *w = Weights{};
+  for (auto &row : w->input)
+    for (float &weight : row)
+      weight = small(generator);
+  for (auto &row : w->output)
+    for (float &weight : row)
+      weight = small(generator);
+}
+
+bool ValueNetwork::save(const std::string &path) const {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  Header header{{}, VERSION, FEATURES, HIDDEN, SEATS};
+  std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char *>(w->input), sizeof(w->input));
+  file.write(reinterpret_cast<const char *>(w->hiddenBias),
+             sizeof(w->hiddenBias));
+  file.write(reinterpret_cast<const char *>(w->output), sizeof(w->output));
+  file.write(reinterpret_cast<const char *>(w->outputBias),
+             sizeof(w->outputBias));
+  if (!file.good()) {
+    (std::cerr << "Could not write network [" << path << "]\n").flush();
+    return false;
+  }
+  return true;
+}
+
+bool ValueNetwork::load(const std::string &path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    (std::cerr << "Could not open network [" << path << "]\n").flush();
+    return false;
+  }
+  Header header{};
+  file.read(reinterpret_cast<char *>(&header), sizeof(header));
+  if (!file.good() || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+      header.version != VERSION || header.features != FEATURES ||
+      header.hidden != HIDDEN || header.seats != SEATS) {
+    (std::cerr << "[" << path << "] is not a network of this version\n")
+        .flush();
+    return false;
+  }
+  // read into a copy, a short file leaves the weights we had
+  auto loaded{std::make_unique<Weights>()};
+  file.read(reinterpret_cast<char *>(loaded->input), sizeof(loaded->input));
+  file.read(reinterpret_cast<char *>(loaded->hiddenBias),
+            sizeof(loaded->hiddenBias));
+  file.read(reinterpret_cast<char *>(loaded->output),
+            sizeof(loaded->output));
+  file.read(reinterpret_cast<char *>(loaded->outputBias),
+            sizeof(loaded->outputBias));
+  if (!file.good() || file.peek() != std::ifstream::traits_type::eof()) {
+    (std::cerr << "Network [" << path << "] has the wrong size\n").flush();
+    return false;
+  }
+  w = std::move(loaded);
+  return true;
+}
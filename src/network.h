@@ -0,0 +1,141 @@
+#ifndef NETWORK_H
+#define NETWORK_H
+
+#include "rules.h"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+
+namespace gamespace {
+
+/**
+ * @brief Small learned evaluator: win probability of every seat from where
+ * the pieces are, one hidden layer of HIDDEN rectified units.
+ *
+ * The input is one-hot piece progress per seat, so the first layer only
+ * adds up the weight rows of the 16 pieces instead of multiplying a
+ * matrix. evaluate() runs a whole batch through 8 float vectors, built
+ * for AVX2 and for plain x86-64 and picked when the program starts. Both
+ * add in the same order, so a state scores the same on every machine,
+ * in every batch and at every position of the batch. Nothing is
+ * allocated once the weights are loaded.
+ *
+ * File layout, native endianness:
+ *   Header
+ *   float input[FEATURES][HIDDEN], hiddenBias[HIDDEN]
+ *   float output[SEATS][HIDDEN], outputBias[SEATS]
+ */
+class ValueNetwork {
+public:
+  static constexpr std::uint32_t VERSION{1};
+  static constexpr int SEATS{4};
+  static constexpr int NUM_PROGRESS{Rules::FINAL_PROGRESS + 1};
+  // a progress per seat, then the player count
+  static constexpr int FEATURES{SEATS * NUM_PROGRESS + 3};
+  static constexpr int MAX_ACTIVE{4 * SEATS + 1}; // features set at once
+  static constexpr int HIDDEN{32};
+  // progress of seats nobody plays
+  static constexpr std::uint8_t NO_SEAT{255};
+
+  // pieces by progress, seats counted from the player to move
+  struct Input {
+    std::array<std::array<std::uint8_t, 4>, SEATS> progress;
+    std::uint8_t numPlayers;
+  };
+  // win probability by seat counted from the player to move, 0 for seats
+  // nobody plays
+  using Output = std::array<float, SEATS>;
+
+  struct Weights {
+    alignas(32) float input[FEATURES][HIDDEN];
+    alignas(32) float hiddenBias[HIDDEN];
+    alignas(32) float output[SEATS][HIDDEN];
+    float outputBias[SEATS];
+  };
+
+  bool load(const std::string &path);
+  bool save(const std::string &path) const;
+  // small random weights to start training from
+  void initialize(std::uint32_t seed);
+  Weights &weights() { return *w; }
+  const Weights &weights() const { return *w; }
+
+  template <class R> static Input encode(const typename R::State &state) {
+    Input input;
+    for (int seat = 0; seat < SEATS; seat++) {
+      const int s{(state.currentPlayer + seat) % R::NUM_PLAYERS};
+      for (int i = 0; i < R::PIECES_PER_COLOR; i++)
+        input.progress[seat][i] = seat < R::NUM_PLAYERS
+                                      ? R::progress(s, state.pieces[s][i])
+                                      : NO_SEAT;
+    }
+    input.numPlayers = R::NUM_PLAYERS;
+    return input;
+  }
+  // the features input sets, a piece sharing its progress with another
+  // one sets it twice. Returns how many.
+  static int activeFeatures(const Input &input,
+                            std::array<int, MAX_ACTIVE> &features);
+  // outputs has room for as many as inputs
+  void evaluate(std::span<const Input> inputs,
+                std::span<Output> outputs) const;
+
+  // the piece whose move leaves the mover the best chances, all legal
+  // moves scored in one batch. state has rolled dice like after R::roll.
+  template <class R>
+  int chooseMove(const typename R::State &state, int dice) const {
+    std::array<Input, 4> after;
+    std::array<int, 4> pieces, mover;
+    size_t n{0};
+    for (unsigned legal = R::legalMoves(state, dice); legal != 0;
+         legal &= legal - 1) {
+      const int i{std::countr_zero(legal)};
+      typename R::State next{state};
+      R::play(next, i, dice);
+      if (R::isOver(next))
+        return i;
+      after[n] = encode<R>(next);
+      // where the mover sits counted from whoever moves next
+      mover[n] = (state.currentPlayer - next.currentPlayer +
+                  R::NUM_PLAYERS) %
+                 R::NUM_PLAYERS;
+      pieces[n++] = i;
+    }
+    if (n == 0)
+      return -1;
+    std::array<Output, 4> scores;
+    evaluate(std::span(after.data(), n), std::span(scores.data(), n));
+    size_t best{0};
+    for (size_t k = 1; k < n; k++)
+      if (scores[k][mover[k]] > scores[best][mover[best]])
+        best = k;
+    return pieces[best];
+  }
+  // same for the GUI's state, rows past numPlayers are ignored
+  int chooseMove(const GameState &state, int numPlayers, RuleSet rules,
+                 int dice) const;
+
+private:
+  struct Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t features;
+    std::uint32_t hidden;
+    std::uint32_t seats;
+  };
+  std::unique_ptr<Weights> w;
+
+public:
+  ValueNetwork();
+  ~ValueNetwork();
+  ValueNetwork(const ValueNetwork &) = delete;
+  ValueNetwork &operator=(const ValueNetwork &) = delete;
+};
+
+} // namespace gamespace
+#endif
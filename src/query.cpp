@@ -0,0 +1,133 @@
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "results.h"
+
+using namespace gamespace;
+
+static void printUsage(const char *program) {
+  std::cerr << "usage: " << program
+            << " <results> [--where <column><op><value>]... [--print <n>]\n"
+               "columns: seed players policy.<color> winner turns"
+               " captures.<color> move_ns, ops: = != < <= > >=\n";
+}
+
+static const char *const COLORS[5]{"red", "green", "yellow", "blue", "none"};
+
+static int colorFromName(const std::string &name) {
+  for (int color = 0; color < 5; color++)
+    if (name == COLORS[color])
+      return color;
+  return -1;
+}
+
+// "winner=red", "turns<100", "policy.red=rollouts:20"
+static bool parsePredicate(const std::string &text, const ResultReader &reader,
+                           ResultPredicate &predicate) {
+  static const std::pair<const char *, ResultPredicate::Op> ops[]{
+      {"!=", ResultPredicate::NE}, {"<=", ResultPredicate::LE},
+      {">=", ResultPredicate::GE}, {"=", ResultPredicate::EQ},
+      {"<", ResultPredicate::LT},  {">", ResultPredicate::GT}};
+  const size_t at{text.find_first_of("!<>=")};
+  if (at == std::string::npos)
+    return false;
+  predicate.column = columnFromName(text.substr(0, at));
+  if (predicate.column == ResultColumn::COUNT)
+    return false;
+  std::string value;
+  bool known{false};
+  for (const auto &[symbol, op] : ops)
+    if (text.compare(at, std::string(symbol).size(), symbol) == 0) {
+      predicate.op = op;
+      value = text.substr(at + std::string(symbol).size());
+      known = true;
+      break;
+    }
+  if (!known || value.empty())
+    return false;
+  if (predicate.column == ResultColumn::WINNER) {
+    predicate.value = colorFromName(value);
+    return predicate.value >= 0;
+  }
+  if (predicate.column >= ResultColumn::POLICY_RED &&
+      predicate.column <= ResultColumn::POLICY_BLUE) {
+    // a policy the file never saw matches nothing, not everything
+    const int id{reader.policy(value)};
+    predicate.value = id >= 0 ? id : GameResult::NO_POLICY + 1;
+    return true;
+  }
+  char *end;
+  predicate.value = std::strtoll(value.c_str(), &end, 10);
+  return *end == '\0';
+}
+
+static void printRow(const GameResult &r, const ResultReader &reader) {
+  std::cout << r.seed << " " << int(r.numPlayers) << "p winner "
+            << COLORS[r.winner] << " turns " << r.turns << " move "
+            << r.moveNanos << "ns";
+  for (int color = 0; color < 4; color++)
+    if (r.policies[color] != GameResult::NO_POLICY)
+      std::cout << " " << COLORS[color] << ":"
+                << (r.policies[color] < reader.policies().size()
+                        ? reader.policies()[r.policies[color]]
+                        : "?")
+                << "/" << r.captures[color];
+  std::cout << "\n";
+}
+
+int main(int argc, char *argv[]) {
+  std::string path;
+  std::vector<std::string> conditions;
+  long print{0};
+  for (int i = 1; i < argc; i++) {
+    std::string arg{argv[i]};
+    if (arg == "--where" && i + 1 < argc)
+      conditions.push_back(argv[++i]);
+    else if (arg == "--print" && i + 1 < argc)
+      print = std::max(0L, std::atol(argv[++i]));
+    else if (!arg.starts_with("--") && path.empty())
+      path = arg;
+    else
+      return printUsage(argv[0]), 1;
+  }
+  if (path.empty())
+    return printUsage(argv[0]), 1;
+
+  ResultReader reader;
+  if (!reader.open(path))
+    return 1;
+  std::vector<ResultPredicate> predicates(conditions.size());
+  for (size_t i = 0; i < conditions.size(); i++)
+    if (!parsePredicate(conditions[i], reader, predicates[i])) {
+      (std::cerr << "Invalid condition [" << conditions[i] << "]\n").flush();
+      return printUsage(argv[0]), 1;
+    }
+
+  auto begin{std::chrono::steady_clock::now()};
+  std::array<long, 5> wins{};
+  long printed{0};
+  auto visit = [&](const GameResult &r) {
+    wins[r.winner]++;
+    if (printed < print)
+      printRow(r, reader), printed++;
+  };
+  // the tallies alone only need the winner column
+  static constexpr ResultColumn TALLIED[]{ResultColumn::WINNER};
+  const size_t matched{print > 0 ? reader.scan(predicates, visit)
+                                 : reader.scan(predicates, TALLIED, visit)};
+  const double ms{std::chrono::duration<double, std::milli>(
+                      std::chrono::steady_clock::now() - begin)
+                      .count()};
+  std::cout << matched << " of " << reader.size() << " games match, "
+            << reader.skippedBlocks() << " of " << reader.blocks()
+            << " blocks skipped, " << ms << "ms\n";
+  for (int color = 0; color < 5; color++)
+    if (wins[color] != 0)
+      std::cout << COLORS[color] << " wins " << wins[color] << " ("
+                << 100.0 * wins[color] / matched << "%)\n";
+  return 0;
+}
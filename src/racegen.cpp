@@ -0,0 +1,35 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "racetable.h"
+
+using namespace gamespace;
+
+int main(int argc, char *argv[]) {
+  if (argc > 2) {
+    std::cerr << "usage: " << argv[0] << " [output, race.bin by default]\n";
+    return 1;
+  }
+  const std::string path{argc == 2 ? argv[1] : "race.bin"};
+  auto start{std::chrono::steady_clock::now()};
+  if (!RaceTable::generate(path))
+    return 1;
+  RaceTable table;
+  if (!table.open(path))
+    return 1;
+  std::cout << "wrote " << path << " in "
+            << std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                             start)
+                   .count()
+            << "s\n";
+  const int jail{Rules::jailPosition(0, 0)};
+  std::cout << "one piece from jail: " << table.expectedTurns(0, jail)
+            << " turns, four pieces: "
+            << table.expectedTurns(0, {static_cast<std::uint8_t>(jail),
+                                       static_cast<std::uint8_t>(jail + 1),
+                                       static_cast<std::uint8_t>(jail + 2),
+                                       static_cast<std::uint8_t>(jail + 3)})
+            << " turns\n";
+  return 0;
+}
@@ -0,0 +1,261 @@
+#include "racetable.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace gamespace;
+
+static const char MAGIC[8]{'L', 'U', 'D', 'O', 'R', 'A', 'C', 'E'};
+static const int FINAL{Rules::FINAL_PROGRESS};
+
+namespace {
+
+struct Binomials {
+  std::array<std::array<std::size_t, 5>, RaceTable::NUM_PROGRESS + 4> c{};
+  Binomials() {
+    for (size_t n = 0; n < c.size(); n++) {
+      c[n][0] = 1;
+      for (size_t k = 1; k < 5 && k <= n; k++)
+        c[n][k] = c[n - 1][k - 1] + c[n - 1][k];
+    }
+  }
+};
+
+const Binomials &binomials() {
+  static const Binomials b;
+  return b;
+}
+
+// progress reached from progress p with this dice value, -1 when the rules
+// refuse the move. Read from the red path, every color has the same shape.
+struct Steps {
+  std::array<std::array<int, 7>, RaceTable::NUM_PROGRESS> next{};
+  Steps() {
+    std::array<int, RaceTable::NUM_PROGRESS> position{};
+    position[0] = Rules::jailPosition(0, 0);
+    for (int p = 0; p < NUM_POSITIONS; p++)
+      if (Rules::progress(0, p) > 0)
+        position[Rules::progress(0, p)] = p;
+    for (int p = 0; p < RaceTable::NUM_PROGRESS; p++)
+      for (int dice = 1; dice <= 6; dice++) {
+        int target{Rules::destination(0, position[p], dice)};
+        next[p][dice] = target < 0 ? -1 : Rules::progress(0, target);
+      }
+  }
+};
+
+/**
+ * Expected turns for every configuration, moving the piece that minimizes
+ * them. A turn is up to 3 rolls, a 6 rolls again like in Rules::play.
+ * Moves only increase the progress sum, so configurations are solved from
+ * the largest sum down, the only unknown left is the configuration's own
+ * value (rolls where nothing moves), which is linear and solved in place.
+ */
+std::vector<double> solveRace(const Steps &steps) {
+  const size_t n{RaceTable::NUM_CONFIGS};
+  std::vector<std::array<int, 4>> configs;
+  configs.reserve(n);
+  for (int d = 0; d <= FINAL; d++)
+    for (int c = 0; c <= d; c++)
+      for (int b = 0; b <= c; b++)
+        for (int a = 0; a <= b; a++)
+          configs.push_back({a, b, c, d});
+  std::stable_sort(configs.begin(), configs.end(),
+                   [](const auto &x, const auto &y) {
+                     return x[0] + x[1] + x[2] + x[3] >
+                            y[0] + y[1] + y[2] + y[3];
+                   });
+
+  // turns[rank], later[r][rank]: turns still to come after the current one
+  // when roll r + 1 of the turn is about to happen
+  std::vector<double> turns(n, 0.0);
+  std::array<std::vector<double>, 2> later{std::vector<double>(n, 0.0),
+                                           std::vector<double>(n, 0.0)};
+  const double infinity{std::numeric_limits<double>::infinity()};
+  for (const std::array<int, 4> &config : configs) {
+    const size_t index{RaceTable::rank(config)};
+    if (config[0] == FINAL)
+      continue; // sorted, so every piece is home
+    // later(r) = a[r] + b[r] * turns(config)
+    std::array<double, 3> a{}, b{};
+    for (int r = 2; r >= 0; r--) {
+      for (int dice = 1; dice <= 6; dice++) {
+        const bool again{dice == 6 && r < 2};
+        double best{infinity};
+        for (int i = 0; i < 4; i++) {
+          if ((i > 0 && config[i] == config[i - 1]) ||
+              steps.next[config[i]][dice] < 0)
+            continue;
+          std::array<int, 4> moved{config};
+          moved[i] = steps.next[config[i]][dice];
+          const size_t to{RaceTable::rank(moved)};
+          double value{0.0};
+          if (std::min({moved[0], moved[1], moved[2], moved[3]}) < FINAL)
+            value = again ? later[r][to] : turns[to];
+          best = std::min(best, value);
+        }
+        if (best != infinity)
+          a[r] += best / 6;
+        else if (again)
+          a[r] += a[r + 1] / 6, b[r] += b[r + 1] / 6;
+        else
+          b[r] += 1.0 / 6;
+      }
+    }
+    turns[index] = (1 + a[0]) / (1 - b[0]);
+    later[0][index] = a[1] + b[1] * turns[index];
+    later[1][index] = a[2] + b[2] * turns[index];
+  }
+  return turns;
+}
+
+// where a lone piece ends up after one whole turn
+void turnOutcomes(const Steps &steps, int p, int roll, double probability,
+                  std::array<double, RaceTable::NUM_PROGRESS> &out) {
+  for (int dice = 1; dice <= 6; dice++) {
+    const int q{steps.next[p][dice] < 0 ? p : steps.next[p][dice]};
+    if (q != FINAL && dice == 6 && roll < 2)
+      turnOutcomes(steps, q, roll + 1, probability / 6, out);
+    else
+      out[q] += probability / 6;
+  }
+}
+
+} // namespace
+
+std::size_t RaceTable::rank(std::array<int, 4> progress) {
+  std::sort(progress.begin(), progress.end());
+  const auto &c{binomials().c};
+  return c[progress[0]][1] + c[progress[1] + 1][2] + c[progress[2] + 2][3] +
+         c[progress[3] + 3][4];
+}
+
+bool RaceTable::generate(const std::string &path) {
+  const Steps steps;
+  const std::vector<double> turns{solveRace(steps)};
+
+  std::vector<float> expected(NUM_PROGRESS);
+  for (int p = 0; p < NUM_PROGRESS; p++)
+    expected[p] = turns[rank({p, FINAL, FINAL, FINAL})];
+
+  std::vector<float> distribution(NUM_PROGRESS * MAX_TURNS, 0.0f);
+  std::array<std::array<double, NUM_PROGRESS>, NUM_PROGRESS> transition{};
+  for (int p = 0; p < NUM_PROGRESS; p++)
+    turnOutcomes(steps, p, 0, 1.0, transition[p]);
+  for (int start = 0; start < FINAL; start++) {
+    std::array<double, NUM_PROGRESS> mass{};
+    mass[start] = 1.0;
+    double home{0.0};
+    for (int t = 0; t < MAX_TURNS - 1; t++) {
+      std::array<double, NUM_PROGRESS> next{};
+      next[FINAL] = mass[FINAL];
+      for (int p = 0; p < FINAL; p++)
+        for (int q = p; q < NUM_PROGRESS; q++)
+          next[q] += mass[p] * transition[p][q];
+      distribution[start * MAX_TURNS + t] = next[FINAL] - home;
+      home = next[FINAL];
+      mass = next;
+    }
+    distribution[start * MAX_TURNS + MAX_TURNS - 1] = 1.0 - home;
+  }
+
+  std::vector<float> combined(turns.begin(), turns.end());
+  Header h{};
+  std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+  h.version = VERSION;
+  h.numProgress = NUM_PROGRESS;
+  h.maxTurns = MAX_TURNS;
+  h.numConfigs = NUM_CONFIGS;
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file.write(reinterpret_cast<const char *>(&h), sizeof(h));
+  file.write(reinterpret_cast<const char *>(expected.data()),
+             expected.size() * sizeof(float));
+  file.write(reinterpret_cast<const char *>(distribution.data()),
+             distribution.size() * sizeof(float));
+  file.write(reinterpret_cast<const char *>(combined.data()),
+             combined.size() * sizeof(float));
+  if (!file) {
+    (std::cerr << "Could not write race table [" << path << "]\n").flush();
+    return false;
+  }
+  return true;
+}
+
+RaceTable::RaceTable()
+    : mapping(nullptr), mappingSize(0), header(nullptr), expected(nullptr),
+      distribution(nullptr), combined(nullptr) {}
+
+RaceTable::~RaceTable() { close(); }
+
+void RaceTable::close() {
+  if (mapping != nullptr)
+    munmap(mapping, mappingSize);
+  mapping = nullptr;
+  header = nullptr;
+}
+
+bool RaceTable::open(const std::string &path) {
+  close();
+  int fd{::open(path.c_str(), O_RDONLY)};
+  if (fd < 0) {
+    (std::cerr << "Could not open race table [" << path << "]\n").flush();
+    return false;
+  }
+  struct stat info;
+  const std::size_t expectedSize{
+      sizeof(Header) +
+      (NUM_PROGRESS + NUM_PROGRESS * MAX_TURNS + NUM_CONFIGS) * sizeof(float)};
+  if (fstat(fd, &info) != 0 ||
+      static_cast<std::size_t>(info.st_size) != expectedSize) {
+    (std::cerr << "Race table [" << path << "] has the wrong size\n").flush();
+    ::close(fd);
+    return false;
+  }
+  void *data{mmap(nullptr, expectedSize, PROT_READ, MAP_PRIVATE, fd, 0)};
+  ::close(fd); // the mapping keeps the file alive
+  if (data == MAP_FAILED) {
+    (std::cerr << "Could not map race table [" << path << "]\n").flush();
+    return false;
+  }
+  const Header *h{static_cast<const Header *>(data)};
+  if (std::memcmp(h->magic, MAGIC, sizeof(MAGIC)) != 0 ||
+      h->version != VERSION || h->numProgress != NUM_PROGRESS ||
+      h->maxTurns != MAX_TURNS || h->numConfigs != NUM_CONFIGS) {
+    (std::cerr << "Race table [" << path
+               << "] was written by another version, regenerate it\n")
+        .flush();
+    munmap(data, expectedSize);
+    return false;
+  }
+  mapping = data;
+  mappingSize = expectedSize;
+  header = h;
+  expected = reinterpret_cast<const float *>(h + 1);
+  distribution = expected + NUM_PROGRESS;
+  combined = distribution + NUM_PROGRESS * MAX_TURNS;
+  return true;
+}
+
+float RaceTable::expectedTurns(int color, int position) const {
+  return expected[detail::pathProgress(color, position)];
+}
+
+const float *RaceTable::turnDistribution(int color, int position) const {
+  return distribution + detail::pathProgress(color, position) * MAX_TURNS;
+}
+
+float RaceTable::expectedTurns(
+    int color, const std::array<std::uint8_t, 4> &positions) const {
+  std::array<int, 4> progress;
+  for (int i = 0; i < 4; i++)
+    progress[i] = detail::pathProgress(color, positions[i]);
+  return combined[rank(progress)];
+}
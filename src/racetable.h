@@ -0,0 +1,73 @@
+#ifndef RACETABLE_H
+#define RACETABLE_H
+
+#include "rules.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace gamespace {
+
+/**
+ * @brief Exact race values: how many turns a player needs to bring pieces
+ * home when nobody gets in the way, under the classic rules.
+ *
+ * generate() solves the race by dynamic programming over the move tables
+ * and writes a versioned binary file, open() memory-maps such a file so a
+ * lookup costs one load and startup costs nothing. Pieces are given as
+ * BoardPosition ids, the color picks the path they are on.
+ *
+ * File layout, native endianness:
+ *   Header
+ *   float expected[NUM_PROGRESS]                 one piece, by progress
+ *   float distribution[NUM_PROGRESS][MAX_TURNS]  P(home on turn t + 1)
+ *   float combined[NUM_CONFIGS]                  four pieces, by rank()
+ */
+class RaceTable {
+public:
+  static constexpr std::uint32_t VERSION{1};
+  static constexpr int NUM_PROGRESS{Rules::FINAL_PROGRESS + 1};
+  static constexpr int MAX_TURNS{128}; // the last bin holds the tail
+  // sorted progress multisets of 4 pieces, C(NUM_PROGRESS + 3, 4)
+  static constexpr std::size_t NUM_CONFIGS{521855};
+
+  static bool generate(const std::string &path);
+  bool open(const std::string &path);
+  bool isOpen() const { return header != nullptr; }
+
+  // one piece on its own
+  float expectedTurns(int color, int position) const;
+  const float *turnDistribution(int color, int position) const;
+  // a player's four pieces, moved in the best order
+  float expectedTurns(int color,
+                      const std::array<std::uint8_t, 4> &positions) const;
+  // index of a progress multiset, any order, in the combined table
+  static std::size_t rank(std::array<int, 4> progress);
+
+private:
+  struct Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t numProgress;
+    std::uint32_t maxTurns;
+    std::uint32_t numConfigs;
+  };
+  void *mapping;
+  std::size_t mappingSize;
+  const Header *header;
+  const float *expected;
+  const float *distribution;
+  const float *combined;
+  void close();
+
+public:
+  RaceTable();
+  ~RaceTable();
+  RaceTable(const RaceTable &) = delete;
+  RaceTable &operator=(const RaceTable &) = delete;
+};
+
+} // namespace gamespace
+#endif
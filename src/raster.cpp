@@ -0,0 +1,223 @@
+#include "raster.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace gamespace;
+
+Framebuffer::Framebuffer()
+    : width(0), height(0), pixels(), dirtyX1(0), dirtyY1(0), dirtyX2(0),
+      dirtyY2(0), drawnX1(0), drawnY1(0), drawnX2(0), drawnY2(0) {}
+
+void Framebuffer::resize(int width, int height) {
+  this->width = std::max(0, width);
+  this->height = std::max(0, height);
+  pixels.assign(static_cast<std::size_t>(this->width) * this->height, 0);
+  markDirty(0, 0, this->width, this->height);
+}
+
+void Framebuffer::markDirty(int x1, int y1, int x2, int y2) {
+  if (drawnX1 >= drawnX2)
+    drawnX1 = x1, drawnY1 = y1, drawnX2 = x2, drawnY2 = y2;
+  drawnX1 = std::min(drawnX1, x1), drawnY1 = std::min(drawnY1, y1);
+  drawnX2 = std::max(drawnX2, x2), drawnY2 = std::max(drawnY2, y2);
+  if (dirtyX1 >= dirtyX2) {
+    dirtyX1 = x1, dirtyY1 = y1, dirtyX2 = x2, dirtyY2 = y2;
+    return;
+  }
+  dirtyX1 = std::min(dirtyX1, x1), dirtyY1 = std::min(dirtyY1, y1);
+  dirtyX2 = std::max(dirtyX2, x2), dirtyY2 = std::max(dirtyY2, y2);
+}
+
+Framebuffer::Rect Framebuffer::takeDirty() {
+  Rect dirty{dirtyX1, dirtyY1, std::max(0, dirtyX2 - dirtyX1),
+             std::max(0, dirtyY2 - dirtyY1)};
+  dirtyX1 = dirtyY1 = dirtyX2 = dirtyY2 = 0;
+  return dirty;
+}
+
+// (x + 128) / 255 rounded, exact for every product of two bytes
+static inline std::uint32_t divide255(std::uint32_t x) {
+  x += 128;
+  return (x + (x >> 8)) >> 8;
+}
+
+static inline std::uint32_t blend(std::uint32_t dst, std::uint32_t color) {
+  const std::uint32_t a{color >> 24};
+  std::uint32_t out{0};
+  for (int shift = 0; shift < 32; shift += 8) {
+    // the alpha channel blends 255 over the old alpha
+    const std::uint32_t s{shift == 24 ? 255 : (color >> shift) & 255};
+    const std::uint32_t d{(dst >> shift) & 255};
+    out |= divide255(s * a + d * (255 - a)) << shift;
+  }
+  return out;
+}
+
+// x2 is exclusive, the span is already clipped
+void Framebuffer::fillSpan(int x1, int x2, int y, std::uint32_t color) {
+  std::uint32_t *p{pixels.data() + static_cast<std::size_t>(y) * width + x1};
+  std::uint32_t *end{p + (x2 - x1)};
+  const std::uint32_t a{color >> 24};
+  if (a == 0)
+    return;
+  markDirty(x1, y, x2, y + 1);
+  if (a == 255) {
+#if defined(__SSE2__)
+    const __m128i fill{_mm_set1_epi32(static_cast<int>(color))};
+    for (; p + 4 <= end; p += 4)
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(p), fill);
+#endif
+    std::fill(p, end, color);
+    return;
+  }
+#if defined(__SSE2__)
+  // two pixels per register as 16 bit lanes: src * a + dst * (255 - a)
+  const __m128i zero{_mm_setzero_si128()};
+  const __m128i source{_mm_mullo_epi16(
+      _mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(color | 0xff000000u)),
+                        zero),
+      _mm_set1_epi16(static_cast<short>(a)))};
+  const __m128i inverse{_mm_set1_epi16(static_cast<short>(255 - a))};
+  const __m128i half{_mm_set1_epi16(128)};
+  for (; p + 4 <= end; p += 4) {
+    const __m128i dst{_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))};
+    __m128i lo{_mm_add_epi16(
+        _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(dst, zero), inverse),
+                      source),
+        half)};
+    __m128i hi{_mm_add_epi16(
+        _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(dst, zero), inverse),
+                      source),
+        half)};
+    lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+    hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(p),
+                     _mm_packus_epi16(lo, hi));
+  }
+#endif
+  for (; p < end; p++)
+    *p = blend(*p, color);
+}
+
+void Framebuffer::clear(std::uint32_t color) {
+  for (int y = 0; y < height; y++)
+    fillSpan(0, width, y, color | 0xff000000u);
+}
+
+void Framebuffer::copyFrom(const Framebuffer &other) {
+  width = other.width;
+  height = other.height;
+  pixels = other.pixels; // same size after the first copy, no allocation
+  markDirty(0, 0, width, height);
+  drawnX1 = drawnY1 = drawnX2 = drawnY2 = 0;
+}
+
+// only the rows and columns of the last frame's pieces and dice, so the
+// texture upload stays as small as what changed
+void Framebuffer::restoreFrom(const Framebuffer &other) {
+  if (other.width != width || other.height != height) {
+    copyFrom(other);
+    return;
+  }
+  if (drawnX1 >= drawnX2)
+    return;
+  for (int y = drawnY1; y < drawnY2; y++) {
+    const std::size_t row{static_cast<std::size_t>(y) * width};
+    std::copy(other.pixels.begin() + row + drawnX1,
+              other.pixels.begin() + row + drawnX2,
+              pixels.begin() + row + drawnX1);
+  }
+  markDirty(drawnX1, drawnY1, drawnX2, drawnY2);
+  drawnX1 = drawnY1 = drawnX2 = drawnY2 = 0;
+}
+
+void Framebuffer::fillRect(int x, int y, int w, int h, std::uint32_t color) {
+  const int x1{std::max(0, x)}, x2{std::min(width, x + w)};
+  const int y1{std::max(0, y)}, y2{std::min(height, y + h)};
+  if (x1 >= x2)
+    return;
+  for (int row = y1; row < y2; row++)
+    fillSpan(x1, x2, row, color);
+}
+
+// Bresenham, both ends included like SDL_RenderLine
+void Framebuffer::drawLine(int x1, int y1, int x2, int y2,
+                           std::uint32_t color) {
+  if (y1 == y2) {
+    fillRect(std::min(x1, x2), y1, std::abs(x2 - x1) + 1, 1, color);
+    return;
+  }
+  if (x1 == x2) {
+    fillRect(x1, std::min(y1, y2), 1, std::abs(y2 - y1) + 1, color);
+    return;
+  }
+  const int dx{std::abs(x2 - x1)}, dy{-std::abs(y2 - y1)};
+  const int sx{x1 < x2 ? 1 : -1}, sy{y1 < y2 ? 1 : -1};
+  int error{dx + dy};
+  while (true) {
+    if (x1 >= 0 && x1 < width && y1 >= 0 && y1 < height)
+      fillSpan(x1, x1 + 1, y1, color);
+    if (x1 == x2 && y1 == y2)
+      return;
+    const int e2{2 * error};
+    if (e2 >= dy)
+      error += dy, x1 += sx;
+    if (e2 <= dx)
+      error += dx, y1 += sy;
+  }
+}
+
+// pixels whose center is inside, one span per row
+void Framebuffer::fillTriangle(float x1, float y1, float x2, float y2,
+                               float x3, float y3, std::uint32_t color) {
+  const float xs[3]{x1, x2, x3}, ys[3]{y1, y2, y3};
+  const int top{std::max(
+      0, static_cast<int>(std::ceil(std::min({y1, y2, y3}) - 0.5f)))};
+  const int bottom{std::min(
+      height - 1, static_cast<int>(std::floor(std::max({y1, y2, y3}) - 0.5f)))};
+  for (int y = top; y <= bottom; y++) {
+    const float center{y + 0.5f};
+    float left{INFINITY}, right{-INFINITY};
+    for (int i = 0; i < 3; i++) {
+      const int j{(i + 1) % 3};
+      if (ys[i] == ys[j] || center < std::min(ys[i], ys[j]) ||
+          center > std::max(ys[i], ys[j]))
+        continue;
+      const float x{xs[i] + (center - ys[i]) * (xs[j] - xs[i]) /
+                                (ys[j] - ys[i])};
+      left = std::min(left, x), right = std::max(right, x);
+    }
+    if (left > right)
+      continue;
+    const int begin{std::max(0, static_cast<int>(std::ceil(left - 0.5f)))};
+    const int end{std::min(width, static_cast<int>(std::ceil(right - 0.5f)))};
+    if (begin < end)
+      fillSpan(begin, end, y, color);
+  }
+}
+
+// same pixels as the per point loop it replaces: dx, dy in [-r, r) with
+// dx * dx + dy * dy < r * r
+void Framebuffer::fillCircle(int x, int y, int r, std::uint32_t color) {
+  for (int dy = -r; dy < r; dy++) {
+    const int row{y + dy};
+    const int m{r * r - dy * dy};
+    if (row < 0 || row >= height || m <= 0)
+      continue;
+    int k{static_cast<int>(std::sqrt(static_cast<double>(m)))};
+    while (k * k >= m)
+      k--;
+    while ((k + 1) * (k + 1) < m)
+      k++;
+    const int begin{std::max(0, x - k)};
+    const int end{std::min(width, x + std::min(k, r - 1) + 1)};
+    if (begin < end)
+      fillSpan(begin, end, row, color);
+  }
+}
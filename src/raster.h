@@ -0,0 +1,54 @@
+#ifndef RASTER_H
+#define RASTER_H
+
+#include <cstdint>
+#include <vector>
+
+namespace gamespace {
+
+/**
+ * @brief ARGB8888 pixels drawn by the CPU, for machines where every SDL
+ * draw call goes through a slow software renderer anyway.
+ *
+ * Colors are 0xAARRGGBB, anything with an alpha below 255 is blended over
+ * what is already there like SDL_BLENDMODE_BLEND. Shapes cover the same
+ * pixels as the SDL calls they replace. Everything is clipped to the buffer.
+ */
+class Framebuffer {
+public:
+  struct Rect {
+    int x, y, w, h;
+  };
+
+  void resize(int width, int height);
+  void clear(std::uint32_t color);
+  void copyFrom(const Framebuffer &other); // takes its size too
+  // copies back only what was drawn since the last copyFrom or restoreFrom,
+  // other must not have changed since then
+  void restoreFrom(const Framebuffer &other);
+  void fillRect(int x, int y, int w, int h, std::uint32_t color);
+  void drawLine(int x1, int y1, int x2, int y2, std::uint32_t color);
+  void fillTriangle(float x1, float y1, float x2, float y2, float x3,
+                    float y3, std::uint32_t color);
+  void fillCircle(int x, int y, int r, std::uint32_t color);
+
+  int getWidth() const { return width; }
+  int getHeight() const { return height; }
+  const std::uint32_t *data() const { return pixels.data(); }
+  // pixels changed since the last takeDirty(), w == 0 when none
+  Rect takeDirty();
+
+private:
+  int width, height;
+  std::vector<std::uint32_t> pixels;
+  int dirtyX1, dirtyY1, dirtyX2, dirtyY2; // empty when x1 >= x2
+  int drawnX1, drawnY1, drawnX2, drawnY2; // same, for restoreFrom
+  void fillSpan(int x1, int x2, int y, std::uint32_t color);
+  void markDirty(int x1, int y1, int x2, int y2);
+
+public:
+  Framebuffer();
+};
+
+} // namespace gamespace
+#endif
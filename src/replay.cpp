@@ -0,0 +1,177 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "board.h"
+#include "gamelog.h"
+#include "rules.h"
+#include "view.h"
+
+using namespace gamespace;
+using namespace std::literals;
+
+static void printUsage(const char *program) {
+  std::cerr << "usage: " << program
+            << " <game log> [--game <n>] [--out <prefix>] [--threads <n>]"
+               " [--renderer sdl|software] [--bench]\n";
+}
+
+/**
+ * The board after one roll: where every piece is and who rolled what.
+ */
+struct Frame {
+  std::array<std::uint8_t, 16> positions; // color * 4 + piece
+  std::array<bool, 4> seated;             // colors in the game
+  int mover;                              // color that rolled
+  int dice;
+};
+
+static const Color &toViewColor(int color) {
+  static const Color *colors[4]{&Color::RED, &Color::GREEN, &Color::YELLOW,
+                                &Color::BLUE};
+  return *colors[color];
+}
+
+// replays the rolls of the game starting at r, one frame per roll
+template <class R>
+static bool replay(const GameRecord *r, const GameRecord *end,
+                   std::vector<Frame> &frames) {
+  typename R::State state;
+  R::reset(state);
+  for (r++; r < end && r->type == GameRecord::ROLL; r++) {
+    if (r->seat != state.currentPlayer) {
+      (std::cerr << "Game log does not follow the rules\n").flush();
+      return false;
+    }
+    Frame frame{};
+    frame.mover = R::seatColor(r->seat);
+    frame.dice = r->dice();
+    const bool canMove{R::roll(state, r->dice())};
+    if (canMove != r->moved() ||
+        (canMove && !(R::legalMoves(state, r->dice()) >> r->piece() & 1))) {
+      (std::cerr << "Game log does not follow the rules\n").flush();
+      return false;
+    }
+    if (canMove)
+      R::play(state, r->piece(), r->dice());
+    for (int seat = 0; seat < R::NUM_PLAYERS; seat++) {
+      const int color{R::seatColor(seat)};
+      frame.seated[color] = true;
+      for (int i = 0; i < R::PIECES_PER_COLOR; i++)
+        frame.positions[color * 4 + i] = state.pieces[seat][i];
+    }
+    frames.push_back(frame);
+  }
+  return true;
+}
+
+// same layout as the game: jail slots hold one piece, other tiles up to 4
+static void drawFrame(View &view, const Frame &frame) {
+  view.drawBoard();
+  std::array<int, NUM_POSITIONS> onTile{};
+  const int ts{view.getLayout().tileSize};
+  for (int color = 0; color < 4; color++) {
+    if (!frame.seated[color])
+      continue;
+    for (int i = 0; i < 4; i++) {
+      const int position{frame.positions[color * 4 + i]};
+      auto [x, y] = BoardPosition::toXYOffset(position);
+      const int slot{onTile[position]++};
+      if (position >= 76)
+        view.drawPiece(x * ts, y * ts, toViewColor(color));
+      else if (slot < 4)
+        view.drawPiece(x * ts + (slot % 2 ? 3 : 1) * ts / 4,
+                       y * ts + (slot / 2 ? 3 : 1) * ts / 4,
+                       toViewColor(color));
+    }
+  }
+  view.preparePlayerDice(toViewColor(frame.mover));
+  view.drawDice(toViewColor(frame.mover), frame.dice);
+}
+
+int main(int argc, char *argv[]) {
+  std::string path, prefix{"frame_"};
+  long game{0};
+  unsigned threads{std::max(1u, std::thread::hardware_concurrency())};
+  bool bench{false};
+  Backend backend{Backend::SDL};
+  for (int i = 1; i < argc; i++) {
+    std::string arg{argv[i]};
+    if (arg == "--game" && i + 1 < argc)
+      game = std::max(0L, std::atol(argv[++i]));
+    else if (arg == "--out" && i + 1 < argc)
+      prefix = argv[++i];
+    else if (arg == "--threads" && i + 1 < argc)
+      threads = std::max(1, std::atoi(argv[++i]));
+    else if (arg == "--renderer" && i + 1 < argc &&
+             (argv[i + 1] == "sdl"s || argv[i + 1] == "software"s))
+      backend = argv[++i] == "software"s ? Backend::SOFTWARE : Backend::SDL;
+    else if (arg == "--bench")
+      bench = true;
+    else if (!arg.starts_with("--") && path.empty())
+      path = arg;
+    else
+      return printUsage(argv[0]), 1;
+  }
+  if (path.empty())
+    return printUsage(argv[0]), 1;
+
+  GameLog log;
+  if (!log.open(path))
+    return 1;
+  const GameRecord *start{log.begin()};
+  for (long seen = -1; start < log.end(); start++)
+    if (start->type == GameRecord::START && ++seen == game)
+      break;
+  if (start == log.end()) {
+    (std::cerr << "[" << path << "] has no game " << game << "\n").flush();
+    return 1;
+  }
+  if (start->seat < 2 || start->seat > 4 || !start->knownRules()) {
+    (std::cerr << "Game " << game << " has a bad player count or rules\n")
+        .flush();
+    return 1;
+  }
+  // the rules it was recorded with
+  std::vector<Frame> frames;
+  if (!withRules(start->seat, start->rules(), [&](auto tag) {
+        return replay<decltype(tag)>(start, log.end(), frames);
+      }))
+    return 1;
+
+  // one renderer per thread, frame i goes to thread i % threads
+  auto begin{std::chrono::steady_clock::now()};
+  threads = std::min<unsigned>(threads, std::max<size_t>(1, frames.size()));
+  std::vector<int> failed(threads, 0);
+  std::vector<std::thread> workers;
+  for (unsigned t = 0; t < threads; t++)
+    workers.emplace_back([&, t] {
+      View view(true, backend);
+      char name[32];
+      for (size_t i = t; i < frames.size(); i += threads) {
+        drawFrame(view, frames[i]);
+        std::snprintf(name, sizeof(name), "%05zu.png", i);
+        if (bench)
+          view.render(); // batched drawing only happens here
+        else if (!view.saveImage((prefix + name).c_str()))
+          failed[t]++;
+      }
+    });
+  for (std::thread &worker : workers)
+    worker.join();
+  const double seconds{std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - begin)
+                           .count()};
+  std::cout << frames.size() << " frames on " << threads << " threads in "
+            << seconds << "s, " << frames.size() / seconds << " frames/s\n";
+  for (int f : failed)
+    if (f != 0)
+      return 1;
+  return 0;
+}
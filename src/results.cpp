@@ -0,0 +1,591 @@
+#include "results.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace gamespace;
+
+// "LUDORES" and a format version, padded to 16 bytes like the game log
+static const char MAGIC[8]{'L', 'U', 'D', 'O', 'R', 'E', 'S', '\0'};
+static const std::uint32_t VERSION{1};
+static const std::size_t HEADER_SIZE{16};
+
+namespace {
+
+enum Encoding : std::uint8_t {
+  PACKED, // value - base in width bits
+  DELTA,  // first value in base, then step - deltaBase in width bits
+  RUNS    // value - base in width bits, run length - 1 in runWidth bits
+};
+
+struct BlockHeader {
+  std::uint32_t rows;
+  std::uint32_t columns;
+  std::uint64_t size; // bytes, this header included
+};
+
+struct ColumnHeader {
+  Encoding encoding;
+  std::uint8_t width;
+  std::uint8_t runWidth;
+  std::uint8_t padding[5];
+  std::uint64_t offset; // of the payload, from the block header
+  std::uint64_t words;  // payload size in 64 bit words
+  std::int64_t base;
+  std::int64_t deltaBase;
+  std::int64_t min;
+  std::int64_t max;
+};
+
+struct Trailer {
+  std::uint64_t footerOffset;
+  char magic[8];
+};
+
+// bits needed for values up to x
+int bitWidth(std::uint64_t x) { return 64 - std::countl_zero(x); }
+
+// values are packed from the low bits up, a value may span two words
+class BitWriter {
+public:
+  explicit BitWriter(std::vector<std::uint64_t> &out)
+      : out(out), word(0), used(0) {}
+  void put(std::uint64_t value, int width) {
+    if (width == 0)
+      return;
+    if (width < 64)
+      value &= (std::uint64_t{1} << width) - 1;
+    word |= value << used;
+    if (used + width >= 64) {
+      out.push_back(word);
+      word = used == 0 ? 0 : value >> (64 - used);
+      used = used + width - 64;
+    } else {
+      used += width;
+    }
+  }
+  void finish() {
+    if (used != 0)
+      out.push_back(word);
+    word = 0, used = 0;
+  }
+
+private:
+  std::vector<std::uint64_t> &out;
+  std::uint64_t word;
+  int used;
+};
+
+class BitReader {
+public:
+  explicit BitReader(const std::uint64_t *words) : words(words), position(0) {}
+  std::uint64_t get(int width) {
+    if (width == 0)
+      return 0;
+    const std::size_t i{position >> 6};
+    const int shift{static_cast<int>(position & 63)};
+    std::uint64_t value{words[i] >> shift};
+    if (shift + width > 64)
+      value |= words[i + 1] << (64 - shift);
+    position += width;
+    return width == 64 ? value : value & ((std::uint64_t{1} << width) - 1);
+  }
+
+private:
+  const std::uint64_t *words;
+  std::size_t position;
+};
+
+// arithmetic wraps like the unsigned seeds it stores
+std::int64_t add(std::int64_t a, std::uint64_t b) {
+  return static_cast<std::int64_t>(static_cast<std::uint64_t>(a) + b);
+}
+std::uint64_t distance(std::int64_t from, std::int64_t to) {
+  return static_cast<std::uint64_t>(to) - static_cast<std::uint64_t>(from);
+}
+
+// picks the smallest encoding of one column of a block
+void encode(const std::vector<std::int64_t> &values, ColumnHeader &header,
+            std::vector<std::uint64_t> &payload) {
+  const std::size_t n{values.size()};
+  const auto [low, high]{std::minmax_element(values.begin(), values.end())};
+  header = {};
+  header.min = *low, header.max = *high;
+  const int valueWidth{bitWidth(distance(*low, *high))};
+
+  std::int64_t deltaMin{0}, deltaMax{0};
+  std::size_t runs{1}, longestRun{1}, run{1};
+  for (std::size_t i = 1; i < n; i++) {
+    const std::int64_t delta{
+        static_cast<std::int64_t>(distance(values[i - 1], values[i]))};
+    if (i == 1)
+      deltaMin = deltaMax = delta;
+    deltaMin = std::min(deltaMin, delta), deltaMax = std::max(deltaMax, delta);
+    if (values[i] == values[i - 1]) {
+      longestRun = std::max(longestRun, ++run);
+    } else {
+      runs++, run = 1;
+    }
+  }
+  const int deltaWidth{bitWidth(distance(deltaMin, deltaMax))};
+  const int runWidth{bitWidth(longestRun - 1)};
+  const std::size_t packedBits{n * valueWidth};
+  const std::size_t deltaBits{(n - 1) * deltaWidth};
+  const std::size_t runBits{runs * (valueWidth + runWidth)};
+
+  const std::size_t start{payload.size()};
+  BitWriter writer(payload);
+  if (runBits < packedBits && runBits < deltaBits) {
+    header.encoding = RUNS, header.base = *low;
+    header.width = valueWidth, header.runWidth = runWidth;
+    for (std::size_t i = 0, length; i < n; i += length) {
+      for (length = 1; i + length < n && values[i + length] == values[i];
+           length++)
+        ;
+      writer.put(distance(*low, values[i]), valueWidth);
+      writer.put(length - 1, runWidth);
+    }
+  } else if (deltaBits < packedBits) {
+    header.encoding = DELTA, header.base = values[0];
+    header.deltaBase = deltaMin, header.width = deltaWidth;
+    for (std::size_t i = 1; i < n; i++)
+      writer.put(distance(deltaMin, static_cast<std::int64_t>(distance(
+                                        values[i - 1], values[i]))),
+                 deltaWidth);
+  } else {
+    header.encoding = PACKED, header.base = *low, header.width = valueWidth;
+    for (std::int64_t value : values)
+      writer.put(distance(*low, value), valueWidth);
+  }
+  writer.finish();
+  header.words = payload.size() - start;
+}
+
+void decode(const ColumnHeader &header, const std::uint64_t *payload,
+            std::size_t n, std::vector<std::int64_t> &values) {
+  values.resize(n);
+  BitReader reader(payload);
+  if (header.encoding == RUNS) {
+    for (std::size_t i = 0; i < n;) {
+      const std::int64_t value{add(header.base, reader.get(header.width))};
+      const std::size_t length{
+          std::min<std::size_t>(reader.get(header.runWidth) + 1, n - i)};
+      std::fill_n(values.begin() + i, length, value);
+      i += length;
+    }
+  } else if (header.encoding == DELTA) {
+    std::int64_t value{header.base};
+    values[0] = value;
+    for (std::size_t i = 1; i < n; i++)
+      values[i] = value =
+          add(value, static_cast<std::uint64_t>(
+                         add(header.deltaBase, reader.get(header.width))));
+  } else {
+    for (std::size_t i = 0; i < n; i++)
+      values[i] = add(header.base, reader.get(header.width));
+  }
+}
+
+const char *const COLUMN_NAMES[NUM_RESULT_COLUMNS]{
+    "seed",         "players",        "policy.red",      "policy.green",
+    "policy.yellow", "policy.blue",   "winner",          "turns",
+    "captures.red", "captures.green", "captures.yellow", "captures.blue",
+    "move_ns"};
+
+} // namespace
+
+const char *gamespace::columnName(ResultColumn column) {
+  const int index{static_cast<int>(column)};
+  return index < NUM_RESULT_COLUMNS ? COLUMN_NAMES[index] : nullptr;
+}
+
+ResultColumn gamespace::columnFromName(const std::string &name) {
+  for (int i = 0; i < NUM_RESULT_COLUMNS; i++)
+    if (name == COLUMN_NAMES[i])
+      return static_cast<ResultColumn>(i);
+  return ResultColumn::COUNT;
+}
+
+bool ResultPredicate::test(std::int64_t v) const {
+  switch (op) {
+  case EQ:
+    return v == value;
+  case NE:
+    return v != value;
+  case LT:
+    return v < value;
+  case LE:
+    return v <= value;
+  case GT:
+    return v > value;
+  case GE:
+    return v >= value;
+  }
+  return false;
+}
+
+bool ResultPredicate::mayMatch(std::int64_t min, std::int64_t max) const {
+  switch (op) {
+  case EQ:
+    return min <= value && value <= max;
+  case NE:
+    return min != value || max != value;
+  case LT:
+    return min < value;
+  case LE:
+    return min <= value;
+  case GT:
+    return max > value;
+  case GE:
+    return max >= value;
+  }
+  return true;
+}
+
+bool ResultPredicate::matchesAll(std::int64_t min, std::int64_t max) const {
+  switch (op) {
+  case EQ:
+    return min == value && max == value;
+  case NE:
+    return value < min || value > max;
+  default:
+    return test(min) && test(max); // the others are monotonic
+  }
+}
+
+ResultWriter::ResultWriter(const std::string &path)
+    : mutex(), pending(), policies(), fileMutex(),
+      file(path, std::ios::binary | std::ios::trunc), blockOffsets(),
+      offset(HEADER_SIZE), closed(false) {
+  if (!file) {
+    (std::cerr << "Could not create result file [" << path << "]\n").flush();
+    return;
+  }
+  char header[HEADER_SIZE]{};
+  const std::uint32_t columns{NUM_RESULT_COLUMNS};
+  std::memcpy(header, MAGIC, sizeof(MAGIC));
+  std::memcpy(header + sizeof(MAGIC), &VERSION, sizeof(VERSION));
+  std::memcpy(header + sizeof(MAGIC) + sizeof(VERSION), &columns,
+              sizeof(columns));
+  file.write(header, sizeof(header));
+  for (std::vector<std::int64_t> &column : pending)
+    column.reserve(BLOCK_ROWS);
+}
+
+ResultWriter::~ResultWriter() { close(); }
+
+std::uint8_t ResultWriter::policy(const std::string &name) {
+  std::lock_guard lock(mutex);
+  auto found{std::find(policies.begin(), policies.end(), name)};
+  if (found != policies.end())
+    return found - policies.begin();
+  if (policies.size() == GameResult::NO_POLICY - 1) {
+    (std::cerr << "Too many policies, [" << name << "] shares the last id\n")
+        .flush();
+    return GameResult::NO_POLICY - 1;
+  }
+  policies.push_back(name);
+  return policies.size() - 1;
+}
+
+void ResultWriter::add(const GameResult &result) {
+  std::unique_lock lock(mutex);
+  const std::int64_t values[NUM_RESULT_COLUMNS]{
+      static_cast<std::int64_t>(result.seed),
+      result.numPlayers,
+      result.policies[0],
+      result.policies[1],
+      result.policies[2],
+      result.policies[3],
+      result.winner,
+      result.turns,
+      result.captures[0],
+      result.captures[1],
+      result.captures[2],
+      result.captures[3],
+      result.moveNanos};
+  for (int c = 0; c < NUM_RESULT_COLUMNS; c++)
+    pending[c].push_back(values[c]);
+  if (pending[0].size() < BLOCK_ROWS)
+    return;
+  Columns full;
+  for (int c = 0; c < NUM_RESULT_COLUMNS; c++) {
+    full[c].swap(pending[c]);
+    pending[c].reserve(BLOCK_ROWS);
+  }
+  lock.unlock();
+  writeBlock(full); // other threads keep adding meanwhile
+}
+
+void ResultWriter::writeBlock(const Columns &columns) {
+  const std::size_t rows{columns[0].size()};
+  std::array<ColumnHeader, NUM_RESULT_COLUMNS> headers;
+  std::vector<std::uint64_t> payload;
+  std::size_t start{sizeof(BlockHeader) + sizeof(headers)};
+  for (int c = 0; c < NUM_RESULT_COLUMNS; c++) {
+    const std::size_t words{payload.size()};
+    encode(columns[c], headers[c], payload);
+    headers[c].offset = start + words * sizeof(std::uint64_t);
+  }
+  const BlockHeader block{static_cast<std::uint32_t>(rows),
+                          NUM_RESULT_COLUMNS,
+                          start + payload.size() * sizeof(std::uint64_t)};
+  std::lock_guard lock(fileMutex);
+  if (closed || !file.is_open())
+    return;
+  blockOffsets.push_back(offset);
+  file.write(reinterpret_cast<const char *>(&block), sizeof(block));
+  file.write(reinterpret_cast<const char *>(headers.data()), sizeof(headers));
+  file.write(reinterpret_cast<const char *>(payload.data()),
+             payload.size() * sizeof(std::uint64_t));
+  offset += block.size;
+}
+
+bool ResultWriter::close() {
+  {
+    std::unique_lock lock(mutex);
+    if (!pending[0].empty()) {
+      Columns last;
+      for (int c = 0; c < NUM_RESULT_COLUMNS; c++)
+        last[c].swap(pending[c]);
+      lock.unlock();
+      writeBlock(last);
+    }
+  }
+  std::lock_guard lock(fileMutex);
+  if (closed || !file.is_open())
+    return false;
+  closed = true;
+  // dictionary, then the block index, everything 8 byte aligned
+  std::vector<char> footer;
+  auto append = [&](const void *data, std::size_t size) {
+    const char *bytes{static_cast<const char *>(data)};
+    footer.insert(footer.end(), bytes, bytes + size);
+  };
+  const std::uint64_t numPolicies{policies.size()};
+  append(&numPolicies, sizeof(numPolicies));
+  for (const std::string &name : policies) {
+    const std::uint64_t length{name.size()};
+    append(&length, sizeof(length));
+    append(name.data(), name.size());
+    footer.resize((footer.size() + 7) / 8 * 8, '\0');
+  }
+  const std::uint64_t numBlocks{blockOffsets.size()};
+  append(&numBlocks, sizeof(numBlocks));
+  append(blockOffsets.data(), blockOffsets.size() * sizeof(std::uint64_t));
+  Trailer trailer{offset, {}};
+  std::memcpy(trailer.magic, MAGIC, sizeof(MAGIC));
+  append(&trailer, sizeof(trailer));
+  file.write(footer.data(), footer.size());
+  file.close();
+  return !file.fail();
+}
+
+ResultReader::ResultReader()
+    : mapping(nullptr), mappingSize(0), blockOffsets(), policyNames(),
+      numRows(0), skipped(0) {}
+
+ResultReader::~ResultReader() { close(); }
+
+void ResultReader::close() {
+  if (mapping != nullptr)
+    munmap(mapping, mappingSize);
+  mapping = nullptr;
+  blockOffsets.clear();
+  policyNames.clear();
+  numRows = 0;
+}
+
+bool ResultReader::open(const std::string &path) {
+  close();
+  int fd{::open(path.c_str(), O_RDONLY)};
+  if (fd < 0) {
+    (std::cerr << "Could not open result file [" << path << "]\n").flush();
+    return false;
+  }
+  struct stat info;
+  const bool sized{fstat(fd, &info) == 0 &&
+                   static_cast<std::size_t>(info.st_size) >=
+                       HEADER_SIZE + sizeof(Trailer) + sizeof(std::uint64_t)};
+  void *data{sized ? mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0)
+                   : MAP_FAILED};
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    (std::cerr << "Could not map result file [" << path << "]\n").flush();
+    return false;
+  }
+  mapping = data;
+  mappingSize = info.st_size;
+  const char *bytes{static_cast<const char *>(data)};
+  std::uint32_t version, columns;
+  std::memcpy(&version, bytes + sizeof(MAGIC), sizeof(version));
+  std::memcpy(&columns, bytes + sizeof(MAGIC) + sizeof(version),
+              sizeof(columns));
+  Trailer trailer;
+  std::memcpy(&trailer, bytes + mappingSize - sizeof(trailer),
+              sizeof(trailer));
+  if (std::memcmp(bytes, MAGIC, sizeof(MAGIC)) != 0 || version != VERSION ||
+      columns != NUM_RESULT_COLUMNS ||
+      std::memcmp(trailer.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+      trailer.footerOffset % 8 != 0 ||
+      trailer.footerOffset > mappingSize - sizeof(trailer)) {
+    (std::cerr << "[" << path
+               << "] is not a complete result file of this version\n")
+        .flush();
+    close();
+    return false;
+  }
+  // the footer is written by the same build, only its bounds are checked
+  const char *footer{bytes + trailer.footerOffset};
+  const char *end{bytes + mappingSize - sizeof(trailer)};
+  auto read = [&](std::uint64_t &value) {
+    if (footer + sizeof(value) > end)
+      return false;
+    std::memcpy(&value, footer, sizeof(value));
+    footer += sizeof(value);
+    return true;
+  };
+  std::uint64_t count, length;
+  bool valid{read(count)};
+  for (std::uint64_t i = 0; valid && i < count; i++) {
+    valid = read(length) && length <= static_cast<std::size_t>(end - footer);
+    if (valid) {
+      policyNames.emplace_back(footer, length);
+      footer += (length + 7) / 8 * 8;
+    }
+  }
+  valid = valid && read(count) &&
+          count <= static_cast<std::size_t>(end - footer) / 8;
+  for (std::uint64_t i = 0; valid && i < count; i++) {
+    std::uint64_t block{0};
+    valid = read(block);
+    const BlockHeader *header{
+        reinterpret_cast<const BlockHeader *>(bytes + block)};
+    valid = valid && block % 8 == 0 &&
+            block + sizeof(BlockHeader) + NUM_RESULT_COLUMNS *
+                                               sizeof(ColumnHeader) <=
+                trailer.footerOffset &&
+            block + header->size <= trailer.footerOffset &&
+            header->columns == NUM_RESULT_COLUMNS;
+    const ColumnHeader *columns{reinterpret_cast<const ColumnHeader *>(
+        header + 1)};
+    for (int c = 0; valid && c < NUM_RESULT_COLUMNS; c++)
+      valid = columns[c].offset + columns[c].words * 8 <= header->size;
+    blockOffsets.push_back(block);
+    numRows += valid ? header->rows : 0;
+  }
+  if (!valid) {
+    (std::cerr << "Result file [" << path << "] is corrupted\n").flush();
+    close();
+    return false;
+  }
+  madvise(mapping, mappingSize, MADV_SEQUENTIAL);
+  return true;
+}
+
+int ResultReader::policy(const std::string &name) const {
+  auto found{std::find(policyNames.begin(), policyNames.end(), name)};
+  return found == policyNames.end() ? -1 : found - policyNames.begin();
+}
+
+size_t ResultReader::count(std::span<const ResultPredicate> predicates) const {
+  return query(predicates, {}, nullptr);
+}
+
+size_t
+ResultReader::scan(std::span<const ResultPredicate> predicates,
+                   const std::function<void(const GameResult &)> &visit) const {
+  static constexpr auto ALL{[] {
+    std::array<ResultColumn, NUM_RESULT_COLUMNS> all{};
+    for (int c = 0; c < NUM_RESULT_COLUMNS; c++)
+      all[c] = static_cast<ResultColumn>(c);
+    return all;
+  }()};
+  return query(predicates, ALL, &visit);
+}
+
+size_t
+ResultReader::scan(std::span<const ResultPredicate> predicates,
+                   std::span<const ResultColumn> columns,
+                   const std::function<void(const GameResult &)> &visit) const {
+  return query(predicates, columns, &visit);
+}
+
+size_t ResultReader::query(
+    std::span<const ResultPredicate> predicates,
+    std::span<const ResultColumn> columns,
+    const std::function<void(const GameResult &)> *visit) const {
+  skipped = 0;
+  size_t matched{0};
+  std::array<std::vector<std::int64_t>, NUM_RESULT_COLUMNS> values;
+  std::vector<char> selected;
+  const char *bytes{static_cast<const char *>(mapping)};
+  for (std::uint64_t offset : blockOffsets) {
+    const BlockHeader &block{
+        *reinterpret_cast<const BlockHeader *>(bytes + offset)};
+    const ColumnHeader *headers{reinterpret_cast<const ColumnHeader *>(
+        bytes + offset + sizeof(BlockHeader))};
+    auto column = [&](int c) {
+      decode(headers[c],
+             reinterpret_cast<const std::uint64_t *>(bytes + offset +
+                                                     headers[c].offset),
+             block.rows, values[c]);
+    };
+    if (!std::all_of(predicates.begin(), predicates.end(),
+                     [&](const ResultPredicate &p) {
+                       const ColumnHeader &h{
+                           headers[static_cast<int>(p.column)]};
+                       return p.mayMatch(h.min, h.max);
+                     })) {
+      skipped++;
+      continue;
+    }
+    std::array<bool, NUM_RESULT_COLUMNS> decoded{};
+    selected.assign(block.rows, 1);
+    for (const ResultPredicate &p : predicates) {
+      const int c{static_cast<int>(p.column)};
+      if (p.matchesAll(headers[c].min, headers[c].max))
+        continue;
+      if (!decoded[c])
+        column(c), decoded[c] = true;
+      for (std::size_t i = 0; i < block.rows; i++)
+        selected[i] &= p.test(values[c][i]);
+    }
+    const size_t passed{static_cast<size_t>(
+        std::count(selected.begin(), selected.end(), 1))};
+    matched += passed;
+    if (visit == nullptr || passed == 0)
+      continue;
+    for (ResultColumn c : columns)
+      if (!decoded[static_cast<int>(c)])
+        column(static_cast<int>(c)), decoded[static_cast<int>(c)] = true;
+    for (std::size_t i = 0; i < block.rows; i++) {
+      if (!selected[i])
+        continue;
+      auto v = [&](int c) { return decoded[c] ? values[c][i] : 0; };
+      auto at = [&](ResultColumn c) { return v(static_cast<int>(c)); };
+      GameResult result;
+      result.seed = static_cast<std::uint64_t>(at(ResultColumn::SEED));
+      result.numPlayers = at(ResultColumn::PLAYERS);
+      // the file decides this byte, keep it a valid color index
+      result.winner = std::clamp<std::int64_t>(at(ResultColumn::WINNER), 0,
+                                               GameResult::NO_WINNER);
+      result.turns = at(ResultColumn::TURNS);
+      result.moveNanos = at(ResultColumn::MOVE_NANOS);
+      for (int color = 0; color < 4; color++) {
+        result.policies[color] =
+            v(static_cast<int>(ResultColumn::POLICY_RED) + color);
+        result.captures[color] =
+            v(static_cast<int>(ResultColumn::CAPTURES_RED) + color);
+      }
+      (*visit)(result);
+    }
+  }
+  return matched;
+}
@@ -0,0 +1,172 @@
+#ifndef RESULTS_H
+#define RESULTS_H
+
+#include "board.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace gamespace {
+
+/**
+ * @brief One finished (or abandoned) game of a simulation or tournament.
+ * Everything per seat is stored by Player::PlayerColor, a 2 player game
+ * only uses RED and YELLOW like BasicRules::seatColor.
+ */
+struct GameResult {
+  static constexpr std::uint8_t NO_WINNER{4};
+  static constexpr std::uint8_t NO_POLICY{255}; // colors nobody plays
+
+  std::uint64_t seed;
+  std::uint8_t numPlayers;
+  std::array<std::uint8_t, 4> policies; // ids from ResultWriter::policy
+  std::uint8_t winner; // a Player::PlayerColor, NO_WINNER if unfinished
+  std::uint32_t turns;
+  std::array<std::uint16_t, 4> captures; // moves of the color that captured
+  std::uint32_t moveNanos; // game time over the moves played
+};
+
+/**
+ * @brief Columns of a result file, one per field of GameResult.
+ */
+enum class ResultColumn : std::uint8_t {
+  SEED,
+  PLAYERS,
+  POLICY_RED,
+  POLICY_GREEN,
+  POLICY_YELLOW,
+  POLICY_BLUE,
+  WINNER,
+  TURNS,
+  CAPTURES_RED,
+  CAPTURES_GREEN,
+  CAPTURES_YELLOW,
+  CAPTURES_BLUE,
+  MOVE_NANOS,
+  COUNT
+};
+constexpr int NUM_RESULT_COLUMNS{static_cast<int>(ResultColumn::COUNT)};
+
+// "turns", "winner", "captures.red", ... nullptr past the last column
+const char *columnName(ResultColumn column);
+// COUNT when unknown
+ResultColumn columnFromName(const std::string &name);
+
+/**
+ * @brief A condition on one column, values as stored: colors for the
+ * winner, dictionary ids for policies.
+ */
+struct ResultPredicate {
+  enum Op { EQ, NE, LT, LE, GT, GE };
+  ResultColumn column;
+  Op op;
+  std::int64_t value;
+  bool test(std::int64_t v) const;
+  // false when no value in [min, max] can pass
+  bool mayMatch(std::int64_t min, std::int64_t max) const;
+  // true when every value in [min, max] passes
+  bool matchesAll(std::int64_t min, std::int64_t max) const;
+};
+
+/**
+ * @brief Writes game results as a column store: rows are cut into blocks
+ * of BLOCK_ROWS and every column of a block is stored on its own with
+ * whichever of bit packing from the minimum, deltas or runs is smallest,
+ * and with its minimum and maximum so readers can skip the block.
+ * Policy names are a dictionary kept once per file.
+ *
+ * add() may be called from any number of threads. The thread that fills a
+ * block encodes it, only the write to the file is serialized, so encoding
+ * runs on all the workers. Blocks of different threads interleave, the
+ * file keeps no row order.
+ *
+ * File layout, native endianness:
+ *   "LUDORES" version
+ *   blocks: BlockHeader, ColumnHeader[NUM_RESULT_COLUMNS], payloads
+ *   footer: dictionary, block offsets, footer offset, "LUDORES"
+ */
+class ResultWriter {
+public:
+  static constexpr std::size_t BLOCK_ROWS{1 << 16};
+
+  bool isOpen() const { return file.is_open() && file.good(); }
+  // dictionary id of a policy name, adding it if needed
+  std::uint8_t policy(const std::string &name);
+  void add(const GameResult &result);
+  // writes what is left and the footer, also done by the destructor
+  bool close();
+
+private:
+  using Columns = std::array<std::vector<std::int64_t>, NUM_RESULT_COLUMNS>;
+  std::mutex mutex; // guards pending and policies
+  Columns pending;
+  std::vector<std::string> policies;
+  std::mutex fileMutex; // guards everything below
+  std::ofstream file;
+  std::vector<std::uint64_t> blockOffsets;
+  std::uint64_t offset;
+  bool closed;
+  void writeBlock(const Columns &columns);
+
+public:
+  explicit ResultWriter(const std::string &path);
+  ~ResultWriter();
+  ResultWriter(const ResultWriter &) = delete;
+  ResultWriter &operator=(const ResultWriter &) = delete;
+};
+
+/**
+ * @brief Read only, memory-mapped result file. Queries take predicates
+ * that all have to hold: blocks whose minimum and maximum rule a predicate
+ * out are never decoded, and of the others only the columns the
+ * predicates need are decoded until some row passes.
+ */
+class ResultReader {
+public:
+  bool open(const std::string &path);
+  size_t size() const { return numRows; }
+  size_t blocks() const { return blockOffsets.size(); }
+  const std::vector<std::string> &policies() const { return policyNames; }
+  // -1 when the name is not in the dictionary
+  int policy(const std::string &name) const;
+  size_t count(std::span<const ResultPredicate> predicates) const;
+  // visit gets every row that passes, returns how many did. The columns
+  // of a block are decoded whole once one of its rows passes
+  size_t scan(std::span<const ResultPredicate> predicates,
+              const std::function<void(const GameResult &)> &visit) const;
+  // same, but only the given columns and the ones the predicates test are
+  // decoded, the other fields are 0
+  size_t scan(std::span<const ResultPredicate> predicates,
+              std::span<const ResultColumn> columns,
+              const std::function<void(const GameResult &)> &visit) const;
+  // blocks the last query skipped without decoding them
+  size_t skippedBlocks() const { return skipped; }
+
+private:
+  void *mapping;
+  std::size_t mappingSize;
+  std::vector<std::uint64_t> blockOffsets;
+  std::vector<std::string> policyNames;
+  std::size_t numRows;
+  mutable size_t skipped;
+  void close();
+  size_t query(std::span<const ResultPredicate> predicates,
+               std::span<const ResultColumn> columns,
+               const std::function<void(const GameResult &)> *visit) const;
+
+public:
+  ResultReader();
+  ~ResultReader();
+  ResultReader(const ResultReader &) = delete;
+  ResultReader &operator=(const ResultReader &) = delete;
+};
+
+} // namespace gamespace
+#endif
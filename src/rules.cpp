@@ -0,0 +1,62 @@
+#include "rules.h"
+
+#include "board.h"
+#include "commons.h"
+
+using namespace gamespace;
+
+namespace {
+
+// variant independent tables, derived once from Piece and BoardPosition
+struct ClassicTables {
+  std::array<std::array<std::array<std::int8_t, 7>, NUM_POSITIONS>, 4>
+      destination;
+  std::array<std::array<std::uint8_t, NUM_POSITIONS>, 4> progress;
+  std::array<bool, NUM_POSITIONS> isProtected;
+  ClassicTables();
+};
+
+ClassicTables::ClassicTables() : destination(), progress(), isProtected() {
+  for (int color = 0; color < 4; color++) {
+    Player player(Player::PlayerType::ROBOT,
+                  static_cast<Player::PlayerColor>(color));
+    for (int position = 0; position < NUM_POSITIONS; position++) {
+      destination[color][position][0] = -1;
+      for (int diceValue = 1; diceValue <= 6; diceValue++) {
+        Piece piece(player, BoardPosition(position));
+        if (!piece.canAdvance(diceValue)) {
+          destination[color][position][diceValue] = -1;
+          continue;
+        }
+        piece.advance(diceValue);
+        destination[color][position][diceValue] = piece.pos.pos;
+      }
+    }
+    int position{Rules::jailPosition(color, 0)};
+    for (int steps = 1; steps <= Rules::FINAL_PROGRESS; steps++) {
+      position = BoardPosition::getNext(position, player.color);
+      progress[color][position] = steps;
+    }
+  }
+  for (int position = 0; position < NUM_POSITIONS; position++)
+    isProtected[position] = BoardPosition(position).isProtectedPosition();
+}
+
+const ClassicTables &classicTables() {
+  static const ClassicTables t;
+  return t;
+}
+
+} // namespace
+
+int detail::classicDestination(int color, int position, int diceValue) {
+  return classicTables().destination[color][position][diceValue];
+}
+
+int detail::pathProgress(int color, int position) {
+  return classicTables().progress[color][position];
+}
+
+bool detail::isProtectedSquare(int position) {
+  return classicTables().isProtected[position];
+}
@@ -0,0 +1,276 @@
+#ifndef RULES_H
+#define RULES_H
+
+#include "commons.h"
+
+#include <array>
+#include <cstdint>
+
+namespace gamespace {
+
+// what a game picks at startup, CLASSIC is ClassicRules, HOUSE HouseRules.
+// Game logs store the value, new ones go at the end.
+enum class RuleSet : std::uint8_t { CLASSIC, HOUSE };
+static const int NUM_RULE_SETS{2};
+
+constexpr const char *ruleSetName(RuleSet rules) {
+  return rules == RuleSet::HOUSE ? "house" : "classic";
+}
+
+/**
+ * @brief Rule variants, picked at compile time so the simulators never
+ * branch on them. The GUI plays the one --rules names, see RuleSet.
+ */
+struct ClassicRules {
+  static constexpr bool EXIT_ON_ONE{false};         // jail opens on 1 and 6
+  static constexpr bool THREE_SIXES_FORFEIT{false}; // six on the 3rd roll
+  static constexpr bool SAFE_SQUARES{true};   // isProtectedPosition squares
+  static constexpr bool CAPTURE_BONUS{true};  // capturing earns another roll
+  static constexpr RuleSet RULE_SET{RuleSet::CLASSIC};
+};
+
+struct HouseRules {
+  static constexpr bool EXIT_ON_ONE{true};
+  static constexpr bool THREE_SIXES_FORFEIT{true};
+  static constexpr bool SAFE_SQUARES{true};
+  static constexpr bool CAPTURE_BONUS{false};
+  static constexpr RuleSet RULE_SET{RuleSet::HOUSE};
+};
+
+/**
+ * @brief Compact, trivially copyable game state used by the simulators.
+ * Pieces are stored as BoardPosition ids, 4 per seat in seat order, so a
+ * 2 player game only carries 2 rows.
+ */
+template <int NUM_PLAYERS> struct BasicState {
+  std::array<std::array<std::uint8_t, 4>, NUM_PLAYERS> pieces;
+  std::uint8_t currentPlayer;     // seat, not color
+  std::uint8_t repetitionCounter; // rolls taken in the current turn
+  std::int8_t winner;             // seat, -1 while the game is running
+};
+
+namespace detail {
+// Piece::advance destination, -1 when Piece::canAdvance refuses the move
+int classicDestination(int color, int position, int diceValue);
+// steps from jail along the color's path, 0 when not on the path
+int pathProgress(int color, int position);
+bool isProtectedSquare(int position);
+} // namespace detail
+
+/**
+ * @brief The game's rules, which the GUI, the bots and the simulators all
+ * play. In the classic ones a piece leaves jail on a 6 and must land
+ * exactly on its final square. Landing on opponents off the safe squares
+ * sends them back to jail. A 6 or a capture rolls again, at most 3 rolls
+ * per turn. Variant changes some of that, see HouseRules. Destinations are
+ * precomputed into lookup tables, so a move costs a few loads instead of a
+ * walk along getNext.
+ *
+ * Player count and variant are template parameters: every loop over seats
+ * has a constant trip count and every variant check is an if constexpr.
+ */
+template <int NUM_PLAYERS_, class Variant = ClassicRules> class BasicRules {
+  static_assert(NUM_PLAYERS_ >= 2 && NUM_PLAYERS_ <= 4);
+
+public:
+  using State = BasicState<NUM_PLAYERS_>;
+  static constexpr int NUM_PLAYERS{NUM_PLAYERS_};
+  static constexpr int PIECES_PER_COLOR{4};
+  static constexpr int FINAL_PROGRESS{57}; // steps from jail to the center
+  static constexpr RuleSet RULE_SET{Variant::RULE_SET};
+
+  // two players sit at opposite corners, otherwise seats follow the colors
+  static constexpr int seatColor(int seat) {
+    return NUM_PLAYERS == 2 ? 2 * seat : seat;
+  }
+  static constexpr int jailPosition(int color, int slot) {
+    return 76 + 4 * color + slot;
+  }
+
+  static void reset(State &state) {
+    for (int seat = 0; seat < NUM_PLAYERS; seat++)
+      for (int i = 0; i < PIECES_PER_COLOR; i++)
+        state.pieces[seat][i] = jailPosition(seatColor(seat), i);
+    state.currentPlayer = 0;
+    state.repetitionCounter = 0;
+    state.winner = -1;
+  }
+
+  // BoardPosition reached with this dice value, -1 if the move is illegal
+  static int destination(int seat, int position, int diceValue) {
+    return tables().destination[seat][position][diceValue];
+  }
+
+  // 0 in jail, 1 on the start square, FINAL_PROGRESS once home
+  static int progress(int seat, int position) {
+    return tables().progress[seat][position];
+  }
+
+  // bit i is set when piece i of the current player can move
+  static unsigned legalMoves(const State &state, int diceValue) {
+    const Tables &t{tables()};
+    const int seat{state.currentPlayer};
+    unsigned mask{0};
+    for (int i = 0; i < PIECES_PER_COLOR; i++)
+      if (t.destination[seat][state.pieces[seat][i]][diceValue] >= 0)
+        mask |= 1u << i;
+    return mask;
+  }
+
+  // registers a roll, passes the turn when nothing can move, returns wether
+  // the current player now has to pick a piece
+  static bool roll(State &state, int diceValue) {
+    state.repetitionCounter++;
+    if constexpr (Variant::THREE_SIXES_FORFEIT) {
+      if (diceValue == 6 && state.repetitionCounter >= 3) {
+        passTurn(state);
+        return false;
+      }
+    }
+    if (legalMoves(state, diceValue) != 0)
+      return true;
+    if (diceValue != 6 || state.repetitionCounter >= 3)
+      passTurn(state);
+    return false;
+  }
+
+  // moves a piece, sends captured pieces to jail and passes the turn,
+  // returns wether something was captured
+  static bool play(State &state, int piece, int diceValue) {
+    const Tables &t{tables()};
+    const int seat{state.currentPlayer};
+    const int target{t.destination[seat][state.pieces[seat][piece]][diceValue]};
+    if (target < 0)
+      return false;
+    state.pieces[seat][piece] = target;
+
+    bool captured{false};
+    if (!t.isProtected[target]) {
+      for (int other = 0; other < NUM_PLAYERS; other++) {
+        if (other == seat)
+          continue;
+        for (int i = 0; i < PIECES_PER_COLOR; i++) {
+          if (state.pieces[other][i] != target)
+            continue;
+          sendToJail(state, other, i);
+          captured = true;
+        }
+      }
+    }
+
+    bool finished{true};
+    for (int i = 0; i < PIECES_PER_COLOR; i++)
+      finished &= t.progress[seat][state.pieces[seat][i]] == FINAL_PROGRESS;
+    if (finished) {
+      state.winner = seat;
+      return captured;
+    }
+
+    bool rollAgain{diceValue == 6 || (Variant::CAPTURE_BONUS && captured)};
+    if (!rollAgain || state.repetitionCounter >= 3)
+      passTurn(state);
+    return captured;
+  }
+
+  static bool isOver(const State &state) { return state.winner >= 0; }
+
+private:
+  struct Tables {
+    std::array<std::array<std::array<std::int8_t, 7>, NUM_POSITIONS>,
+               NUM_PLAYERS>
+        destination;
+    std::array<std::array<std::uint8_t, NUM_POSITIONS>, NUM_PLAYERS> progress;
+    std::array<bool, NUM_POSITIONS> isProtected;
+    Tables() : destination(), progress(), isProtected() {
+      for (int seat = 0; seat < NUM_PLAYERS; seat++) {
+        const int color{seatColor(seat)};
+        for (int position = 0; position < NUM_POSITIONS; position++) {
+          progress[seat][position] = detail::pathProgress(color, position);
+          for (int diceValue = 0; diceValue <= 6; diceValue++)
+            destination[seat][position][diceValue] =
+                diceValue == 0
+                    ? -1
+                    : detail::classicDestination(color, position, diceValue);
+          if constexpr (Variant::EXIT_ON_ONE) {
+            if (position >= jailPosition(color, 0) &&
+                position <= jailPosition(color, PIECES_PER_COLOR - 1))
+              destination[seat][position][1] = destination[seat][position][6];
+          }
+        }
+      }
+      for (int position = 0; position < NUM_POSITIONS; position++)
+        isProtected[position] =
+            Variant::SAFE_SQUARES && detail::isProtectedSquare(position);
+    }
+  };
+
+  static const Tables &tables() {
+    static const Tables t;
+    return t;
+  }
+
+  static void passTurn(State &state) {
+    state.repetitionCounter = 0;
+    state.currentPlayer = (state.currentPlayer + 1) % NUM_PLAYERS;
+  }
+
+  // a captured piece goes back to the first free slot of its jail
+  static void sendToJail(State &state, int seat, int piece) {
+    const int color{seatColor(seat)};
+    for (int slot = 0; slot < PIECES_PER_COLOR; slot++) {
+      const int jail{jailPosition(color, slot)};
+      bool taken{false};
+      for (int j = 0; j < PIECES_PER_COLOR; j++)
+        taken |= state.pieces[seat][j] == jail;
+      if (!taken) {
+        state.pieces[seat][piece] = jail;
+        return;
+      }
+    }
+  }
+};
+
+// the classic 4 player game, GameState has room for any player count
+using Rules = BasicRules<4, ClassicRules>;
+using GameState = Rules::State;
+
+// the first R::NUM_PLAYERS rows of a GameState
+template <class R> typename R::State toState(const GameState &from) {
+  typename R::State state;
+  for (int seat = 0; seat < R::NUM_PLAYERS; seat++)
+    state.pieces[seat] = from.pieces[seat];
+  state.currentPlayer = from.currentPlayer;
+  state.repetitionCounter = from.repetitionCounter;
+  state.winner = from.winner;
+  return state;
+}
+
+// back again, rows past R::NUM_PLAYERS are left alone
+template <class R>
+void toGameState(const typename R::State &from, GameState &to) {
+  for (int seat = 0; seat < R::NUM_PLAYERS; seat++)
+    to.pieces[seat] = from.pieces[seat];
+  to.currentPlayer = from.currentPlayer;
+  to.repetitionCounter = from.repetitionCounter;
+  to.winner = from.winner;
+}
+
+// calls f with the rules for this player count and rule set as a tag
+// argument, callers branch once here instead of on every move
+template <class F> auto withRules(int numPlayers, RuleSet rules, F &&f) {
+  if (rules == RuleSet::HOUSE) {
+    if (numPlayers == 2)
+      return f(BasicRules<2, HouseRules>{});
+    if (numPlayers == 3)
+      return f(BasicRules<3, HouseRules>{});
+    return f(BasicRules<4, HouseRules>{});
+  }
+  if (numPlayers == 2)
+    return f(BasicRules<2>{});
+  if (numPlayers == 3)
+    return f(BasicRules<3>{});
+  return f(Rules{});
+}
+
+} // namespace gamespace
+#endif
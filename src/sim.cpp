@@ -0,0 +1,231 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gamelog.h"
+#include "lockstep.h"
+#include "racetable.h"
+#include "results.h"
+#include "rules.h"
+
+using namespace gamespace;
+
+// games are cut short after this many steps, a real game needs a few hundred
+static const size_t MAX_STEPS{100000};
+
+static void printUsage(const char *program) {
+  std::cerr << "usage: " << program
+            << " [--games <n>] [--seed <n>] [--mode scalar|lockstep|verify]"
+               " [--policy furthest|random] [--players 2|3|4]"
+               " [--rules classic|house] [--table <race table>]"
+               " [--record <game log>] [--results <file>]\n";
+}
+
+static void printWinners(const std::vector<long> &wins, long games) {
+  for (size_t seat = 0; seat < wins.size(); seat++)
+    std::cout << "seat " << seat << " wins " << wins[seat] << " ("
+              << 100.0 * wins[seat] / std::max(1L, games) << "%)\n";
+}
+
+// the move that leaves the mover the shortest race home
+template <class R>
+static int racePiece(const RaceTable &table, const typename R::State &state,
+                     int dice) {
+  const int seat{state.currentPlayer};
+  const unsigned legal{R::legalMoves(state, dice)};
+  int choice{-1};
+  float best{0};
+  for (int i = 0; i < R::PIECES_PER_COLOR; i++) {
+    if (!(legal & (1u << i)))
+      continue;
+    std::array<std::uint8_t, 4> pieces{state.pieces[seat]};
+    pieces[i] = R::destination(seat, pieces[i], dice);
+    float turns{table.expectedTurns(R::seatColor(seat), pieces)};
+    if (choice < 0 || turns < best)
+      choice = i, best = turns;
+  }
+  return choice;
+}
+
+struct ScalarOptions {
+  LockstepSimulator::Policy policy;
+  const RaceTable *table; // seat 0 plays racePiece when set
+  GameLogWriter *log;     // every roll is recorded when set
+  ResultWriter *results;  // one row per game when set
+};
+
+static const char *policyName(LockstepSimulator::Policy policy) {
+  return policy == LockstepSimulator::RANDOM_LEGAL ? "random" : "furthest";
+}
+
+// one game at a time, returns the number of finished games
+template <class R>
+static long simulateScalar(size_t games, std::uint32_t seed,
+                           const ScalarOptions &options,
+                           std::vector<long> &wins) {
+  wins.assign(R::NUM_PLAYERS, 0);
+  long finished{0};
+  std::minstd_rand generator(seed);
+  GameResult result{};
+  result.numPlayers = R::NUM_PLAYERS;
+  result.policies.fill(GameResult::NO_POLICY);
+  if (options.results != nullptr)
+    for (int seat = 0; seat < R::NUM_PLAYERS; seat++)
+      result.policies[R::seatColor(seat)] = options.results->policy(
+          options.table != nullptr && seat == 0 ? "race"
+                                                : policyName(options.policy));
+  for (size_t g = 0; g < games; g++) {
+    typename R::State state;
+    R::reset(state);
+    if (options.log != nullptr)
+      options.log->startGame(R::NUM_PLAYERS, R::RULE_SET);
+    const auto begin{std::chrono::steady_clock::now()};
+    result.turns = 0;
+    result.captures.fill(0);
+    long moves{0};
+    for (size_t steps = 0; steps < MAX_STEPS && !R::isOver(state); steps++) {
+      std::uint32_t random = generator();
+      int dice = random % 6 + 1;
+      const int seat{state.currentPlayer};
+      if (!R::roll(state, dice)) {
+        if (options.log != nullptr)
+          options.log->roll(seat, dice, -1, 0, false);
+        result.turns += state.currentPlayer != seat;
+        continue;
+      }
+      const int piece{options.table != nullptr && seat == 0
+                          ? racePiece<R>(*options.table, state, dice)
+                          : LockstepSimulator::choosePiece<R>(
+                                state, dice, random, options.policy)};
+      const bool captured{R::play(state, piece, dice)};
+      if (options.log != nullptr)
+        options.log->roll(seat, dice, piece, state.pieces[seat][piece],
+                          captured);
+      result.turns += state.currentPlayer != seat || R::isOver(state);
+      result.captures[R::seatColor(seat)] += captured;
+      moves++;
+    }
+    if (options.log != nullptr)
+      options.log->endGame(state.winner);
+    if (options.results != nullptr) {
+      // the run's seed and the game's number, games share one generator
+      result.seed = static_cast<std::uint64_t>(seed) << 32 | g;
+      result.winner = R::isOver(state) ? R::seatColor(state.winner)
+                                       : GameResult::NO_WINNER;
+      result.moveNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::steady_clock::now() - begin)
+                             .count() /
+                         std::max(1L, moves);
+      options.results->add(result);
+    }
+    if (R::isOver(state))
+      wins[state.winner]++, finished++;
+  }
+  return finished;
+}
+
+template <class Variant>
+static long simulateScalar(int players, size_t games, std::uint32_t seed,
+                           const ScalarOptions &options,
+                           std::vector<long> &wins) {
+  if (players == 2)
+    return simulateScalar<BasicRules<2, Variant>>(games, seed, options, wins);
+  if (players == 3)
+    return simulateScalar<BasicRules<3, Variant>>(games, seed, options, wins);
+  return simulateScalar<BasicRules<4, Variant>>(games, seed, options, wins);
+}
+
+int main(int argc, char *argv[]) {
+  size_t games{100000};
+  std::uint32_t seed{1};
+  std::string mode{"lockstep"};
+  LockstepSimulator::Policy policy{LockstepSimulator::FURTHEST_PIECE};
+  int players{4};
+  std::string rules{"classic"};
+  std::string tablePath;
+  std::string logPath;
+  std::string resultsPath;
+  for (int i = 1; i < argc; i++) {
+    std::string arg{argv[i]};
+    if (arg == "--games" && i + 1 < argc)
+      games = std::strtoull(argv[++i], nullptr, 10);
+    else if (arg == "--seed" && i + 1 < argc)
+      seed = std::strtoul(argv[++i], nullptr, 10);
+    else if (arg == "--mode" && i + 1 < argc)
+      mode = argv[++i];
+    else if (arg == "--policy" && i + 1 < argc)
+      policy = std::string(argv[++i]) == "random"
+                   ? LockstepSimulator::RANDOM_LEGAL
+                   : LockstepSimulator::FURTHEST_PIECE;
+    else if (arg == "--players" && i + 1 < argc)
+      players = std::clamp(std::atoi(argv[++i]), 2, 4);
+    else if (arg == "--rules" && i + 1 < argc)
+      rules = argv[++i];
+    else if (arg == "--table" && i + 1 < argc)
+      tablePath = argv[++i];
+    else if (arg == "--record" && i + 1 < argc)
+      logPath = argv[++i];
+    else if (arg == "--results" && i + 1 < argc)
+      resultsPath = argv[++i];
+    else
+      return printUsage(argv[0]), 1;
+  }
+
+  RaceTable table;
+  if (!tablePath.empty() && !table.open(tablePath))
+    return 1;
+  if (mode != "scalar" &&
+      (players != 4 || rules != "classic" || table.isOpen() ||
+       !logPath.empty() || !resultsPath.empty())) {
+    std::cerr << "Only the scalar mode plays other player counts, rules"
+                 " and race tables, or records games and results\n";
+    return 1;
+  }
+  if (mode == "verify")
+    return LockstepSimulator::verify(games, policy, seed, std::cout) ? 0 : 1;
+
+  std::vector<long> wins(Rules::NUM_PLAYERS, 0);
+  long finished{0};
+  auto start{std::chrono::steady_clock::now()};
+  if (mode == "lockstep") {
+    LockstepSimulator simulator(games, policy, seed);
+    simulator.run(MAX_STEPS);
+    for (size_t g = 0; g < games; g++)
+      if (simulator.winner(g) >= 0)
+        wins[simulator.winner(g)]++, finished++;
+  } else if (mode == "scalar") {
+    std::unique_ptr<GameLogWriter> log;
+    if (!logPath.empty()) {
+      log = std::make_unique<GameLogWriter>(logPath);
+      if (!log->isOpen())
+        return 1;
+    }
+    std::unique_ptr<ResultWriter> results;
+    if (!resultsPath.empty()) {
+      results = std::make_unique<ResultWriter>(resultsPath);
+      if (!results->isOpen())
+        return 1;
+    }
+    const ScalarOptions options{policy, table.isOpen() ? &table : nullptr,
+                                log.get(), results.get()};
+    finished = rules == "house"
+                   ? simulateScalar<HouseRules>(players, games, seed, options,
+                                                wins)
+                   : simulateScalar<ClassicRules>(players, games, seed,
+                                                  options, wins);
+  } else {
+    return printUsage(argv[0]), 1;
+  }
+  double seconds{std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - start)
+                     .count()};
+  std::cout << finished << " games in " << seconds << "s, "
+            << finished / seconds << " games/s\n";
+  printWinners(wins, finished);
+  return 0;
+}
@@ -0,0 +1,71 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "lockstep.h"
+#include "solver.h"
+
+using namespace gamespace;
+
+static void printUsage(const char *program) {
+  std::cerr << "usage: " << program
+            << " [--pieces 1|2] [--threads <n>] [--tolerance <x>]"
+               " [--checkpoint <file>] [--grade]\n";
+}
+
+int main(int argc, char *argv[]) {
+  int pieces{1};
+  unsigned threads{std::max(1u, std::thread::hardware_concurrency())};
+  double tolerance{1e-6};
+  std::string checkpoint;
+  bool grade{false};
+  for (int i = 1; i < argc; i++) {
+    std::string arg{argv[i]};
+    if (arg == "--pieces" && i + 1 < argc)
+      pieces = std::clamp(std::atoi(argv[++i]), 1, ExactSolver::MAX_PIECES);
+    else if (arg == "--threads" && i + 1 < argc)
+      threads = std::max(1, std::atoi(argv[++i]));
+    else if (arg == "--tolerance" && i + 1 < argc)
+      tolerance = std::atof(argv[++i]);
+    else if (arg == "--checkpoint" && i + 1 < argc)
+      checkpoint = argv[++i];
+    else if (arg == "--grade")
+      grade = true;
+    else
+      return printUsage(argv[0]), 1;
+  }
+
+  using R = ExactSolver::R;
+  ExactSolver solver(pieces);
+  std::cout << solver.size() << " states\n";
+  if (!solver.solve(threads, tolerance, checkpoint, std::cout))
+    return 1;
+
+  // everybody in jail, the pieces nobody plays are already home
+  R::State start;
+  R::reset(start);
+  for (int seat = 0; seat < R::NUM_PLAYERS; seat++)
+    for (int i = pieces; i < R::PIECES_PER_COLOR; i++)
+      for (int position = 0; position < NUM_POSITIONS; position++)
+        if (R::progress(seat, position) == R::FINAL_PROGRESS)
+          start.pieces[seat][i] = position;
+  std::cout << "first player wins " << 100 * solver.winProbability(start)
+            << "% with best play\n";
+  if (!grade)
+    return 0;
+  // the simulator policies against the solution, a full pass over the table
+  for (auto policy :
+       {LockstepSimulator::FURTHEST_PIECE, LockstepSimulator::RANDOM_LEGAL})
+    std::cout << (policy == LockstepSimulator::FURTHEST_PIECE ? "furthest"
+                                                              : "random")
+              << " policy plays a best move in "
+              << 100 * solver.agreement([policy](const R::State &state,
+                                                 int dice) {
+                   return LockstepSimulator::choosePiece<R>(state, dice, 0,
+                                                            policy);
+                 })
+              << "% of the decisions\n";
+  return 0;
+}
@@ -0,0 +1,277 @@
+#include "solver.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+using namespace gamespace;
+
+static const char MAGIC[8]{'L', 'U', 'D', 'O', 'S', 'O', 'L', 'V'};
+static const std::uint32_t VERSION{1};
+static const int FINAL{ExactSolver::R::FINAL_PROGRESS};
+
+namespace {
+struct Header {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t piecesPerPlayer;
+  std::uint64_t numStates;
+  std::int64_t sweeps;
+};
+} // namespace
+
+ExactSolver::ExactSolver(int piecesPerPlayer)
+    : piecesPerPlayer(std::clamp(piecesPerPlayer, 1, MAX_PIECES)),
+      numSets(0), numStates(0), sweeps(0), values(), sets(), positions() {
+  // sets in rank order: rankSet is b * (b + 1) / 2 + a for a <= b
+  if (this->piecesPerPlayer == 1)
+    for (int p = 0; p <= FINAL; p++)
+      sets.push_back({p, FINAL});
+  else
+    for (int b = 0; b <= FINAL; b++)
+      for (int a = 0; a <= b; a++)
+        sets.push_back({a, b});
+  numSets = sets.size();
+  numStates = 2 * 3 * numSets * numSets; // mover, rolls taken, both sets
+  values = std::vector<std::atomic<float>>(numStates);
+
+  for (int seat = 0; seat < 2; seat++) {
+    positions[seat][0] = R::jailPosition(R::seatColor(seat), 0);
+    for (int position = 0; position < NUM_POSITIONS; position++)
+      if (R::progress(seat, position) > 0)
+        positions[seat][R::progress(seat, position)] = position;
+  }
+  for (std::size_t index = 0; index < numStates; index++)
+    values[index].store(0.5f, std::memory_order_relaxed);
+}
+
+std::size_t ExactSolver::rankSet(std::array<int, MAX_PIECES> progress) const {
+  if (piecesPerPlayer == 1)
+    return progress[0];
+  std::sort(progress.begin(), progress.end());
+  return progress[1] * (progress[1] + 1) / 2 + progress[0];
+}
+
+std::size_t ExactSolver::rank(const R::State &state) const {
+  if (state.repetitionCounter >= 3)
+    return NOT_COVERED;
+  std::size_t index{static_cast<std::size_t>(state.currentPlayer * 3 +
+                                             state.repetitionCounter)};
+  for (int seat = 0; seat < 2; seat++) {
+    std::array<int, MAX_PIECES> progress;
+    progress.fill(FINAL);
+    int out{0};
+    for (int i = 0; i < R::PIECES_PER_COLOR; i++) {
+      const int p{R::progress(seat, state.pieces[seat][i])};
+      if (p == FINAL)
+        continue;
+      if (out == piecesPerPlayer)
+        return NOT_COVERED;
+      progress[out++] = p;
+    }
+    index = index * numSets + rankSet(progress);
+  }
+  return index;
+}
+
+ExactSolver::R::State ExactSolver::unrank(std::size_t index) const {
+  R::State state;
+  const std::size_t set1{index % numSets};
+  index /= numSets;
+  const std::size_t set0{index % numSets};
+  index /= numSets;
+  state.currentPlayer = index / 3;
+  state.repetitionCounter = index % 3;
+  state.winner = -1;
+  const std::size_t setOf[2]{set0, set1};
+  for (int seat = 0; seat < 2; seat++) {
+    const int color{R::seatColor(seat)};
+    for (int i = 0; i < R::PIECES_PER_COLOR; i++) {
+      const int p{i < MAX_PIECES ? sets[setOf[seat]][i] : FINAL};
+      // every piece in jail gets its own slot, like after a capture
+      state.pieces[seat][i] =
+          p == 0 ? R::jailPosition(color, i) : positions[seat][p];
+    }
+  }
+  return state;
+}
+
+float ExactSolver::valueAfter(const R::State &state) const {
+  if (R::isOver(state))
+    return state.winner == 0 ? 1.0f : 0.0f;
+  return values[rank(state)].load(std::memory_order_relaxed);
+}
+
+// one Bellman backup: seat 0 takes the best move, seat 1 the worst for it
+float ExactSolver::update(std::size_t index) const {
+  const R::State state{unrank(index)};
+  const bool maximize{state.currentPlayer == 0};
+  float total{0};
+  for (int dice = 1; dice <= 6; dice++) {
+    R::State rolled{state};
+    if (!R::roll(rolled, dice)) {
+      total += valueAfter(rolled);
+      continue;
+    }
+    float best{maximize ? -1.0f : 2.0f};
+    for (unsigned legal = R::legalMoves(rolled, dice); legal != 0;
+         legal &= legal - 1) {
+      R::State moved{rolled};
+      R::play(moved, std::countr_zero(legal), dice);
+      const float value{valueAfter(moved)};
+      best = maximize ? std::max(best, value) : std::min(best, value);
+    }
+    total += best;
+  }
+  return total / 6;
+}
+
+bool ExactSolver::solve(unsigned numThreads, double tolerance,
+                        const std::string &checkpoint, std::ostream &log) {
+  if (!checkpoint.empty() && std::ifstream(checkpoint).good()) {
+    if (!load(checkpoint))
+      return false;
+    log << "resuming " << checkpoint << " after " << sweeps << " sweeps\n";
+  }
+  // states closest to the end first, so most backups see fresh values
+  std::vector<std::uint32_t> order(numStates);
+  std::vector<std::uint16_t> remaining(numStates);
+  for (std::size_t index = 0; index < numStates; index++) {
+    order[index] = index;
+    const std::size_t set1{index % numSets};
+    const std::size_t set0{(index / numSets) % numSets};
+    remaining[index] = 4 * FINAL - sets[set0][0] - sets[set0][1] -
+                       sets[set1][0] - sets[set1][1];
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [&](std::uint32_t a, std::uint32_t b) {
+                     return remaining[a] < remaining[b];
+                   });
+  remaining = {};
+
+  numThreads = std::max(1u, numThreads);
+  while (true) {
+    auto start{std::chrono::steady_clock::now()};
+    std::vector<float> deltas(numThreads, 0.0f);
+    std::vector<std::thread> workers;
+    // interleaved so all threads stay near the same distance from the end
+    for (unsigned t = 0; t < numThreads; t++)
+      workers.emplace_back([&, t] {
+        for (std::size_t i = t; i < numStates; i += numThreads) {
+          const std::size_t index{order[i]};
+          const float value{update(index)};
+          const float old{
+              values[index].exchange(value, std::memory_order_relaxed)};
+          deltas[t] = std::max(deltas[t], std::fabs(value - old));
+        }
+      });
+    for (std::thread &worker : workers)
+      worker.join();
+    sweeps++;
+    const float delta{*std::max_element(deltas.begin(), deltas.end())};
+    log << "sweep " << sweeps << " delta " << delta << " in "
+        << std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start)
+               .count()
+        << "s\n";
+    log.flush();
+    if (!checkpoint.empty() && !save(checkpoint))
+      return false;
+    if (delta < tolerance)
+      return true;
+  }
+}
+
+bool ExactSolver::save(const std::string &path) const {
+  // written next to the old checkpoint and renamed over it, a crash while
+  // writing keeps the previous one
+  const std::string temporary{path + ".tmp"};
+  {
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    Header h{};
+    std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+    h.version = VERSION;
+    h.piecesPerPlayer = piecesPerPlayer;
+    h.numStates = numStates;
+    h.sweeps = sweeps;
+    file.write(reinterpret_cast<const char *>(&h), sizeof(h));
+    std::vector<float> buffer(1 << 16);
+    for (std::size_t begin = 0; begin < numStates; begin += buffer.size()) {
+      const std::size_t n{std::min(buffer.size(), numStates - begin)};
+      for (std::size_t i = 0; i < n; i++)
+        buffer[i] = values[begin + i].load(std::memory_order_relaxed);
+      file.write(reinterpret_cast<const char *>(buffer.data()),
+                 n * sizeof(float));
+    }
+    if (!file) {
+      (std::cerr << "Could not write checkpoint [" << temporary << "]\n")
+          .flush();
+      return false;
+    }
+  }
+  if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+    (std::cerr << "Could not replace checkpoint [" << path << "]\n").flush();
+    return false;
+  }
+  return true;
+}
+
+bool ExactSolver::load(const std::string &path) {
+  std::ifstream file(path, std::ios::binary);
+  Header h{};
+  file.read(reinterpret_cast<char *>(&h), sizeof(h));
+  if (!file || std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+      h.version != VERSION ||
+      h.piecesPerPlayer != static_cast<std::uint32_t>(piecesPerPlayer) ||
+      h.numStates != numStates) {
+    (std::cerr << "Checkpoint [" << path
+               << "] does not match this solver, remove it to start over\n")
+        .flush();
+    return false;
+  }
+  std::vector<float> buffer(1 << 16);
+  for (std::size_t begin = 0; begin < numStates; begin += buffer.size()) {
+    const std::size_t n{std::min(buffer.size(), numStates - begin)};
+    file.read(reinterpret_cast<char *>(buffer.data()), n * sizeof(float));
+    for (std::size_t i = 0; i < n; i++)
+      values[begin + i].store(buffer[i], std::memory_order_relaxed);
+  }
+  if (!file) {
+    (std::cerr << "Checkpoint [" << path << "] is truncated\n").flush();
+    return false;
+  }
+  sweeps = h.sweeps;
+  return true;
+}
+
+float ExactSolver::winProbability(const R::State &state) const {
+  const std::size_t index{rank(state)};
+  if (index == NOT_COVERED)
+    return -1;
+  const float value{values[index].load(std::memory_order_relaxed)};
+  return state.currentPlayer == 0 ? value : 1 - value;
+}
+
+int ExactSolver::bestMove(const R::State &state, int diceValue) const {
+  R::State rolled{state};
+  if (rank(state) == NOT_COVERED || !R::roll(rolled, diceValue))
+    return -1;
+  int best{-1};
+  float bestValue{0};
+  for (unsigned legal = R::legalMoves(rolled, diceValue); legal != 0;
+       legal &= legal - 1) {
+    R::State moved{rolled};
+    R::play(moved, std::countr_zero(legal), diceValue);
+    float value{valueAfter(moved)};
+    if (state.currentPlayer == 1)
+      value = 1 - value;
+    if (best < 0 || value > bestValue)
+      best = std::countr_zero(legal), bestValue = value;
+  }
+  return best;
+}
@@ -0,0 +1,92 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include "rules.h"
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace gamespace {
+
+/**
+ * @brief Exact values of 2 player classic games where each player has at
+ * most piecesPerPlayer pieces left to bring home.
+ *
+ * A state is the player to move, the rolls already taken in the turn and
+ * the progress multiset of each player's pieces still on the way. States
+ * are ranked combinatorially into one dense array of seat 0 win
+ * probabilities. Captures make the game cyclic, so solve() runs Gauss-Seidel
+ * value iteration, states closest to the end first, split over threads.
+ * Checkpoints are plain dumps of that array, a solve picks up where the
+ * checkpoint left off.
+ */
+class ExactSolver {
+public:
+  using R = BasicRules<2, ClassicRules>;
+  static constexpr int MAX_PIECES{2};
+  static constexpr std::size_t NOT_COVERED{static_cast<std::size_t>(-1)};
+
+  // sweeps until no value moves by more than tolerance, log gets a line
+  // per sweep, checkpoint may be empty
+  bool solve(unsigned numThreads, double tolerance,
+             const std::string &checkpoint, std::ostream &log);
+  bool load(const std::string &path);
+  bool save(const std::string &path) const;
+
+  size_t size() const { return numStates; }
+  // NOT_COVERED when a player has more than piecesPerPlayer pieces out
+  std::size_t rank(const R::State &state) const;
+  // for the player to move, -1 when the state is not covered
+  float winProbability(const R::State &state) const;
+  // piece index in state, -1 when nothing can move or not covered
+  int bestMove(const R::State &state, int diceValue) const;
+  // share of the decisions with a choice where policy plays a best move
+  template <class Policy> double agreement(Policy &&policy) const;
+
+private:
+  int piecesPerPlayer;
+  std::size_t numSets; // progress multisets of one player
+  std::size_t numStates;
+  long sweeps;
+  std::vector<std::atomic<float>> values; // seat 0 wins, by rank
+  std::vector<std::array<int, MAX_PIECES>> sets;  // progress, by set rank
+  // BoardPosition of a progress value, by seat, jail slot 0 for 0
+  std::array<std::array<int, R::FINAL_PROGRESS + 1>, 2> positions;
+  std::size_t rankSet(std::array<int, MAX_PIECES> progress) const;
+  R::State unrank(std::size_t index) const;
+  float valueAfter(const R::State &state) const;
+  float update(std::size_t index) const;
+
+public:
+  explicit ExactSolver(int piecesPerPlayer);
+};
+
+template <class Policy> double ExactSolver::agreement(Policy &&policy) const {
+  long decisions{0}, agreed{0};
+  for (std::size_t index = 0; index < numStates; index++) {
+    const R::State state{unrank(index)};
+    for (int dice = 1; dice <= 6; dice++) {
+      R::State rolled{state};
+      if (!R::roll(rolled, dice) ||
+          std::popcount(R::legalMoves(rolled, dice)) < 2)
+        continue;
+      const int best{bestMove(state, dice)};
+      const int chosen{policy(rolled, dice)};
+      R::State a{rolled}, b{rolled};
+      R::play(a, best, dice);
+      R::play(b, chosen, dice);
+      decisions++;
+      agreed += valueAfter(a) == valueAfter(b);
+    }
+  }
+  return decisions == 0 ? 1.0 : agreed / static_cast<double>(decisions);
+}
+
+} // namespace gamespace
+#endif
@@ -0,0 +1,367 @@
+#include "spectate.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+using namespace gamespace;
+
+static const char GREETING[]{"ludospectate 1\n"};
+// frames handed to the kernel in one call
+static const size_t MAX_IOVECS{64};
+// spectators see a roll this much later at most
+static const std::chrono::microseconds BATCH_TIME{1000};
+
+SpectatorHub::SpectatorHub()
+    : mutex(), frames(POOL_FRAMES), freeFrames(), queue(), queueFirst(0),
+      queueCount(0), nextSeq(0), rollsSinceKeyframe(0), needKeyframe(true),
+      spectators(), keyframe(nullptr), sinceKeyframe(), numSinceKeyframe(0),
+      greeting(), numSpectators(0), skips(0), dropped(0), listenFd(-1),
+      wakeFd(-1), stopping(false), thread() {
+  freeFrames.reserve(POOL_FRAMES);
+  for (Frame &frame : frames)
+    freeFrames.push_back(&frame);
+  // the hub keeps a reference, the greeting never goes back to the pool
+  greeting.refs = 1;
+  greeting.size = sizeof(GREETING) - 1;
+  std::memcpy(greeting.bytes, GREETING, greeting.size);
+}
+
+SpectatorHub::~SpectatorHub() { stop(); }
+
+bool SpectatorHub::start(int port) {
+  listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  const int on{1};
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = htons(port);
+  if (listenFd < 0 ||
+      setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) != 0 ||
+      bind(listenFd, reinterpret_cast<const sockaddr *>(&address),
+           sizeof(address)) != 0 ||
+      listen(listenFd, SOMAXCONN) != 0 ||
+      (wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0) {
+    (std::cerr << "Could not listen for spectators on port " << port << " ["
+               << std::strerror(errno) << "]\n")
+        .flush();
+    stop();
+    return false;
+  }
+  thread = std::thread(&SpectatorHub::run, this);
+  return true;
+}
+
+void SpectatorHub::stop() {
+  stopping = true;
+  if (thread.joinable()) {
+    const std::uint64_t one{1};
+    [[maybe_unused]] ssize_t written{write(wakeFd, &one, sizeof(one))};
+    thread.join();
+  }
+  for (Spectator &spectator : spectators)
+    disconnect(spectator);
+  spectators.clear();
+  if (listenFd >= 0)
+    close(listenFd);
+  if (wakeFd >= 0)
+    close(wakeFd);
+  listenFd = wakeFd = -1;
+}
+
+SpectatorHub::Stats SpectatorHub::getStats() const {
+  return {numSpectators.load(), skips.load(), dropped.load()};
+}
+
+// ---------------------------------------------------------------------------
+// the game's thread
+
+SpectatorHub::Frame *SpectatorHub::takeFrame() {
+  std::lock_guard lock(mutex);
+  if (freeFrames.empty())
+    return nullptr;
+  Frame *frame{freeFrames.back()};
+  freeFrames.pop_back();
+  frame->refs = 1; // the queue's
+  frame->seq = nextSeq++;
+  return frame;
+}
+
+// a full queue drops the frame, rolls wait for the next position then.
+// Only the first frame in an empty queue wakes the I/O thread, it takes
+// everything queued by the time it runs.
+void SpectatorHub::publish(Frame *frame) {
+  {
+    std::lock_guard lock(mutex);
+    if (queueCount == QUEUE_FRAMES) {
+      freeFrames.push_back(frame);
+      dropped++;
+      needKeyframe = true;
+      return;
+    }
+    queue[(queueFirst + queueCount++) % QUEUE_FRAMES] = frame;
+    if (queueCount > 1)
+      return;
+  }
+  const std::uint64_t one{1};
+  // fails only with the counter full, the thread has plenty to wake up for
+  [[maybe_unused]] ssize_t written{write(wakeFd, &one, sizeof(one))};
+}
+
+void SpectatorHub::roll(const GameState &after, int numPlayers, int seat,
+                        int dice, int piece, int destination, bool captured) {
+  if (listenFd < 0)
+    return;
+  if (!needKeyframe) {
+    Frame *frame{takeFrame()};
+    if (frame == nullptr) {
+      dropped++;
+      needKeyframe = true;
+    } else {
+      frame->keyframe = false;
+      frame->color = numPlayers == 2 ? 2 * seat : seat;
+      frame->dice = dice;
+      frame->piece = piece;
+      frame->destination = destination;
+      frame->captured = captured;
+      publish(frame);
+    }
+  }
+  if (needKeyframe || ++rollsSinceKeyframe >= KEYFRAME_INTERVAL)
+    position(after, numPlayers);
+}
+
+void SpectatorHub::position(const GameState &state, int numPlayers) {
+  if (listenFd < 0)
+    return;
+  Frame *frame{takeFrame()};
+  if (frame == nullptr) {
+    dropped++;
+    needKeyframe = true;
+    return;
+  }
+  // by color like the engine protocol, 2 players sit at opposite corners
+  frame->pieces.fill(-1);
+  for (int seat = 0; seat < numPlayers; seat++)
+    for (int i = 0; i < 4; i++)
+      frame->pieces[4 * (numPlayers == 2 ? 2 * seat : seat) + i] =
+          state.pieces[seat][i];
+  frame->keyframe = true;
+  frame->players = numPlayers;
+  frame->color =
+      numPlayers == 2 ? 2 * state.currentPlayer : state.currentPlayer;
+  frame->rolls = state.repetitionCounter;
+  needKeyframe = false;
+  rollsSinceKeyframe = 0;
+  publish(frame);
+}
+
+// ---------------------------------------------------------------------------
+// the I/O thread
+
+void SpectatorHub::release(Frame *frame) {
+  if (--frame->refs > 0)
+    return;
+  std::lock_guard lock(mutex);
+  freeFrames.push_back(frame);
+}
+
+void SpectatorHub::encode(Frame &frame) {
+  int size;
+  if (frame.keyframe) {
+    size = std::snprintf(frame.bytes, sizeof(frame.bytes),
+                         "position %u players %d turn %d rolls %d pieces",
+                         frame.seq, frame.players, frame.color, frame.rolls);
+    for (int p : frame.pieces)
+      size += std::snprintf(frame.bytes + size, sizeof(frame.bytes) - size,
+                            " %d", p);
+    frame.bytes[size++] = '\n';
+  } else if (frame.piece >= 0) {
+    size = std::snprintf(frame.bytes, sizeof(frame.bytes),
+                         "roll %u color %d dice %d piece %d to %d%s\n",
+                         frame.seq, frame.color, frame.dice, frame.piece,
+                         frame.destination, frame.captured ? " captured" : "");
+  } else {
+    size = std::snprintf(frame.bytes, sizeof(frame.bytes),
+                         "roll %u color %d dice %d pass\n", frame.seq,
+                         frame.color, frame.dice);
+  }
+  frame.size = static_cast<std::uint16_t>(size);
+}
+
+void SpectatorHub::run() {
+  std::vector<pollfd> fds;
+  std::array<Frame *, QUEUE_FRAMES> published;
+  while (!stopping) {
+    fds.clear();
+    fds.push_back({wakeFd, POLLIN, 0});
+    fds.push_back({listenFd, POLLIN, 0});
+    for (const Spectator &spectator : spectators)
+      fds.push_back(
+          {spectator.fd, static_cast<short>(spectator.count ? POLLOUT : 0), 0});
+    if (poll(fds.data(), fds.size(), -1) < 0)
+      continue;
+    if (fds[0].revents & POLLIN) {
+      // lets a burst of rolls queue up, taken one by one they would each
+      // cost the game's thread a switch
+      std::this_thread::sleep_for(BATCH_TIME);
+      std::uint64_t wakeUps;
+      [[maybe_unused]] ssize_t wakeRead{
+          read(wakeFd, &wakeUps, sizeof(wakeUps))};
+      size_t n;
+      {
+        std::lock_guard lock(mutex);
+        n = queueCount;
+        for (size_t i = 0; i < n; i++)
+          published[i] = queue[(queueFirst + i) % QUEUE_FRAMES];
+        queueFirst = (queueFirst + n) % QUEUE_FRAMES;
+        queueCount = 0;
+      }
+      for (size_t i = 0; i < n; i++)
+        fanOut(published[i]);
+    }
+    // spectators accepted now have no pollfd, they are past the end
+    const size_t polled{spectators.size()};
+    if (fds[1].revents & POLLIN)
+      accept();
+    for (size_t i = 0; i < spectators.size(); i++) {
+      const short events{i < polled ? fds[i + 2].revents : short(0)};
+      if ((events & (POLLERR | POLLHUP | POLLNVAL)) || !flush(spectators[i]))
+        disconnect(spectators[i]);
+    }
+    std::erase_if(spectators,
+                  [](const Spectator &spectator) { return spectator.fd < 0; });
+  }
+}
+
+/**
+ * The latest position and the rolls since are kept for spectators that
+ * join or fall behind, then every spectator gets a reference.
+ */
+void SpectatorHub::fanOut(Frame *frame) {
+  encode(*frame);
+  if (frame->keyframe) {
+    if (keyframe != nullptr)
+      release(keyframe);
+    for (size_t i = 0; i < numSinceKeyframe; i++)
+      release(sinceKeyframe[i]);
+    numSinceKeyframe = 0;
+    keyframe = frame;
+    frame->refs++;
+  } else if (numSinceKeyframe < sinceKeyframe.size()) {
+    sinceKeyframe[numSinceKeyframe++] = frame;
+    frame->refs++;
+  }
+  for (Spectator &spectator : spectators)
+    if (spectator.count == MAX_PENDING)
+      skipAhead(spectator); // brings frame along
+    else
+      enqueue(spectator, frame);
+  release(frame);
+}
+
+void SpectatorHub::enqueue(Spectator &spectator, Frame *frame) {
+  spectator.pending[(spectator.first + spectator.count++) % MAX_PENDING] =
+      frame;
+  frame->refs++;
+}
+
+/**
+ * Everything queued goes, except a frame that is partly written: the
+ * spectator gets the rest of that line, then the latest position and the
+ * rolls since, whichever of them it has not started on yet.
+ */
+void SpectatorHub::skipAhead(Spectator &spectator) {
+  Frame *started{spectator.written > 0 ? spectator.pending[spectator.first]
+                                       : nullptr};
+  for (size_t i = started != nullptr ? 1 : 0; i < spectator.count; i++)
+    release(spectator.pending[(spectator.first + i) % MAX_PENDING]);
+  spectator.first = 0;
+  spectator.count = started != nullptr ? 1 : 0;
+  spectator.pending[0] = started;
+  std::array<Frame *, KEYFRAME_INTERVAL + 1> latest;
+  size_t n{0};
+  if (keyframe != nullptr)
+    latest[n++] = keyframe;
+  for (size_t i = 0; i < numSinceKeyframe; i++)
+    latest[n++] = sinceKeyframe[i];
+  size_t from{0};
+  for (size_t i = 0; i < n; i++)
+    if (latest[i] == started)
+      from = i + 1;
+  for (size_t i = from; i < n; i++)
+    enqueue(spectator, latest[i]);
+  skips++;
+}
+
+void SpectatorHub::accept() {
+  while (true) {
+    const int fd{
+        accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)};
+    if (fd < 0)
+      return;
+    spectators.push_back({fd, {}, 0, 0, 0});
+    Spectator &spectator{spectators.back()};
+    enqueue(spectator, &greeting);
+    if (keyframe != nullptr)
+      enqueue(spectator, keyframe);
+    for (size_t i = 0; i < numSinceKeyframe; i++)
+      enqueue(spectator, sinceKeyframe[i]);
+    numSpectators++;
+  }
+}
+
+// one vectored write straight from the shared frames, false when the
+// spectator is gone
+bool SpectatorHub::flush(Spectator &spectator) {
+  if (spectator.count == 0)
+    return true;
+  std::array<iovec, MAX_IOVECS> iov;
+  const size_t n{std::min(spectator.count, MAX_IOVECS)};
+  for (size_t i = 0; i < n; i++) {
+    Frame *frame{spectator.pending[(spectator.first + i) % MAX_PENDING]};
+    const size_t skip{i == 0 ? spectator.written : 0};
+    iov[i] = {frame->bytes + skip, frame->size - skip};
+  }
+  msghdr message{};
+  message.msg_iov = iov.data();
+  message.msg_iovlen = n;
+  ssize_t sent{sendmsg(spectator.fd, &message, MSG_NOSIGNAL | MSG_DONTWAIT)};
+  if (sent < 0)
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+  size_t left{static_cast<size_t>(sent)};
+  while (spectator.count > 0) {
+    Frame *frame{spectator.pending[spectator.first]};
+    const size_t rest{frame->size - spectator.written};
+    if (left < rest) {
+      spectator.written += left;
+      break;
+    }
+    left -= rest;
+    spectator.written = 0;
+    release(frame);
+    spectator.first = (spectator.first + 1) % MAX_PENDING;
+    spectator.count--;
+  }
+  return true;
+}
+
+void SpectatorHub::disconnect(Spectator &spectator) {
+  if (spectator.fd < 0)
+    return;
+  for (size_t i = 0; i < spectator.count; i++)
+    release(spectator.pending[(spectator.first + i) % MAX_PENDING]);
+  spectator.count = 0;
+  close(spectator.fd);
+  spectator.fd = -1;
+  numSpectators--;
+}
@@ -0,0 +1,124 @@
+#ifndef SPECTATE_H
+#define SPECTATE_H
+
+#include "rules.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gamespace {
+
+/**
+ * @brief Streams a table to any number of spectators over TCP.
+ *
+ * Every change goes into a frame from a fixed pool, is encoded once by
+ * the I/O thread and the same bytes go to every spectator with vectored
+ * writes straight from the frame. A frame goes back to the pool
+ * once the last spectator wrote it. The sockets belong to a thread of
+ * their own: publishing is a short lock and a wake up, it never waits for
+ * the network, and when the I/O thread falls behind frames are dropped
+ * until the next keyframe instead of piling up.
+ *
+ * Each spectator queues at most MAX_PENDING frames. One that cannot keep
+ * up is skipped to the latest keyframe and the rolls after it, so a
+ * spectator costs the same few pointers however slow it reads.
+ *
+ * Protocol, one line per frame:
+ *   hub -> spectator : ludospectate 1
+ *   hub -> spectator : position <seq> players <n> turn <color> rolls <r>
+ *                      pieces <16 positions by color, -1 unused>
+ *   hub -> spectator : roll <seq> color <c> dice <d> piece <i> to <position>
+ *                      [captured], or roll <seq> color <c> dice <d> pass
+ * Colors are the engine protocol's, 2 players sit at colors 0 and 2.
+ * A spectator starts at the latest position, seq counts every frame so a
+ * gap shows where it was skipped ahead.
+ */
+class SpectatorHub {
+public:
+  static constexpr size_t KEYFRAME_INTERVAL{32}; // rolls between positions
+  static constexpr size_t MAX_PENDING{64};       // frames queued per spectator
+  static constexpr size_t POOL_FRAMES{1024};
+  static constexpr size_t QUEUE_FRAMES{256}; // published, not fanned out yet
+
+  // listens on port on every interface and starts the I/O thread
+  bool start(int port);
+  // a roll and the position it led to, piece < 0 when the roll passed
+  void roll(const GameState &after, int numPlayers, int seat, int dice,
+            int piece, int destination, bool captured);
+  // the position changed without a roll: a new game, an undo
+  void position(const GameState &state, int numPlayers);
+
+  struct Stats {
+    long spectators; // connected now
+    long skips;      // times a slow spectator jumped to a keyframe
+    long dropped;    // frames the I/O thread had no room for
+  };
+  Stats getStats() const;
+
+private:
+  // filled in by the game's thread, encoded by the I/O thread
+  struct Frame {
+    int refs; // holders, only counted by the I/O thread once published
+    bool keyframe;
+    bool captured;
+    std::int8_t players, color, dice, piece, destination, rolls;
+    std::array<std::int8_t, 16> pieces; // by color
+    std::uint16_t size;                 // of bytes, 0 until encoded
+    std::uint32_t seq;
+    char bytes[128];
+  };
+  struct Spectator {
+    int fd;
+    std::array<Frame *, MAX_PENDING> pending; // a ring
+    size_t first, count;
+    size_t written; // bytes of the first pending frame already sent
+  };
+
+  // shared by both threads, under mutex
+  std::mutex mutex;
+  std::vector<Frame> frames;
+  std::vector<Frame *> freeFrames;
+  std::array<Frame *, QUEUE_FRAMES> queue;
+  size_t queueFirst, queueCount;
+  // the game's thread only
+  std::uint32_t nextSeq;
+  size_t rollsSinceKeyframe;
+  bool needKeyframe; // a frame was dropped, the next one is a position
+  // the I/O thread only
+  std::vector<Spectator> spectators;
+  Frame *keyframe;
+  std::array<Frame *, KEYFRAME_INTERVAL> sinceKeyframe;
+  size_t numSinceKeyframe;
+  Frame greeting;
+  std::atomic<long> numSpectators, skips, dropped;
+  int listenFd, wakeFd;
+  std::atomic<bool> stopping;
+  std::thread thread;
+
+  Frame *takeFrame();
+  void publish(Frame *frame);
+  void release(Frame *frame);
+  void run();
+  static void encode(Frame &frame);
+  void fanOut(Frame *frame);
+  void enqueue(Spectator &spectator, Frame *frame);
+  void skipAhead(Spectator &spectator);
+  void accept();
+  bool flush(Spectator &spectator);
+  void disconnect(Spectator &spectator);
+  void stop();
+
+public:
+  SpectatorHub();
+  ~SpectatorHub();
+  SpectatorHub(const SpectatorHub &) = delete;
+  SpectatorHub &operator=(const SpectatorHub &) = delete;
+};
+
+} // namespace gamespace
+#endif
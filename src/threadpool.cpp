@@ -0,0 +1,103 @@
+#include "threadpool.h"
+
+#include <algorithm>
+
+using namespace gamespace;
+
+// the pool and queue of the worker running on this thread, if any
+static thread_local const ThreadPool *currentPool{nullptr};
+static thread_local size_t currentWorker{0};
+
+// tasks per queue before it has to grow
+static const size_t QUEUE_SLOTS{64};
+
+void ThreadPool::Queue::pushBack(std::function<void()> &&task) {
+  if (count == slots.size()) {
+    std::vector<std::function<void()>> grown(
+        std::max(QUEUE_SLOTS, 2 * slots.size()));
+    for (size_t i = 0; i < count; i++)
+      grown[i] = std::move(slots[(first + i) % slots.size()]);
+    slots.swap(grown);
+    first = 0;
+  }
+  slots[(first + count++) % slots.size()] = std::move(task);
+}
+
+std::function<void()> ThreadPool::Queue::popFront() {
+  std::function<void()> &slot = slots[first];
+  std::function<void()> task{std::move(slot)};
+  slot = nullptr;
+  first = (first + 1) % slots.size();
+  count--;
+  return task;
+}
+
+ThreadPool::ThreadPool(unsigned numThreads)
+    : workers(), queues(), mutex(), wakeUp(), pending(0), nextQueue(0),
+      stopping(false) {
+  if (numThreads == 0)
+    numThreads = std::max(1u, std::thread::hardware_concurrency());
+  for (unsigned i = 0; i < numThreads; i++) {
+    queues.push_back(std::make_unique<Queue>());
+    queues.back()->slots.resize(QUEUE_SLOTS);
+  }
+  for (unsigned i = 0; i < numThreads; i++)
+    workers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lock(mutex);
+    stopping = true;
+  }
+  wakeUp.notify_all();
+  for (std::thread &worker : workers)
+    worker.join();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+  const size_t index{currentPool == this
+                         ? currentWorker
+                         : nextQueue.fetch_add(1) % queues.size()};
+  {
+    std::lock_guard lock(queues[index]->mutex);
+    queues[index]->pushBack(std::move(task));
+  }
+  {
+    std::lock_guard lock(mutex);
+    if (stopping)
+      return;
+    pending++;
+  }
+  wakeUp.notify_one();
+}
+
+// own queue first, then the other ones
+bool ThreadPool::takeTask(size_t worker, std::function<void()> &task) {
+  for (size_t i = 0; i < queues.size(); i++) {
+    Queue &queue = *queues[(worker + i) % queues.size()];
+    std::lock_guard lock(queue.mutex);
+    if (queue.count == 0)
+      continue;
+    task = queue.popFront();
+    pending--;
+    return true;
+  }
+  return false;
+}
+
+void ThreadPool::workerLoop(size_t worker) {
+  currentPool = this;
+  currentWorker = worker;
+  while (true) {
+    std::function<void()> task;
+    if (takeTask(worker, task)) {
+      task();
+      continue;
+    }
+    std::unique_lock lock(mutex);
+    wakeUp.wait(lock, [this] { return stopping || pending > 0; });
+    if (stopping)
+      return;
+  }
+}
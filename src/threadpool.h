@@ -0,0 +1,62 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gamespace {
+
+/**
+ * @brief Fixed set of worker threads with one task queue each.
+ *
+ * Tasks submitted from a worker go to that worker's own queue, tasks from
+ * other threads are dealt round robin. Queues run oldest first, a task
+ * that resubmits itself would otherwise bury everything queued before it,
+ * cancelled work included. A worker with an empty queue steals the oldest
+ * task of another one, so a few long tasks never leave the other cores
+ * idle.
+ * Tasks still queued when the pool is destroyed are dropped, long running
+ * tasks are expected to watch their own cancellation flag.
+ * Queues only grow, so submitting a task that fits in std::function
+ * without allocating (a lambda holding a pointer or two) allocates nothing.
+ */
+class ThreadPool {
+public:
+  void submit(std::function<void()> task);
+  size_t size() const { return workers.size(); }
+
+private:
+  // ring of tasks, a deque would allocate and free blocks as tasks come
+  // and go
+  struct Queue {
+    std::mutex mutex;
+    std::vector<std::function<void()>> slots;
+    size_t first{0};
+    size_t count{0};
+    void pushBack(std::function<void()> &&task);
+    std::function<void()> popFront();
+  };
+  std::vector<std::thread> workers;
+  std::vector<std::unique_ptr<Queue>> queues; // by worker
+  std::mutex mutex;                           // only for sleeping
+  std::condition_variable wakeUp;
+  std::atomic<long> pending;
+  std::atomic<size_t> nextQueue;
+  bool stopping;
+  bool takeTask(size_t worker, std::function<void()> &task);
+  void workerLoop(size_t worker);
+
+public:
+  explicit ThreadPool(unsigned numThreads = 0); // 0: one per core
+  ~ThreadPool();
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+};
+
+} // namespace gamespace
+#endif
@@ -0,0 +1,362 @@
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "lockstep.h"
+#include "network.h"
+#include "racetable.h"
+#include "results.h"
+#include "rules.h"
+#include "threadpool.h"
+
+using namespace gamespace;
+using R = BasicRules<2>;
+
+// games are cut short after this many rolls and count as a draw
+static const int MAX_STEPS{100000};
+
+static void printUsage(const char *program) {
+  std::cerr << "usage: " << program
+            << " --bot <furthest|random|race:<table>|rollouts:<n>|"
+               "net:<network>>..."
+               " [--gauntlet] [--games <max per pairing>]"
+               " [--min-games <n>] [--z <threshold>] [--threads <n>]"
+               " [--seed <n>] [--results <file>]\n";
+}
+
+/**
+ * One contestant, choose() gets a state that rolled and has a legal move.
+ */
+struct Bot {
+  std::string name;
+  std::function<int(const R::State &, int, std::minstd_rand &)> choose;
+  std::uint8_t policy; // id in the result file
+};
+
+static int randomPiece(const R::State &state, int dice,
+                       std::minstd_rand &generator) {
+  return LockstepSimulator::choosePiece<R>(state, dice, generator(),
+                                           LockstepSimulator::RANDOM_LEGAL);
+}
+
+// plays the game out with random moves, returns the winner or -1
+static int rollout(R::State state, std::minstd_rand &generator) {
+  for (int steps = 0; steps < MAX_STEPS && !R::isOver(state); steps++) {
+    int dice = generator() % 6 + 1;
+    if (R::roll(state, dice))
+      R::play(state, randomPiece(state, dice, generator), dice);
+  }
+  return state.winner;
+}
+
+static bool makeBot(const std::string &spec,
+                    std::vector<std::unique_ptr<RaceTable>> &tables,
+                    std::vector<std::unique_ptr<ValueNetwork>> &networks,
+                    Bot &bot) {
+  bot.name = spec;
+  if (spec == "furthest") {
+    bot.choose = [](const R::State &state, int dice, std::minstd_rand &) {
+      return LockstepSimulator::choosePiece<R>(
+          state, dice, 0, LockstepSimulator::FURTHEST_PIECE);
+    };
+  } else if (spec == "random") {
+    bot.choose = randomPiece;
+  } else if (spec.starts_with("race:")) {
+    tables.push_back(std::make_unique<RaceTable>());
+    if (!tables.back()->open(spec.substr(5)))
+      return false;
+    const RaceTable *table{tables.back().get()};
+    bot.choose = [table](const R::State &state, int dice,
+                         std::minstd_rand &) {
+      const int seat{state.currentPlayer};
+      int choice{-1};
+      float best{0};
+      for (unsigned legal = R::legalMoves(state, dice); legal != 0;
+           legal &= legal - 1) {
+        const int i{std::countr_zero(legal)};
+        std::array<std::uint8_t, 4> pieces{state.pieces[seat]};
+        pieces[i] = R::destination(seat, pieces[i], dice);
+        float turns{table->expectedTurns(R::seatColor(seat), pieces)};
+        if (choice < 0 || turns < best)
+          choice = i, best = turns;
+      }
+      return choice;
+    };
+  } else if (spec.starts_with("net:")) {
+    networks.push_back(std::make_unique<ValueNetwork>());
+    if (!networks.back()->load(spec.substr(4)))
+      return false;
+    const ValueNetwork *network{networks.back().get()};
+    bot.choose = [network](const R::State &state, int dice,
+                           std::minstd_rand &) {
+      return network->chooseMove<R>(state, dice);
+    };
+  } else if (spec.starts_with("rollouts:")) {
+    const int rollouts{std::max(1, std::atoi(spec.c_str() + 9))};
+    bot.choose = [rollouts](const R::State &state, int dice,
+                            std::minstd_rand &generator) {
+      int choice{-1}, best{-1};
+      for (unsigned legal = R::legalMoves(state, dice); legal != 0;
+           legal &= legal - 1) {
+        const int i{std::countr_zero(legal)};
+        R::State after{state};
+        R::play(after, i, dice);
+        int wins{0};
+        for (int n = 0; n < rollouts; n++)
+          wins += rollout(after, generator) == state.currentPlayer;
+        if (wins > best)
+          choice = i, best = wins;
+      }
+      return choice;
+    };
+  } else {
+    std::cerr << "Unknown bot [" << spec << "]\n";
+    return false;
+  }
+  return true;
+}
+
+// returns the winning seat, -1 for a game that did not finish, and fills
+// result when given one
+static int playGame(const Bot &first, const Bot &second, std::uint32_t seed,
+                    std::minstd_rand &botGenerator, GameResult *result) {
+  std::minstd_rand dice(seed); // both games of a pair see the same rolls
+  R::State state;
+  R::reset(state);
+  GameResult r{seed, R::NUM_PLAYERS, {}, GameResult::NO_WINNER, 0, {}, 0};
+  r.policies.fill(GameResult::NO_POLICY);
+  r.policies[R::seatColor(0)] = first.policy;
+  r.policies[R::seatColor(1)] = second.policy;
+  std::chrono::steady_clock::duration thinking{0};
+  long moves{0};
+  for (int steps = 0; steps < MAX_STEPS && !R::isOver(state); steps++) {
+    const int value = dice() % 6 + 1;
+    const int seat{state.currentPlayer};
+    if (R::roll(state, value)) {
+      const Bot &bot{seat == 0 ? first : second};
+      const auto begin{std::chrono::steady_clock::now()};
+      const int piece{bot.choose(state, value, botGenerator)};
+      thinking += std::chrono::steady_clock::now() - begin;
+      r.captures[R::seatColor(seat)] += R::play(state, piece, value);
+      moves++;
+    }
+    r.turns += state.currentPlayer != seat || R::isOver(state);
+  }
+  if (result != nullptr) {
+    if (R::isOver(state))
+      r.winner = R::seatColor(state.winner);
+    // the bots' time only, rolling and moving is the same for all of them
+    r.moveNanos =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(thinking)
+            .count() /
+        std::max(1L, moves);
+    *result = r;
+  }
+  return state.winner;
+}
+
+/**
+ * Games between two bots, played in pairs with swapped seats. A pairing
+ * stops early once its score is that many standard errors away from 50%.
+ */
+struct Pairing {
+  int a, b;
+  long games{0};
+  double scoreA{0};
+  bool stopped{false};
+};
+
+// Bradley-Terry ratings by minorization-maximization, in Elo points with
+// the 95% interval from the Fisher information
+static void printRatings(const std::vector<Bot> &bots,
+                         const std::vector<Pairing> &pairings) {
+  const size_t n{bots.size()};
+  std::vector<double> gamma(n, 1.0), wins(n, 0.0);
+  std::vector<std::vector<double>> games(n, std::vector<double>(n, 0.0));
+  for (const Pairing &p : pairings) {
+    games[p.a][p.b] += p.games;
+    games[p.b][p.a] += p.games;
+    wins[p.a] += p.scoreA;
+    wins[p.b] += p.games - p.scoreA;
+  }
+  for (int iteration = 0; iteration < 1000; iteration++) {
+    for (size_t i = 0; i < n; i++) {
+      double denominator{0};
+      for (size_t j = 0; j < n; j++)
+        if (j != i)
+          denominator += games[i][j] / (gamma[i] + gamma[j]);
+      // half a win keeps unbeaten and winless bots finite
+      if (denominator > 0)
+        gamma[i] = (wins[i] + 0.5) / denominator;
+    }
+    double mean{0};
+    for (double g : gamma)
+      mean += std::log(g) / n;
+    for (double &g : gamma)
+      g /= std::exp(mean);
+  }
+  const double scale{400 / std::log(10.0)};
+  std::vector<size_t> order(n);
+  for (size_t i = 0; i < n; i++)
+    order[i] = i;
+  std::sort(order.begin(), order.end(),
+            [&](size_t x, size_t y) { return gamma[x] > gamma[y]; });
+  std::cout << "rank  elo     +/-   games  bot\n";
+  for (size_t rank = 0; rank < n; rank++) {
+    const size_t i{order[rank]};
+    double information{0};
+    long total{0};
+    for (size_t j = 0; j < n; j++) {
+      if (j == i)
+        continue;
+      const double p{gamma[i] / (gamma[i] + gamma[j])};
+      information += games[i][j] * p * (1 - p);
+      total += games[i][j];
+    }
+    const double interval{information > 0
+                              ? 1.96 * scale / std::sqrt(information)
+                              : INFINITY};
+    std::cout << std::setw(4) << rank + 1 << std::setw(6)
+              << std::lround(scale * std::log(gamma[i])) << std::setw(8)
+              << std::lround(std::min(interval, 9999.0)) << std::setw(8)
+              << total << "  " << bots[i].name << "\n";
+  }
+  std::cout.flush();
+}
+
+int main(int argc, char *argv[]) {
+  std::vector<std::string> specs;
+  bool gauntlet{false};
+  long maxGames{2000};
+  long minGames{100};
+  double threshold{3.0};
+  unsigned threads{0};
+  std::uint32_t seed{1};
+  std::string resultsPath;
+  for (int i = 1; i < argc; i++) {
+    std::string arg{argv[i]};
+    if (arg == "--bot" && i + 1 < argc)
+      specs.push_back(argv[++i]);
+    else if (arg == "--gauntlet")
+      gauntlet = true;
+    else if (arg == "--games" && i + 1 < argc)
+      maxGames = std::max(2L, std::atol(argv[++i]) / 2 * 2); // pairs
+    else if (arg == "--min-games" && i + 1 < argc)
+      minGames = std::max(2L, std::atol(argv[++i]));
+    else if (arg == "--z" && i + 1 < argc)
+      threshold = std::atof(argv[++i]);
+    else if (arg == "--threads" && i + 1 < argc)
+      threads = std::max(1, std::atoi(argv[++i]));
+    else if (arg == "--seed" && i + 1 < argc)
+      seed = std::strtoul(argv[++i], nullptr, 10);
+    else if (arg == "--results" && i + 1 < argc)
+      resultsPath = argv[++i];
+    else
+      return printUsage(argv[0]), 1;
+  }
+  if (specs.size() < 2)
+    return printUsage(argv[0]), 1;
+
+  std::vector<std::unique_ptr<RaceTable>> tables;
+  std::vector<std::unique_ptr<ValueNetwork>> networks;
+  std::vector<Bot> bots(specs.size());
+  for (size_t i = 0; i < specs.size(); i++)
+    if (!makeBot(specs[i], tables, networks, bots[i]))
+      return 1;
+  // every game of every thread goes to one file, ResultWriter is thread safe
+  std::unique_ptr<ResultWriter> results;
+  if (!resultsPath.empty()) {
+    results = std::make_unique<ResultWriter>(resultsPath);
+    if (!results->isOpen())
+      return 1;
+    for (Bot &bot : bots)
+      bot.policy = results->policy(bot.name);
+  }
+
+  // round robin, or the first bot against everybody else
+  std::vector<Pairing> pairings;
+  for (size_t a = 0; a < bots.size(); a++)
+    for (size_t b = a + 1; b < bots.size() && (!gauntlet || a == 0); b++)
+      pairings.push_back({static_cast<int>(a), static_cast<int>(b)});
+
+  std::mutex mutex;
+  std::condition_variable done;
+  long outstanding{0};
+  ThreadPool pool(threads);
+  std::cout << pairings.size() << " pairings on " << pool.size()
+            << " threads\n";
+  // every pair of games is its own task, so a slow pairing never holds up
+  // the others, tasks of a stopped pairing return right away
+  for (size_t index = 0; index < pairings.size(); index++) {
+    for (long pair = 0; pair < maxGames / 2; pair++) {
+      const std::uint32_t gameSeed{
+          seed + static_cast<std::uint32_t>(index * maxGames + pair)};
+      {
+        std::lock_guard lock(mutex);
+        outstanding++;
+      }
+      pool.submit([&, index, gameSeed] {
+        Pairing &p = pairings[index];
+        bool skip;
+        {
+          std::lock_guard lock(mutex);
+          skip = p.stopped;
+        }
+        double score{0};
+        GameResult firstResult, secondResult;
+        const bool keep{results != nullptr};
+        if (!skip) {
+          std::minstd_rand generator(gameSeed ^ 0x9e3779b9u);
+          int first{playGame(bots[p.a], bots[p.b], gameSeed, generator,
+                             keep ? &firstResult : nullptr)};
+          int second{playGame(bots[p.b], bots[p.a], gameSeed, generator,
+                              keep ? &secondResult : nullptr)};
+          score = (first == 0) + (first < 0) * 0.5 + (second == 1) +
+                  (second < 0) * 0.5;
+        }
+        std::unique_lock lock(mutex);
+        const bool counted{!skip && !p.stopped};
+        if (counted) {
+          p.games += 2;
+          p.scoreA += score;
+          const double s{std::clamp(p.scoreA / p.games, 0.01, 0.99)};
+          const double z{(s - 0.5) / std::sqrt(s * (1 - s) / p.games)};
+          if ((p.games >= minGames && std::fabs(z) >= threshold) ||
+              p.games >= maxGames) {
+            p.stopped = true;
+            std::cout << bots[p.a].name << " vs " << bots[p.b].name << ": "
+                      << p.scoreA << "/" << p.games << " ("
+                      << std::round(1000 * p.scoreA / p.games) / 10
+                      << "%)" << (p.games < maxGames ? " decided" : "")
+                      << "\n";
+            printRatings(bots, pairings);
+          }
+        }
+        // only games that count, so the file agrees with the ratings. A
+        // full block is encoded by whoever adds to it, outside the lock.
+        if (counted && keep) {
+          lock.unlock();
+          results->add(firstResult);
+          results->add(secondResult);
+          lock.lock();
+        }
+        if (--outstanding == 0)
+          done.notify_all();
+      });
+    }
+  }
+  std::unique_lock lock(mutex);
+  done.wait(lock, [&] { return outstanding == 0; });
+  return 0;
+}
@@ -0,0 +1,284 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "lockstep.h"
+#include "network.h"
+#include "rules.h"
+
+using namespace gamespace;
+using Net = ValueNetwork;
+
+// games are cut short after this many rolls and not learned from
+static const int MAX_STEPS{100000};
+
+static void printUsage(const char *program) {
+  std::cerr << "usage: " << program
+            << " --out <network> [--init <network>] [--players 2|3|4]"
+               " [--games <n>] [--rate <r>] [--explore <p>] [--seed <n>]\n"
+               "       "
+            << program << " --bench <network>|random\n";
+}
+
+/**
+ * One step of gradient descent on the cross entropy of the winner, target
+ * is its seat counted from the player to move. Scalar and slow next to
+ * evaluate(), the game playing is what costs. Returns the loss.
+ */
+static float learn(Net::Weights &w, const Net::Input &input, int target,
+                   float rate) {
+  std::array<int, Net::MAX_ACTIVE> features;
+  const int active{Net::activeFeatures(input, features)};
+  float hidden[Net::HIDDEN];
+  for (int j = 0; j < Net::HIDDEN; j++) {
+    float sum{w.hiddenBias[j]};
+    for (int f = 0; f < active; f++)
+      sum += w.input[features[f]][j];
+    hidden[j] = std::max(sum, 0.0f);
+  }
+  const int seats{input.numPlayers};
+  float p[Net::SEATS], top{-INFINITY}, total{0};
+  for (int s = 0; s < seats; s++) {
+    p[s] = w.outputBias[s];
+    for (int j = 0; j < Net::HIDDEN; j++)
+      p[s] += hidden[j] * w.output[s][j];
+    top = std::max(top, p[s]);
+  }
+  for (int s = 0; s < seats; s++)
+    total += p[s] = std::exp(p[s] - top);
+  float delta[Net::SEATS];
+  for (int s = 0; s < seats; s++)
+    delta[s] = p[s] / total - (s == target);
+  for (int j = 0; j < Net::HIDDEN; j++) {
+    float back{0};
+    for (int s = 0; s < seats; s++) {
+      back += delta[s] * w.output[s][j];
+      w.output[s][j] -= rate * delta[s] * hidden[j];
+    }
+    if (hidden[j] <= 0)
+      continue;
+    w.hiddenBias[j] -= rate * back;
+    for (int f = 0; f < active; f++)
+      w.input[features[f]][j] -= rate * back;
+  }
+  for (int s = 0; s < seats; s++)
+    w.outputBias[s] -= rate * delta[s];
+  return -std::log(std::max(p[target] / total, 1e-9f));
+}
+
+struct Position {
+  Net::Input input;
+  int mover; // seat of the player to move
+};
+
+/**
+ * Self play: every seat picks with the network, or a random legal piece
+ * with probability explore, and every position after a move learns who
+ * won in the end. Returns the winner, -1 for a game cut short.
+ */
+template <class R>
+static int playGame(const Net &network, std::minstd_rand &generator,
+                    double explore, std::vector<Position> &positions) {
+  std::uniform_real_distribution<double> uniform(0, 1);
+  typename R::State state;
+  R::reset(state);
+  positions.clear();
+  for (int steps = 0; steps < MAX_STEPS && !R::isOver(state); steps++) {
+    const int dice = generator() % 6 + 1;
+    if (!R::roll(state, dice))
+      continue;
+    const int piece{uniform(generator) < explore
+                        ? LockstepSimulator::choosePiece<R>(
+                              state, dice, generator(),
+                              LockstepSimulator::RANDOM_LEGAL)
+                        : network.chooseMove<R>(state, dice)};
+    R::play(state, piece, dice);
+    if (!R::isOver(state))
+      positions.push_back({Net::encode<R>(state), state.currentPlayer});
+  }
+  return state.winner;
+}
+
+template <class R>
+static void train(Net &network, long games, float rate, double explore,
+                  std::uint32_t seed) {
+  std::minstd_rand generator(seed);
+  std::vector<Position> positions;
+  positions.reserve(4096);
+  double loss{0};
+  long learned{0};
+  const long report{std::max(1L, games / 10)};
+  for (long g = 1; g <= games; g++) {
+    const int winner{playGame<R>(network, generator, explore, positions)};
+    // later positions first, they know the most about the outcome
+    for (auto p = positions.rbegin(); winner >= 0 && p != positions.rend();
+         p++) {
+      const int target{(winner - p->mover + R::NUM_PLAYERS) %
+                       R::NUM_PLAYERS};
+      loss += learn(network.weights(), p->input, target, rate);
+      learned++;
+    }
+    if (g % report == 0) {
+      std::cout << g << " games, loss " << loss / std::max(1L, learned)
+                << "\n";
+      std::cout.flush();
+      loss = 0;
+      learned = 0;
+    }
+  }
+}
+
+// share of the games seat 0 wins picking with the network, everybody else
+// and the baseline seat 0 playing furthest piece, on the same dice
+template <class R>
+static void evaluateAgainstFurthest(const Net &network, long games,
+                                    std::uint32_t seed) {
+  long wins[2]{};
+  for (int withNetwork = 0; withNetwork < 2; withNetwork++)
+    for (long g = 0; g < games; g++) {
+      std::minstd_rand dice(seed + g);
+      typename R::State state;
+      R::reset(state);
+      for (int steps = 0; steps < MAX_STEPS && !R::isOver(state); steps++) {
+        const int value = dice() % 6 + 1;
+        if (!R::roll(state, value))
+          continue;
+        R::play(state,
+                withNetwork && state.currentPlayer == 0
+                    ? network.chooseMove<R>(state, value)
+                    : LockstepSimulator::choosePiece<R>(
+                          state, value, 0, LockstepSimulator::FURTHEST_PIECE),
+                value);
+      }
+      wins[withNetwork] += state.winner == 0;
+    }
+  std::cout << "seat 0 against furthest in " << games << " games: network "
+            << 100.0 * wins[1] / games << "%, furthest "
+            << 100.0 * wins[0] / games << "%\n";
+}
+
+/**
+ * States per second for a few batch sizes over positions from random 4
+ * player games, and whether every batch size gives the same bits.
+ */
+static void bench(const Net &network) {
+  using R = BasicRules<4>;
+  std::vector<Net::Input> inputs;
+  std::minstd_rand generator(1);
+  while (inputs.size() < 4096) {
+    R::State state;
+    R::reset(state);
+    for (int steps = 0; steps < MAX_STEPS && !R::isOver(state); steps++) {
+      const int dice = generator() % 6 + 1;
+      if (!R::roll(state, dice))
+        continue;
+      R::play(state,
+              LockstepSimulator::choosePiece<R>(
+                  state, dice, generator(), LockstepSimulator::RANDOM_LEGAL),
+              dice);
+      inputs.push_back(Net::encode<R>(state));
+    }
+  }
+  inputs.resize(4096);
+#if defined(__x86_64__) || defined(__i386__)
+  std::cout << "avx2: " << (__builtin_cpu_supports("avx2") ? "yes" : "no")
+            << "\n";
+#endif
+  std::vector<Net::Output> reference(inputs.size()), outputs(inputs.size());
+  network.evaluate(inputs, reference);
+  for (size_t batch : {1, 4, 64, 1024}) {
+    auto begin{std::chrono::steady_clock::now()};
+    double seconds{0};
+    long states{0};
+    bool same{true};
+    while (seconds < 0.5) {
+      for (size_t first = 0; first < inputs.size(); first += batch)
+        network.evaluate(std::span(inputs).subspan(first, batch),
+                         std::span(outputs).subspan(first, batch));
+      states += inputs.size();
+      same &= std::memcmp(outputs.data(), reference.data(),
+                          outputs.size() * sizeof(Net::Output)) == 0;
+      seconds = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - begin)
+                    .count();
+    }
+    std::cout << "batch " << batch << ": " << states / seconds
+              << " states/s" << (same ? "" : ", results differ") << "\n";
+  }
+}
+
+int main(int argc, char *argv[]) {
+  std::string outPath, initPath, benchPath;
+  int players{4};
+  long games{20000};
+  float rate{0.01f};
+  double explore{0.1};
+  std::uint32_t seed{1};
+  for (int i = 1; i < argc; i++) {
+    std::string arg{argv[i]};
+    if (arg == "--out" && i + 1 < argc)
+      outPath = argv[++i];
+    else if (arg == "--init" && i + 1 < argc)
+      initPath = argv[++i];
+    else if (arg == "--bench" && i + 1 < argc)
+      benchPath = argv[++i];
+    else if (arg == "--players" && i + 1 < argc)
+      players = std::clamp(std::atoi(argv[++i]), 2, 4);
+    else if (arg == "--games" && i + 1 < argc)
+      games = std::max(1L, std::atol(argv[++i]));
+    else if (arg == "--rate" && i + 1 < argc)
+      rate = std::atof(argv[++i]);
+    else if (arg == "--explore" && i + 1 < argc)
+      explore = std::clamp(std::atof(argv[++i]), 0.0, 1.0);
+    else if (arg == "--seed" && i + 1 < argc)
+      seed = std::strtoul(argv[++i], nullptr, 10);
+    else
+      return printUsage(argv[0]), 1;
+  }
+
+  Net network;
+  if (!benchPath.empty()) {
+    if (benchPath == "random")
+      network.initialize(seed);
+    else if (!network.load(benchPath))
+      return 1;
+    bench(network);
+    return 0;
+  }
+  if (outPath.empty())
+    return printUsage(argv[0]), 1;
+  if (initPath.empty())
+    network.initialize(seed);
+  else if (!network.load(initPath))
+    return 1;
+
+  auto begin{std::chrono::steady_clock::now()};
+  if (players == 2)
+    train<BasicRules<2>>(network, games, rate, explore, seed);
+  else if (players == 3)
+    train<BasicRules<3>>(network, games, rate, explore, seed);
+  else
+    train<BasicRules<4>>(network, games, rate, explore, seed);
+  std::cout << games << " games in "
+            << std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                             begin)
+                   .count()
+            << "s\n";
+  if (!network.save(outPath))
+    return 1;
+  const long evaluation{std::min(games, 2000L)};
+  if (players == 2)
+    evaluateAgainstFurthest<BasicRules<2>>(network, evaluation, seed + 1);
+  else if (players == 3)
+    evaluateAgainstFurthest<BasicRules<3>>(network, evaluation, seed + 1);
+  else
+    evaluateAgainstFurthest<BasicRules<4>>(network, evaluation, seed + 1);
+  return 0;
+}
@@ -0,0 +1,62 @@
+#include "turnflow.h"
+
+#include <algorithm>
+
+using namespace gamespace;
+
+// games in flight before the queues have to grow
+static const size_t RESERVED_GAMES{256};
+
+TurnLoop &TurnLoop::operator=(TurnLoop &&other) noexcept {
+  if (this != &other) {
+    if (coroutine != nullptr)
+      coroutine.destroy();
+    coroutine = std::exchange(other.coroutine, nullptr);
+  }
+  return *this;
+}
+
+TurnLoop::~TurnLoop() {
+  if (coroutine != nullptr)
+    coroutine.destroy();
+}
+
+Scheduler::Scheduler() : ready(), running(), timers() {
+  ready.reserve(RESERVED_GAMES);
+  running.reserve(RESERVED_GAMES);
+  timers.reserve(RESERVED_GAMES);
+}
+
+void Scheduler::post(std::coroutine_handle<> coroutine) {
+  ready.push_back(coroutine);
+}
+
+void Scheduler::wakeAt(Clock::time_point until,
+                       std::coroutine_handle<> coroutine) {
+  timers.push_back({until, coroutine});
+  std::push_heap(timers.begin(), timers.end());
+}
+
+void Scheduler::forget(std::coroutine_handle<> coroutine) {
+  std::erase(ready, coroutine);
+  if (std::erase_if(timers, [&](const Timer &timer) {
+        return timer.coroutine == coroutine;
+      }) != 0)
+    std::make_heap(timers.begin(), timers.end());
+}
+
+// what gets posted while running waits for the next run, a coroutine that
+// keeps posting itself cannot starve the others or the caller
+size_t Scheduler::run(Clock::time_point now) {
+  running.swap(ready);
+  while (!timers.empty() && timers.front().until <= now) {
+    running.push_back(timers.front().coroutine);
+    std::pop_heap(timers.begin(), timers.end());
+    timers.pop_back();
+  }
+  for (std::coroutine_handle<> coroutine : running)
+    coroutine.resume();
+  const size_t resumed{running.size()};
+  running.clear();
+  return resumed;
+}
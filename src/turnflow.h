@@ -0,0 +1,166 @@
+#ifndef TURNFLOW_H
+#define TURNFLOW_H
+
+#include <array>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <utility>
+#include <vector>
+
+namespace gamespace {
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief Coroutine that plays one game from start to end. It starts
+ * suspended, posting handle() to a Scheduler enters it.
+ */
+class TurnLoop {
+public:
+  struct promise_type {
+    TurnLoop get_return_object() {
+      return TurnLoop(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    std::suspend_always final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+  std::coroutine_handle<> handle() const { return coroutine; }
+  bool done() const { return coroutine == nullptr || coroutine.done(); }
+
+private:
+  std::coroutine_handle<promise_type> coroutine;
+
+public:
+  TurnLoop() : coroutine(nullptr) {}
+  explicit TurnLoop(std::coroutine_handle<promise_type> coroutine)
+      : coroutine(coroutine) {}
+  TurnLoop(TurnLoop &&other) noexcept
+      : coroutine(std::exchange(other.coroutine, nullptr)) {}
+  TurnLoop &operator=(TurnLoop &&other) noexcept;
+  ~TurnLoop();
+};
+
+/**
+ * @brief Resumes suspended coroutines, on the thread calling run(), once
+ * what they wait for happened: input in an InputQueue or a timer.
+ *
+ * Games waiting on a human or a timer cost nothing but their frame, so
+ * one thread can drive as many games as it has memory for. Nothing here
+ * is thread safe, everything touching a scheduler runs on its thread.
+ * Queues are reserved up front and only grow past what a few hundred
+ * games need.
+ */
+class Scheduler {
+public:
+  struct Sleep {
+    Scheduler &scheduler;
+    Clock::time_point until;
+    // always suspends, even a zero sleep lets the caller draw a frame
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> coroutine) {
+      scheduler.wakeAt(until, coroutine);
+    }
+    void await_resume() const noexcept {}
+  };
+
+  // resumed by the next run()
+  void post(std::coroutine_handle<> coroutine);
+  void wakeAt(Clock::time_point until, std::coroutine_handle<> coroutine);
+  // co_await scheduler.sleep(...)
+  Sleep sleep(Clock::duration duration) {
+    return {*this, Clock::now() + duration};
+  }
+  // drops every pending resume of a coroutine about to be destroyed
+  void forget(std::coroutine_handle<> coroutine);
+  // resumes what was posted and every timer due by now, returns how many
+  size_t run(Clock::time_point now = Clock::now());
+  bool empty() const { return ready.empty() && timers.empty(); }
+
+private:
+  struct Timer {
+    Clock::time_point until;
+    std::coroutine_handle<> coroutine;
+    // std heaps keep the largest on top, the earliest has to be
+    bool operator<(const Timer &other) const { return until > other.until; }
+  };
+  std::vector<std::coroutine_handle<>> ready;
+  std::vector<std::coroutine_handle<>> running; // swapped with ready
+  std::vector<Timer> timers;                    // heap, earliest first
+
+public:
+  Scheduler();
+  Scheduler(const Scheduler &) = delete;
+  Scheduler &operator=(const Scheduler &) = delete;
+};
+
+/**
+ * @brief Bounded queue of timestamped input for one coroutine, like the
+ * rolls and clicks of a human seat. Input that arrives while the
+ * coroutine is busy waits for it, the oldest is dropped when the queue is
+ * full. A wait skips input stamped before a given time, a key pressed
+ * during someone else's turn does not count for the next one.
+ * Timestamps are whatever clock the caller uses, SDL's for the game.
+ */
+template <class T, size_t N> class InputQueue {
+public:
+  struct Input {
+    T value;
+    std::uint64_t timestamp;
+  };
+  struct Next {
+    InputQueue &queue;
+    std::uint64_t since;
+    bool await_ready() { return queue.skipBefore(since); }
+    void await_suspend(std::coroutine_handle<> coroutine) {
+      queue.waiter = coroutine;
+      queue.since = since;
+    }
+    Input await_resume() { return queue.pop(); }
+  };
+
+  void push(const T &value, std::uint64_t timestamp) {
+    if (count == N) {
+      first = (first + 1) % N;
+      count--;
+      dropped++;
+    }
+    inputs[(first + count++) % N] = {value, timestamp};
+    if (waiter != nullptr && skipBefore(since))
+      scheduler.post(std::exchange(waiter, nullptr));
+  }
+  // co_await queue.next(since), the first input stamped since then
+  Next next(std::uint64_t since) { return {*this, since}; }
+  long getDropped() const { return dropped; }
+
+private:
+  Scheduler &scheduler;
+  std::array<Input, N> inputs;
+  size_t first, count;
+  std::coroutine_handle<> waiter;
+  std::uint64_t since; // of the waiter
+  long dropped;        // because the queue was full
+  // true when an input stamped since then is left
+  bool skipBefore(std::uint64_t since) {
+    while (count != 0 && inputs[first].timestamp < since)
+      first = (first + 1) % N, count--;
+    return count != 0;
+  }
+  Input pop() {
+    const Input input{inputs[first]};
+    first = (first + 1) % N;
+    count--;
+    return input;
+  }
+
+public:
+  explicit InputQueue(Scheduler &scheduler)
+      : scheduler(scheduler), inputs(), first(0), count(0), waiter(nullptr),
+        since(0), dropped(0) {}
+};
+
+} // namespace gamespace
+#endif
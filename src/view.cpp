@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <cmath>
+#include <cstdio>
 #include <iostream>
 #include <unordered_map>
 
@@ -12,6 +14,7 @@
 #include "SDL3/SDL_oldnames.h"
 #include "SDL3/SDL_video.h"
 #include "commons.h"
+#include "log.h"
 #include "view.h"
 
 using namespace gamespace;
@@ -33,59 +36,136 @@ const Color Color::DARK_GREEN(90, 150, 33);
 const Color Color::DARK_BLUE(33, 162, 217);
 const Color Color::DARK_YELLOW(245, 208, 65);
 
-WindowManager::WindowManager() : window(nullptr), renderer(nullptr) {
-  if (!SDL_Init(SDL_INIT_AUDIO | SDL_INIT_VIDEO))
-    (std::cerr << "SDL initialization error[" << SDL_GetError() << "]\n")
-        .flush();
+WindowManager::WindowManager(bool offscreen, Backend backend)
+    : offscreen(offscreen), window(nullptr), surface(nullptr),
+      renderer(nullptr), backend(backend), framebuffer(), streaming(nullptr),
+      overlays(), cache(nullptr), cacheFramebuffer(), vertices(), indices() {
+  // more than a busy frame needs, so frames never grow them later
+  overlays.reserve(32);
+  vertices.reserve(4096);
+  indices.reserve(3 * 4096);
+  if (!offscreen && !SDL_Init(SDL_INIT_AUDIO | SDL_INIT_VIDEO))
+    LOG_ERROR("SDL initialization error[%s]", SDL_GetError());
+}
+
+static inline std::uint32_t toARGB(const Color &c) {
+  return static_cast<std::uint32_t>(c.a) << 24 | c.r << 16 | c.g << 8 | c.b;
 }
 
 bool WindowManager::drawPoint(int x, int y, const Color &c) const {
   if (!isReady())
     return false;
-  setDrawColor(c);
-  return SDL_RenderPoint(renderer, x, y);
+  if (backend == Backend::SOFTWARE)
+    return framebuffer.fillRect(x, y, 1, 1, toARGB(c)), true;
+  addQuad(x, y, x + 1, y, x + 1, y + 1, x, y + 1, c);
+  return true;
+}
+
+static inline SDL_FColor toFColor(const Color &c) {
+  return {c.r / 255.0f, c.g / 255.0f, c.b / 255.0f, c.a / 255.0f};
+}
+
+void WindowManager::addVertex(float x, float y, const Color &c) const {
+  vertices.push_back({{x, y}, toFColor(c), {0, 0}});
+}
+
+// corners in order around the quad
+void WindowManager::addQuad(float x1, float y1, float x2, float y2, float x3,
+                            float y3, float x4, float y4,
+                            const Color &c) const {
+  const int first{static_cast<int>(vertices.size())};
+  addVertex(x1, y1, c), addVertex(x2, y2, c);
+  addVertex(x3, y3, c), addVertex(x4, y4, c);
+  for (int i : {0, 1, 2, 0, 2, 3})
+    indices.push_back(first + i);
+}
+
+// everything recorded since the last flush in one call, needed before
+// anything that is not geometry so the drawing order stays the same
+bool WindowManager::flushGeometry() const {
+  if (indices.empty())
+    return true;
+  const bool result{SDL_RenderGeometry(renderer, nullptr, vertices.data(),
+                                       vertices.size(), indices.data(),
+                                       indices.size())};
+  if (!result)
+    LOG_ERROR("Could not render geometry [%s]", SDL_GetError());
+  vertices.clear();
+  indices.clear();
+  return result;
 }
 
 bool WindowManager::drawLine(int x1, int y1, int x2, int y2,
                              const Color &c) const {
   if (!isReady())
     return false;
-  setDrawColor(c);
-  return SDL_RenderLine(renderer, x1, y1, x2, y2);
+  if (backend == Backend::SOFTWARE)
+    return framebuffer.drawLine(x1, y1, x2, y2, toARGB(c)), true;
+  // a one pixel wide quad through the pixel centers, half a pixel longer
+  // at both ends so the end points are covered like with SDL_RenderLine
+  const float dx{static_cast<float>(x2 - x1)}, dy{static_cast<float>(y2 - y1)};
+  const float length{std::max(1.0f, std::hypot(dx, dy))};
+  const float ux{dx / length / 2}, uy{dy / length / 2};
+  const float ax{x1 + 0.5f - ux}, ay{y1 + 0.5f - uy};
+  const float bx{x2 + 0.5f + ux}, by{y2 + 0.5f + uy};
+  if (x1 == x2 && y1 == y2)
+    addQuad(x1, y1, x1 + 1, y1, x1 + 1, y1 + 1, x1, y1 + 1, c);
+  else
+    addQuad(ax - uy, ay + ux, bx - uy, by + ux, bx + uy, by - ux, ax + uy,
+            ay - ux, c);
+  return true;
 }
 
 void WindowManager::setDrawColor(const Color &c) const {
   if (!SDL_SetRenderDrawColor(renderer, c.r, c.g, c.b, c.a))
-    (std::cerr << "Render draw color setting error [" << SDL_GetError()
-               << "]\n")
-        .flush();
+    LOG_ERROR("Render draw color setting error [%s]", SDL_GetError());
 }
 
 bool WindowManager::fillRect(int x, int y, int w, int h, const Color &c) const {
-  static SDL_FRect frect{};
   if (!isReady())
     return false;
-  setDrawColor(c);
-  frect.x = (float)x, frect.y = (float)y, frect.w = (float)w,
-  frect.h = (float)h;
-  return SDL_RenderFillRect(renderer, &frect);
+  if (backend == Backend::SOFTWARE)
+    return framebuffer.fillRect(x, y, w, h, toARGB(c)), true;
+  addQuad(x, y, x + w, y, x + w, y + h, x, y + h, c);
+  return true;
 }
 
+// the framebuffer follows the output size, checked once per frame here
 bool WindowManager::fillBackground(const Color &c) const {
   if (!isReady())
     return false;
+  if (backend == Backend::SOFTWARE) {
+    int w, h;
+    if (!SDL_GetCurrentRenderOutputSize(renderer, &w, &h))
+      return false;
+    if (streaming == nullptr || w != framebuffer.getWidth() ||
+        h != framebuffer.getHeight()) {
+      SDL_DestroyTexture(streaming);
+      streaming = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
+                                    SDL_TEXTUREACCESS_STREAMING, w, h);
+      if (streaming == nullptr) {
+        LOG_ERROR("Could not create streaming texture [%s]", SDL_GetError());
+        return false;
+      }
+      SDL_SetTextureBlendMode(streaming, SDL_BLENDMODE_NONE); // opaque
+      framebuffer.resize(w, h);
+    }
+    overlays.clear();
+    framebuffer.clear(toARGB(c));
+    return true;
+  }
+  vertices.clear(); // would be covered anyway
+  indices.clear();
   setDrawColor(c);
   if (!SDL_RenderClear(renderer)) {
-    (std::cerr << "Background color rendering error [" << SDL_GetError()
-               << "]\n")
-        .flush();
+    LOG_ERROR("Background color rendering error [%s]", SDL_GetError());
     return false;
   }
   return true;
 }
 
 inline bool WindowManager::isReady() const {
-  return window != nullptr && renderer != nullptr;
+  return (window != nullptr || surface != nullptr) && renderer != nullptr;
 }
 
 bool WindowManager::drawTexture(const char *imageName,
@@ -94,35 +174,82 @@ bool WindowManager::drawTexture(const char *imageName,
     return false;
   if (!textures.contains(imageName))
     return false;
+  if (backend == Backend::SOFTWARE)
+    return overlays.push_back({textures.at(imageName), *box, {}, {}}), true;
+  flushGeometry();
   return SDL_RenderTexture(renderer, textures.at(imageName), nullptr, box);
 }
 
-void WindowManager::render() const { SDL_RenderPresent(renderer); }
+void WindowManager::render() const {
+  if (backend == Backend::SOFTWARE)
+    presentFramebuffer();
+  else
+    flushGeometry();
+  SDL_RenderPresent(renderer);
+}
+
+// uploads what changed since the last frame and draws the whole texture,
+// the SDL backbuffer is undefined after a present
+bool WindowManager::presentFramebuffer() const {
+  if (streaming == nullptr)
+    return false;
+  const Framebuffer::Rect dirty{framebuffer.takeDirty()};
+  if (dirty.w > 0) {
+    const SDL_Rect rect{dirty.x, dirty.y, dirty.w, dirty.h};
+    const std::uint32_t *first{framebuffer.data() +
+                               dirty.y * framebuffer.getWidth() + dirty.x};
+    if (!SDL_UpdateTexture(streaming, &rect, first,
+                           framebuffer.getWidth() * 4)) {
+      LOG_ERROR("Could not update texture [%s]", SDL_GetError());
+      return false;
+    }
+  }
+  bool result{SDL_RenderTexture(renderer, streaming, nullptr, nullptr)};
+  for (const Overlay &overlay : overlays) {
+    if (overlay.texture != nullptr) {
+      result &= SDL_RenderTexture(renderer, overlay.texture, nullptr,
+                                  &overlay.box);
+      continue;
+    }
+    SDL_SetRenderDrawColor(renderer, overlay.color.r, overlay.color.g,
+                           overlay.color.b, overlay.color.a);
+    result &= SDL_RenderDebugText(renderer, overlay.box.x, overlay.box.y,
+                                  overlay.text);
+  }
+  overlays.clear();
+  return result;
+}
 
 static inline double toRadians(double theta) {
   return theta * std::numbers::pi / 180;
 }
 
-bool View::drawStar(int x, int y, int side, const Color &c) const {
-  int rBig{9 * side / 20};
-  int rSmall{5 * side / 20}; // adjust later
-  int x1, x2, y1, y2, x3, y3;
-  for (int i = 0; i < 5; i++) {
-    x1 = x + side / 2 +
-         static_cast<int>(rBig * std::cos(toRadians(180 + 90 + 72 * i)));
-    y1 = y + side / 2 +
-         static_cast<int>(rBig * std::sin(toRadians(180 + 90 + 72 * i)));
-    x2 = x + side / 2 +
-         static_cast<int>(rSmall * std::cos(toRadians(180 + 90 + 36 + 72 * i)));
-    y2 = y + side / 2 +
-         static_cast<int>(rSmall * std::sin(toRadians(180 + 90 + 36 + 72 * i)));
-    x3 = x + side / 2 +
-         static_cast<int>(rSmall * std::cos(toRadians(180 + 90 - 36 + 72 * i)));
-    y3 = y + side / 2 +
-         static_cast<int>(rSmall * std::sin(toRadians(180 + 90 - 36 + 72 * i)));
-    windowManager.drawLine(x1, y1, x2, y2, c);
-    windowManager.drawLine(x1, y1, x3, y3, c);
+bool View::drawStar(int x, int y, int side, const Color &c) {
+  if (side != starSide) { // only after a resize
+    starSide = side;
+    int rBig{9 * side / 20};
+    int rSmall{5 * side / 20}; // adjust later
+    for (int i = 0; i < 5; i++) {
+      int x1 = side / 2 +
+               static_cast<int>(rBig * std::cos(toRadians(180 + 90 + 72 * i)));
+      int y1 = side / 2 +
+               static_cast<int>(rBig * std::sin(toRadians(180 + 90 + 72 * i)));
+      starLines[2 * i] = {
+          x1, y1,
+          side / 2 + static_cast<int>(
+                         rSmall * std::cos(toRadians(180 + 90 + 36 + 72 * i))),
+          side / 2 + static_cast<int>(
+                         rSmall * std::sin(toRadians(180 + 90 + 36 + 72 * i)))};
+      starLines[2 * i + 1] = {
+          x1, y1,
+          side / 2 + static_cast<int>(
+                         rSmall * std::cos(toRadians(180 + 90 - 36 + 72 * i))),
+          side / 2 + static_cast<int>(
+                         rSmall * std::sin(toRadians(180 + 90 - 36 + 72 * i)))};
+    }
   }
+  for (const auto &[x1, y1, x2, y2] : starLines)
+    windowManager.drawLine(x + x1, y + y1, x + x2, y + y2, c);
   return true;
 }
 bool WindowManager::loadTexture(const char *filename) {
@@ -132,7 +259,7 @@ bool WindowManager::loadTexture(const char *filename) {
     return true;
   SDL_Texture *texture = IMG_LoadTexture(renderer, filename);
   if (texture == nullptr) {
-    (std::cerr << "Could not load texture [" << filename << "]\n").flush();
+    LOG_ERROR("Could not load texture [%s]", filename);
     return false;
   }
   textures[filename] = texture;
@@ -145,69 +272,143 @@ bool WindowManager::startWindow() {
     return: bool, wether the whole operation is successfull.
    */
   if (window != nullptr) {
-    std::clog << "Window already started\n";
-    std::clog.flush();
+    LOG_WARNING("Window already started");
     return false;
   }
-  window = SDL_CreateWindow("LudoCpp", WINDOW_SIZE, WINDOW_SIZE, 0);
+  window = SDL_CreateWindow("LudoCpp", WINDOW_SIZE, WINDOW_SIZE,
+                            SDL_WINDOW_HIGH_PIXEL_DENSITY);
   if (window == nullptr) {
-    std::cerr << "SDL window creation error[" << SDL_GetError() << "]\n";
-    std::cerr.flush();
+    LOG_ERROR("SDL window creation error[%s]", SDL_GetError());
     return false;
   }
   renderer = SDL_CreateRenderer(window, nullptr);
   if (renderer == nullptr) {
-    std::cerr << "SDL renderer creation error[" << SDL_GetError() << "]\n";
-    std::cerr.flush();
+    LOG_ERROR("SDL renderer creation error[%s]", SDL_GetError());
     return false;
   }
 
   if (!SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND)) {
-    std::cerr << "SDL renderer blend mode error [" << SDL_GetError() << "]\n";
-    std::cerr.flush();
+    LOG_ERROR("SDL renderer blend mode error [%s]", SDL_GetError());
     return false;
   }
   if (!SDL_SetWindowResizable(window, true)) {
-    std::cerr << "SDL could not set resizable window [" << SDL_GetError()
-              << "]\n";
-    std::cerr.flush();
+    LOG_ERROR("SDL could not set resizable window [%s]", SDL_GetError());
+    return false;
+  }
+  return true;
+}
+
+bool WindowManager::startOffscreen(int size) {
+  if (window != nullptr || surface != nullptr) {
+    LOG_WARNING("Window already started");
+    return false;
+  }
+  surface = SDL_CreateSurface(size, size, SDL_PIXELFORMAT_ARGB8888);
+  if (surface == nullptr) {
+    LOG_ERROR("SDL surface creation error[%s]", SDL_GetError());
+    return false;
+  }
+  renderer = SDL_CreateSoftwareRenderer(surface);
+  if (renderer == nullptr) {
+    LOG_ERROR("SDL renderer creation error[%s]", SDL_GetError());
+    return false;
+  }
+  if (!SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND)) {
+    LOG_ERROR("SDL renderer blend mode error [%s]", SDL_GetError());
     return false;
   }
   return true;
 }
 
+bool WindowManager::saveImage(const char *path) const {
+  if (!isReady())
+    return false;
+  if (backend == Backend::SOFTWARE)
+    presentFramebuffer();
+  else
+    flushGeometry();
+  SDL_Surface *pixels{SDL_RenderReadPixels(renderer, nullptr)};
+  if (pixels == nullptr) {
+    LOG_ERROR("Could not read pixels [%s]", SDL_GetError());
+    return false;
+  }
+  bool saved{IMG_SavePNG(pixels, path)};
+  if (!saved)
+    LOG_ERROR("Could not save [%s] [%s]", path, SDL_GetError());
+  SDL_DestroySurface(pixels);
+  return saved;
+}
+
 WindowManager::~WindowManager() {
   for (const auto &texture : textures)
     SDL_DestroyTexture(texture.second);
+  SDL_DestroyTexture(streaming);
+  SDL_DestroyTexture(cache);
   SDL_DestroyRenderer(renderer);
+  SDL_DestroySurface(surface);
   SDL_DestroyWindow(window);
-  SDL_Quit();
+  if (!offscreen)
+    SDL_Quit();
 }
 
-View::View() : windowManager() {
-  windowManager.startWindow();
+View::View(bool offscreen, Backend backend)
+    : windowManager(offscreen, backend),
+      layout(Layout::compute(WINDOW_SIZE, WINDOW_SIZE, 1)), boardCached(false),
+      starSide(0), starLines() {
+  if (offscreen)
+    windowManager.startOffscreen(WINDOW_SIZE);
+  else
+    windowManager.startWindow();
   if (!windowManager.isReady())
-    (std::cerr << "Can't draw, exiting\n").flush();
+    LOG_ERROR("Can't draw, exiting");
+  // offscreen views leave the globals alone, several threads may have one
+  if (!offscreen)
+    updateWindowDimensions();
   // windowManager.loadTexture("star.png");
 }
 
 View::~View() {}
 
 bool WindowManager::fillCircle(int x, int y, int r, const Color &c) const {
-  int xMax{x + r}, xMin{x - r}, yMax{y + r}, yMin{y - r};
-  bool result{true};
-  double distance;
-  setDrawColor(c);
-  for (int x1 = xMin; x1 < xMax; x1++) {
-    for (int y1 = yMin; y1 < yMax; y1++) {
-      distance = std::sqrt(std::pow(x1 - x, 2) + std::pow(y1 - y, 2));
-      if (distance < r)
-        result &= SDL_RenderPoint(renderer, x1, y1);
-    }
+  if (backend == Backend::SOFTWARE) {
+    if (!isReady())
+      return false;
+    framebuffer.fillCircle(x, y, r, toARGB(c));
+    return true;
   }
-  if (!result)
-    (std::cerr << "Could not render point" << SDL_GetError()).flush();
-  return result;
+  if (!isReady())
+    return false;
+  // a fan around the center, more segments for bigger circles
+  const int segments{std::clamp(2 * r, 8, 64)};
+  const int center{static_cast<int>(vertices.size())};
+  addVertex(x, y, c);
+  for (int i = 0; i < segments; i++) {
+    const double angle{2 * std::numbers::pi * i / segments};
+    addVertex(x + r * std::cos(angle), y + r * std::sin(angle), c);
+    indices.push_back(center);
+    indices.push_back(center + 1 + i);
+    indices.push_back(center + 1 + (i + 1) % segments);
+  }
+  return true;
+}
+
+bool WindowManager::drawText(int x, int y, const char *text,
+                             const Color &c) const {
+  if (!isReady())
+    return false;
+  if (backend == Backend::SOFTWARE) {
+    overlays.push_back({nullptr,
+                        {static_cast<float>(x), static_cast<float>(y), 0, 0},
+                        {},
+                        {static_cast<Uint8>(c.r), static_cast<Uint8>(c.g),
+                         static_cast<Uint8>(c.b), static_cast<Uint8>(c.a)}});
+    std::snprintf(overlays.back().text, sizeof(overlays.back().text), "%s",
+                  text);
+    return true;
+  }
+  flushGeometry();
+  setDrawColor(c);
+  return SDL_RenderDebugText(renderer, x, y, text);
 }
 
 // still no clue why i have to add the gamespace namespace in here
@@ -215,165 +416,226 @@ constexpr bool gamespace::operator==(const Color &c1, const Color &c2) {
   return c1.r == c2.r && c1.g == c2.g && c1.b == c2.b && c1.a == c2.a;
 }
 
-static const std::unordered_map<char, std::pair<int, int>> colorToDiceOffsets{
-    {'r', {3, 12}}, {'g', {3, 3}}, {'y', {12, 3}}, {'b', {12, 12}}};
+// in tiles, colors in Layout order
+static const std::array<SDL_Point, 4> DICE_OFFSETS{
+    SDL_Point{3, 12}, SDL_Point{3, 3}, SDL_Point{12, 3}, SDL_Point{12, 12}};
+static const std::array<std::array<SDL_Point, 4>, 4> JAIL_OFFSETS{{
+    {SDL_Point{2, 11}, SDL_Point{4, 13}, SDL_Point{2, 13}, SDL_Point{4, 11}},
+    {SDL_Point{2, 2}, SDL_Point{4, 4}, SDL_Point{2, 4}, SDL_Point{4, 2}},
+    {SDL_Point{11, 2}, SDL_Point{13, 4}, SDL_Point{11, 4}, SDL_Point{13, 2}},
+    {SDL_Point{11, 11}, SDL_Point{13, 13}, SDL_Point{11, 13},
+     SDL_Point{13, 11}},
+}};
+static const Color *const LAYOUT_COLORS[4]{&Color::RED, &Color::GREEN,
+                                           &Color::YELLOW, &Color::BLUE};
+
+Layout Layout::compute(int width, int height, float density) {
+  Layout layout{};
+  layout.windowSize = std::min(width, height);
+  layout.windowSize -= layout.windowSize % 15;
+  layout.tileSize = layout.windowSize / 15;
+  layout.density = density;
+  for (int color = 0; color < 4; color++) {
+    layout.diceCenters[color] = {DICE_OFFSETS[color].x * layout.tileSize,
+                                 DICE_OFFSETS[color].y * layout.tileSize};
+    for (int i = 0; i < 4; i++)
+      layout.jailCenters[color][i] = {
+          JAIL_OFFSETS[color][i].x * layout.tileSize,
+          JAIL_OFFSETS[color][i].y * layout.tileSize};
+  }
+  return layout;
+}
 
-static char colorToChar(const Color &c) {
+static int colorToIndex(const Color &c) {
   if (c == Color::RED)
-    return 'r';
+    return 0;
   if (c == Color::GREEN)
-    return 'g';
+    return 1;
   if (c == Color::YELLOW)
-    return 'y';
+    return 2;
   if (c == Color::BLUE)
-    return 'b';
+    return 3;
   else {
-    std::cerr << "Goofy color" << std::endl;
+    LOG_ERROR("Goofy color");
     exit(0);
   }
 }
 
-void View::highLightPosition(int x, int y, const Color &c, int width,
-                             int height) {
+void View::highLightPosition(int x, int y, const Color &c) {
   const Color cTransparent{c.r, c.g, c.b, 127};
-  windowManager.fillRect(x, y, width, height, cTransparent);
+  const int ts{layout.tileSize};
+  windowManager.fillRect(x, y, ts, ts, cTransparent);
 }
 
 void View::drawDice(const Color &c, int value) {
+  const int ts{layout.tileSize};
   if (value < 1 || value > 6)
     exit(0); // error, TODO: clean later
-  auto [x, y] = colorToDiceOffsets.at(colorToChar(c));
-  int xCenter{x * TS}, yCenter{y * TS};
+  auto [xCenter, yCenter] = layout.diceCenters[colorToIndex(c)];
+  const int dot{std::max(2, static_cast<int>(2 * layout.density))};
   if (value == 1 || value == 5 || value == 3) {
-    windowManager.fillCircle(xCenter, yCenter, 2, Color::BLACK);
+    windowManager.fillCircle(xCenter, yCenter, dot, Color::BLACK);
   }
   if (value == 2 || value == 6) {
-    windowManager.fillCircle(xCenter - TS / 8, yCenter, 2, Color::BLACK);
-    windowManager.fillCircle(xCenter + TS / 8, yCenter, 2, Color::BLACK);
+    windowManager.fillCircle(xCenter - ts / 8, yCenter, dot, Color::BLACK);
+    windowManager.fillCircle(xCenter + ts / 8, yCenter, dot, Color::BLACK);
   }
   if (value >= 3) {
-    windowManager.fillCircle(xCenter - TS / 8, yCenter + TS / 8, 2,
+    windowManager.fillCircle(xCenter - ts / 8, yCenter + ts / 8, dot,
                              Color::BLACK);
-    windowManager.fillCircle(xCenter + TS / 8, yCenter - TS / 8, 2,
+    windowManager.fillCircle(xCenter + ts / 8, yCenter - ts / 8, dot,
                              Color::BLACK);
   }
   if (value >= 4) {
-    windowManager.fillCircle(xCenter + TS / 8, yCenter + TS / 8, 2,
+    windowManager.fillCircle(xCenter + ts / 8, yCenter + ts / 8, dot,
                              Color::BLACK);
-    windowManager.fillCircle(xCenter - TS / 8, yCenter - TS / 8, 2,
+    windowManager.fillCircle(xCenter - ts / 8, yCenter - ts / 8, dot,
                              Color::BLACK);
   }
 }
 
+void View::drawWinProbability(const Color &c, float probability) {
+  const int ts{layout.tileSize};
+  auto [x, y] = layout.diceCenters[colorToIndex(c)];
+  char text[8];
+  std::snprintf(text, sizeof(text), "%d%%",
+                static_cast<int>(std::lround(probability * 100)));
+  // right of the dice box, vertically centered on it
+  windowManager.drawText(x + ts / 4 + 4,
+                         y - SDL_DEBUG_TEXT_FONT_CHARACTER_SIZE / 2, text,
+                         Color::BLACK);
+}
+
+void View::drawMoveDelta(int x, int y, float delta) {
+  char text[8];
+  std::snprintf(text, sizeof(text), "%+d",
+                static_cast<int>(std::lround(delta * 100)));
+  windowManager.drawText(x + 2, y + 2, text, Color::BLACK);
+}
+
+void View::drawStatus(const char *text) {
+  windowManager.drawText(4, 4, text, Color::BLACK);
+}
+
+void View::drawHeat(int x, int y, float intensity) {
+  const int ts{layout.tileSize};
+  const int alpha{static_cast<int>(std::lround(
+      std::clamp(intensity, 0.0f, 1.0f) * 200))};
+  windowManager.fillRect(x, y, ts, ts, Color(Color::DARK_RED.r,
+                                             Color::DARK_RED.g,
+                                             Color::DARK_RED.b, alpha));
+}
+
+bool View::saveImage(const char *path) const {
+  return windowManager.saveImage(path);
+}
+
 void View::preparePlayerDice(const Color &c) {
+  const int ts{layout.tileSize};
   // TODO: should probably just draw a square around,
   // optimization to be performed later
   // not DRY ... I don't care.
-  auto [x, y] = colorToDiceOffsets.at(colorToChar(c));
-  int xCenter{x * TS}, yCenter{y * TS};
+  auto [xCenter, yCenter] = layout.diceCenters[colorToIndex(c)];
   // TODO: should probably just draw a square around,
   // optimization to be performed later
-  windowManager.fillRect(xCenter - TS / 4, yCenter - TS / 4, TS / 2, TS / 2,
+  windowManager.fillRect(xCenter - ts / 4, yCenter - ts / 4, ts / 2, ts / 2,
                          Color::BLACK);
-  windowManager.fillRect(xCenter - TS / 4 + 1, yCenter - TS / 4 + 1, TS / 2 - 2,
-                         TS / 2 - 2, Color::WHITE);
+  windowManager.fillRect(xCenter - ts / 4 + 1, yCenter - ts / 4 + 1, ts / 2 - 2,
+                         ts / 2 - 2, Color::WHITE);
 }
 
+// the board only changes with the layout, so it is drawn once per resize
+// and copied from the cache every other frame
 void View::drawBoard() {
+  if (boardCached && windowManager.drawCache())
+    return;
+  boardCached = windowManager.beginCache();
+  drawBoardShapes();
+  if (boardCached)
+    boardCached = windowManager.endCache();
+}
+
+void View::drawBoardShapes() {
+  const int ts{layout.tileSize};
   // Bismillah
 
   // global background
   windowManager.fillBackground(Color::WHITE);
 
   // the four main player boxes
-  windowManager.fillRect(0, 0, 6 * TS, 6 * TS, Color::GREEN);
-  windowManager.fillRect(TS, TS, 4 * TS, 4 * TS, Color::WHITE);
-  windowManager.fillRect(9 * TS, 0, 6 * TS, 6 * TS, Color::YELLOW);
-  windowManager.fillRect(10 * TS, TS, 4 * TS, 4 * TS, Color::WHITE);
-  windowManager.fillRect(0, 9 * TS, 6 * TS, 6 * TS, Color::RED);
-  windowManager.fillRect(TS, 10 * TS, 4 * TS, 4 * TS, Color::WHITE);
-  windowManager.fillRect(9 * TS, 9 * TS, 6 * TS, 6 * TS, Color::BLUE);
-  windowManager.fillRect(10 * TS, 10 * TS, 4 * TS, 4 * TS, Color::WHITE);
+  windowManager.fillRect(0, 0, 6 * ts, 6 * ts, Color::GREEN);
+  windowManager.fillRect(ts, ts, 4 * ts, 4 * ts, Color::WHITE);
+  windowManager.fillRect(9 * ts, 0, 6 * ts, 6 * ts, Color::YELLOW);
+  windowManager.fillRect(10 * ts, ts, 4 * ts, 4 * ts, Color::WHITE);
+  windowManager.fillRect(0, 9 * ts, 6 * ts, 6 * ts, Color::RED);
+  windowManager.fillRect(ts, 10 * ts, 4 * ts, 4 * ts, Color::WHITE);
+  windowManager.fillRect(9 * ts, 9 * ts, 6 * ts, 6 * ts, Color::BLUE);
+  windowManager.fillRect(10 * ts, 10 * ts, 4 * ts, 4 * ts, Color::WHITE);
 
   // last lines of each player
   for (int i = 1; i <= 5; i++) {
-    windowManager.fillRect(7 * TS, i * TS, TS, TS, Color::YELLOW);
-    windowManager.fillRect(i * TS, 7 * TS, TS, TS, Color::GREEN);
-    windowManager.fillRect((i + 8) * TS, 7 * TS, TS, TS, Color::BLUE);
-    windowManager.fillRect(7 * TS, (i + 8) * TS, TS, TS, Color::RED);
+    windowManager.fillRect(7 * ts, i * ts, ts, ts, Color::YELLOW);
+    windowManager.fillRect(i * ts, 7 * ts, ts, ts, Color::GREEN);
+    windowManager.fillRect((i + 8) * ts, 7 * ts, ts, ts, Color::BLUE);
+    windowManager.fillRect(7 * ts, (i + 8) * ts, ts, ts, Color::RED);
   }
 
   // start position of each player
-  windowManager.fillRect(8 * TS, TS, TS, TS, Color::YELLOW);
-  drawStar(8 * TS, TS, TS, Color::BLACK);
-  windowManager.fillRect(TS, 6 * TS, TS, TS, Color::GREEN);
-  drawStar(TS, TS * 6, TS, Color::BLACK);
-  windowManager.fillRect(13 * TS, 8 * TS, TS, TS, Color::BLUE);
-  drawStar(13 * TS, 8 * TS, TS, Color::BLACK);
-  windowManager.fillRect(6 * TS, 13 * TS, TS, TS, Color::RED);
-  drawStar(6 * TS, 13 * TS, TS, Color::BLACK);
+  windowManager.fillRect(8 * ts, ts, ts, ts, Color::YELLOW);
+  drawStar(8 * ts, ts, ts, Color::BLACK);
+  windowManager.fillRect(ts, 6 * ts, ts, ts, Color::GREEN);
+  drawStar(ts, ts * 6, ts, Color::BLACK);
+  windowManager.fillRect(13 * ts, 8 * ts, ts, ts, Color::BLUE);
+  drawStar(13 * ts, 8 * ts, ts, Color::BLACK);
+  windowManager.fillRect(6 * ts, 13 * ts, ts, ts, Color::RED);
+  drawStar(6 * ts, 13 * ts, ts, Color::BLACK);
 
   // the four other stars on the board
-  drawStar(2 * TS, TS * 8, TS, Color::BLACK);
-  drawStar(6 * TS, 2 * TS, TS, Color::BLACK);
-  drawStar(12 * TS, 6 * TS, TS, Color::BLACK);
-  drawStar(8 * TS, 12 * TS, TS, Color::BLACK);
+  drawStar(2 * ts, ts * 8, ts, Color::BLACK);
+  drawStar(6 * ts, 2 * ts, ts, Color::BLACK);
+  drawStar(12 * ts, 6 * ts, ts, Color::BLACK);
+  drawStar(8 * ts, 12 * ts, ts, Color::BLACK);
 
   // central square triangles
-  windowManager.drawTriangle(6 * TS, 6 * TS, 9 * TS, 6 * TS, 7.5 * TS, 7.5 * TS,
+  windowManager.drawTriangle(6 * ts, 6 * ts, 9 * ts, 6 * ts, 7.5 * ts, 7.5 * ts,
                              Color::YELLOW);
-  windowManager.drawTriangle(6 * TS, 6 * TS, 6 * TS, 9 * TS, 7.5 * TS, 7.5 * TS,
+  windowManager.drawTriangle(6 * ts, 6 * ts, 6 * ts, 9 * ts, 7.5 * ts, 7.5 * ts,
                              Color::GREEN);
-  windowManager.drawTriangle(9 * TS, 6 * TS, 9 * TS, 9 * TS, 7.5 * TS, 7.5 * TS,
+  windowManager.drawTriangle(9 * ts, 6 * ts, 9 * ts, 9 * ts, 7.5 * ts, 7.5 * ts,
                              Color::BLUE);
-  windowManager.drawTriangle(6 * TS, 9 * TS, 9 * TS, 9 * TS, 7.5 * TS, 7.5 * TS,
+  windowManager.drawTriangle(6 * ts, 9 * ts, 9 * ts, 9 * ts, 7.5 * ts, 7.5 * ts,
                              Color::RED);
 
   // central square diagonals
-  windowManager.drawLine(6 * TS, 6 * TS, 9 * TS, 9 * TS, Color::BLACK);
-  windowManager.drawLine(6 * TS, 9 * TS, 9 * TS, 6 * TS, Color::BLACK);
+  windowManager.drawLine(6 * ts, 6 * ts, 9 * ts, 9 * ts, Color::BLACK);
+  windowManager.drawLine(6 * ts, 9 * ts, 9 * ts, 6 * ts, Color::BLACK);
 
   // square black borders
   for (int i = 6; i <= 9; i++) {
-    windowManager.drawLine(i * TS, 9 * TS, i * TS, 15 * TS, Color::BLACK);
-    windowManager.drawLine(i * TS, 0, i * TS, 6 * TS, Color::BLACK);
-    windowManager.drawLine(9 * TS, i * TS, 15 * TS, i * TS, Color::BLACK);
-    windowManager.drawLine(0, i * TS, 6 * TS, i * TS, Color::BLACK);
-    windowManager.drawLine(0, i * TS, 6 * TS, i * TS, Color::BLACK);
+    windowManager.drawLine(i * ts, 9 * ts, i * ts, 15 * ts, Color::BLACK);
+    windowManager.drawLine(i * ts, 0, i * ts, 6 * ts, Color::BLACK);
+    windowManager.drawLine(9 * ts, i * ts, 15 * ts, i * ts, Color::BLACK);
+    windowManager.drawLine(0, i * ts, 6 * ts, i * ts, Color::BLACK);
+    windowManager.drawLine(0, i * ts, 6 * ts, i * ts, Color::BLACK);
   }
   for (int i = 1; i <= 6; i++) {
-    windowManager.drawLine(i * TS, 6 * TS, i * TS, 9 * TS, Color::BLACK);
-    windowManager.drawLine((i + 8) * TS, 6 * TS, (i + 8) * TS, 9 * TS,
+    windowManager.drawLine(i * ts, 6 * ts, i * ts, 9 * ts, Color::BLACK);
+    windowManager.drawLine((i + 8) * ts, 6 * ts, (i + 8) * ts, 9 * ts,
                            Color::BLACK);
-    windowManager.drawLine(6 * TS, i * TS, 9 * TS, i * TS, Color::BLACK);
-    windowManager.drawLine(6 * TS, (i + 8) * TS, 9 * TS, (i + 8) * TS,
+    windowManager.drawLine(6 * ts, i * ts, 9 * ts, i * ts, Color::BLACK);
+    windowManager.drawLine(6 * ts, (i + 8) * ts, 9 * ts, (i + 8) * ts,
                            Color::BLACK);
   }
 
   // initial position circles
-  windowManager.fillCircle(2 * TS, 2 * TS, TS / 2, Color::GREEN);
-  windowManager.fillCircle(4 * TS, 4 * TS, TS / 2, Color::GREEN);
-  windowManager.fillCircle(2 * TS, 4 * TS, TS / 2, Color::GREEN);
-  windowManager.fillCircle(4 * TS, 2 * TS, TS / 2, Color::GREEN);
-
-  windowManager.fillCircle(11 * TS, 11 * TS, TS / 2, Color::BLUE);
-  windowManager.fillCircle(13 * TS, 13 * TS, TS / 2, Color::BLUE);
-  windowManager.fillCircle(11 * TS, 13 * TS, TS / 2, Color::BLUE);
-  windowManager.fillCircle(13 * TS, 11 * TS, TS / 2, Color::BLUE);
-
-  windowManager.fillCircle(2 * TS, 11 * TS, TS / 2, Color::RED);
-  windowManager.fillCircle(4 * TS, 13 * TS, TS / 2, Color::RED);
-  windowManager.fillCircle(2 * TS, 13 * TS, TS / 2, Color::RED);
-  windowManager.fillCircle(4 * TS, 11 * TS, TS / 2, Color::RED);
-
-  windowManager.fillCircle(11 * TS, 2 * TS, TS / 2, Color::YELLOW);
-  windowManager.fillCircle(13 * TS, 4 * TS, TS / 2, Color::YELLOW);
-  windowManager.fillCircle(11 * TS, 4 * TS, TS / 2, Color::YELLOW);
-  windowManager.fillCircle(13 * TS, 2 * TS, TS / 2, Color::YELLOW);
-
-  for (auto [_, pair] : colorToDiceOffsets)
-    windowManager.fillRect(pair.first * TS - TS / 4, pair.second * TS - TS / 4,
-                           TS / 2, TS / 2, Color::BLACK);
+  for (int color = 0; color < 4; color++)
+    for (const SDL_Point &center : layout.jailCenters[color])
+      windowManager.fillCircle(center.x, center.y, ts / 2,
+                               *LAYOUT_COLORS[color]);
+
+  for (const SDL_Point &center : layout.diceCenters)
+    windowManager.fillRect(center.x - ts / 4, center.y - ts / 4, ts / 2,
+                           ts / 2, Color::BLACK);
 }
 
 static constexpr const Color &toDark(const Color &c) {
@@ -389,7 +651,8 @@ static constexpr const Color &toDark(const Color &c) {
     return Color::BLACK;
 }
 
-void View::drawPiece(int x, int y, const Color &c, int radius) {
+void View::drawPiece(int x, int y, const Color &c) {
+  const int radius{layout.tileSize / 8};
   windowManager.fillCircle(x, y, radius, Color::BLACK);
   windowManager.fillCircle(x, y, radius - 2, toDark(c));
 }
@@ -398,43 +661,113 @@ void View::drawPiece(int x, int y, const Color &c, int radius) {
 // https://www.reddit.com/r/gamedev/comments/1l0tr5b/comment/mvn2y1c/?utm_source=share&utm_medium=web3x&utm_name=web3xcss&utm_term=1&utm_content=share_button
 bool WindowManager::drawTriangle(int x1, int y1, int x2, int y2, int x3, int y3,
                                  const Color &c) const {
-  float r{c.r / 255.0f}, g{c.g / 255.0f}, b{c.b / 255.0f}, a{c.a / 255.0f};
-  std::vector<SDL_Vertex> vertices{SDL_Vertex{
-                                       SDL_FPoint{(float)x1, (float)y1},
-                                       {(float)r, g, b, a},
-                                       SDL_FPoint{0, 0},
-                                   },
-                                   SDL_Vertex{
-                                       SDL_FPoint{(float)x2, (float)y2},
-                                       {r, g, b, a},
-                                       SDL_FPoint{0, 0},
-                                   },
-                                   SDL_Vertex{
-                                       SDL_FPoint{(float)x3, (float)y3},
-                                       {r, g, b, a},
-                                       SDL_FPoint{0, 0},
-                                   }};
-  // setDrawColor(c);
-  if (!SDL_RenderGeometry(renderer, nullptr, vertices.data(), vertices.size(),
-                          nullptr, 0)) {
-    (std::cerr << "Could not render geometry [" << SDL_GetError() << "]\n")
-        .flush();
-    return false;
+  if (backend == Backend::SOFTWARE) {
+    if (!isReady())
+      return false;
+    framebuffer.fillTriangle(x1, y1, x2, y2, x3, y3, toARGB(c));
+    return true;
   }
+  if (!isReady())
+    return false;
+  const int first{static_cast<int>(vertices.size())};
+  addVertex(x1, y1, c), addVertex(x2, y2, c), addVertex(x3, y3, c);
+  for (int i = 0; i < 3; i++)
+    indices.push_back(first + i);
   return true;
 }
 
 void View::updateWindowDimensions() {
   auto [w, h] = windowManager.getWidthAndHeight();
-  syncSizes(w, h);
+  layout = Layout::compute(w, h, windowManager.getPixelDensity());
+  boardCached = false;
+}
+
+bool View::handleWindowEvent(const SDL_Event &event) {
+  if (event.type != SDL_EVENT_WINDOW_RESIZED &&
+      event.type != SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED &&
+      event.type != SDL_EVENT_WINDOW_DISPLAY_SCALE_CHANGED)
+    return false;
+  updateWindowDimensions();
+  return true;
+}
+
+bool View::toRenderCoordinates(SDL_Event &event) const {
+  return windowManager.toRenderCoordinates(event);
 }
 void View::render() { windowManager.render(); }
 
+float WindowManager::getPixelDensity() const {
+  if (window == nullptr)
+    return 1;
+  const float density{SDL_GetWindowPixelDensity(window)};
+  return density > 0 ? density : 1;
+}
+
+bool WindowManager::toRenderCoordinates(SDL_Event &event) const {
+  return isReady() && SDL_ConvertEventToRenderCoordinates(renderer, &event);
+}
+
+bool WindowManager::beginCache() {
+  if (!isReady())
+    return false;
+  if (backend == Backend::SOFTWARE)
+    return true; // the framebuffer is copied in endCache
+  int w, h;
+  if (!SDL_GetCurrentRenderOutputSize(renderer, &w, &h))
+    return false;
+  float cacheW, cacheH;
+  if (cache == nullptr || !SDL_GetTextureSize(cache, &cacheW, &cacheH) ||
+      cacheW != w || cacheH != h) {
+    SDL_DestroyTexture(cache);
+    cache = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
+                              SDL_TEXTUREACCESS_TARGET, w, h);
+    if (cache == nullptr) {
+      LOG_ERROR("Could not create cache texture [%s]", SDL_GetError());
+      return false;
+    }
+    SDL_SetTextureBlendMode(cache, SDL_BLENDMODE_NONE); // it is opaque
+  }
+  flushGeometry();
+  return SDL_SetRenderTarget(renderer, cache);
+}
+
+bool WindowManager::endCache() {
+  if (backend == Backend::SOFTWARE) {
+    cacheFramebuffer.copyFrom(framebuffer);
+    return true;
+  }
+  flushGeometry();
+  if (!SDL_SetRenderTarget(renderer, nullptr))
+    return false;
+  return drawCache();
+}
+
+// starts a frame like fillBackground
+bool WindowManager::drawCache() const {
+  if (!isReady())
+    return false;
+  if (backend == Backend::SOFTWARE) {
+    if (cacheFramebuffer.getWidth() != framebuffer.getWidth() ||
+        cacheFramebuffer.getHeight() != framebuffer.getHeight())
+      return false;
+    overlays.clear();
+    framebuffer.restoreFrom(cacheFramebuffer);
+    return true;
+  }
+  vertices.clear();
+  indices.clear();
+  return cache != nullptr &&
+         SDL_RenderTexture(renderer, cache, nullptr, nullptr);
+}
+
 std::pair<int, int> WindowManager::getWidthAndHeight() const {
   static int w, h;
-  if (!SDL_GetWindowSize(window, &w, &h)) {
-    std::cerr << "Could not get window size [" << SDL_GetError() << ']'
-              << std::endl;
+  if (window == nullptr) {
+    w = h = surface != nullptr ? surface->w : 0;
+    return {w, h};
+  }
+  if (!SDL_GetWindowSizeInPixels(window, &w, &h)) {
+    LOG_ERROR("Could not get window size [%s]", SDL_GetError());
     exit(1);
   }
   return {w, h};
@@ -454,14 +787,15 @@ AudioManager::AudioManager()
   for(size_t i=0; i<audioPaths.size(); i++){
     // SDL_AudioSpec s;
     if (!SDL_LoadWAV(audioPaths.at(i), &audioSpecs.at(i), &audios.at(i), &wav_data_len.at(i))){
-      std::cout << __FILE__ << ":" << __LINE__ << std::endl;
-      std::cerr << "Could not load wav file " << audioPaths.at(i) << ", " << SDL_GetError() <<  std::endl;
+      LOG_WARNING("Could not load wav file %s, %s", audioPaths.at(i),
+                  SDL_GetError());
       return;
     }
     // all audio files must have the same audio specification ... sorry not sorry
     // TODO: generalize later
     if(i!=0 && !audioSpecsAreEqual(&audioSpecs.at(i),&audioSpecs.at(i-1))){
-      std::cerr << "Files have different audio specifications " << audioPaths.at(i) << " " << audioPaths.at(i-1) << std::endl;
+      LOG_WARNING("Files have different audio specifications %s %s",
+                  audioPaths.at(i), audioPaths.at(i - 1));
       return;
     }
   }
@@ -469,7 +803,8 @@ AudioManager::AudioManager()
   audioSpecs.shrink_to_fit();
   stream = SDL_OpenAudioDeviceStream(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, &audioSpecs.at(0), NULL, NULL);
   if(stream==nullptr){
-      std::cerr << "Could not open audio device and stream " << SDL_GetError() <<  std::endl;
+      LOG_WARNING("Could not open audio device and stream %s",
+                  SDL_GetError());
       return;
   }
   SDL_ResumeAudioStreamDevice(stream);
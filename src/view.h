@@ -2,9 +2,12 @@
 #define VIEW_H
 
 #include "commons.h"
+#include "raster.h"
+#include <SDL3/SDL_events.h>
 #include <SDL3/SDL_init.h>
 #include <SDL3/SDL_render.h>
 #include <SDL3/SDL_video.h>
+#include <array>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -25,6 +28,10 @@ public:
 std::ostream &operator<<(std::ostream &os, const Color &c);
 constexpr bool operator==(const Color &c1, const Color &c2);
 
+// who turns draw calls into pixels: SDL's renderer, or our own framebuffer
+// uploaded to one streaming texture per frame
+enum class Backend { SDL, SOFTWARE };
+
 class WindowManager {
 public:
   inline bool isReady() const;
@@ -37,21 +44,72 @@ public:
   void render() const;
   bool drawPoint(int x, int y, const Color &c) const;
   bool fillCircle(int x, int y, int r, const Color &c) const;
-  std::pair<int, int> getWidthAndHeight() const;
+  bool drawText(int x, int y, const char *text, const Color &c) const;
+  std::pair<int, int> getWidthAndHeight() const; // in pixels
+  float getPixelDensity() const;
+  bool toRenderCoordinates(SDL_Event &event) const;
+  // what is drawn between beginCache and endCache is kept and redrawn by
+  // drawCache, until the next beginCache
+  bool beginCache();
+  bool endCache();
+  bool drawCache() const;
+  bool saveImage(const char *path) const; // PNG of what was drawn so far
 
 private:
   std::unordered_map<std::string, SDL_Texture *> textures;
+  bool offscreen;
   SDL_Window *window;
+  SDL_Surface *surface; // offscreen target, nullptr with a window
   SDL_Renderer *renderer;
+  // software backend, mutable because drawing is const for the SDL one
+  Backend backend;
+  mutable Framebuffer framebuffer;
+  mutable SDL_Texture *streaming;
+  // text and textures go on top of the framebuffer when it is presented
+  struct Overlay {
+    SDL_Texture *texture;
+    SDL_FRect box;
+    char text[64]; // longer text is cut, a string could allocate
+    SDL_Color color;
+  };
+  mutable std::vector<Overlay> overlays;
+  SDL_Texture *cache;           // SDL backend, a render target
+  Framebuffer cacheFramebuffer; // software backend
+  bool presentFramebuffer() const;
+  // SDL backend: primitives recorded as triangles, drawn by flushGeometry()
+  mutable std::vector<SDL_Vertex> vertices;
+  mutable std::vector<int> indices;
+  void addVertex(float x, float y, const Color &c) const;
+  void addQuad(float x1, float y1, float x2, float y2, float x3, float y3,
+               float x4, float y4, const Color &c) const;
+  bool flushGeometry() const;
 
 public:
-  WindowManager();
+  // offscreen managers draw into a surface with the software renderer and
+  // never touch the video subsystem
+  explicit WindowManager(bool offscreen = false,
+                         Backend backend = Backend::SDL);
   ~WindowManager();
   bool startWindow();
+  bool startOffscreen(int size);
   bool drawTexture(const char *imageName, const SDL_FRect *box) const;
   bool loadTexture(const char *c);
 };
 
+/**
+ * @brief Where things go for the current output size, only recomputed when
+ * the window is resized or moves to a screen with another pixel density.
+ * Colors are indexed red, green, yellow, blue.
+ */
+struct Layout {
+  int windowSize; // drawable square, in pixels
+  int tileSize;
+  float density; // pixels per window coordinate
+  std::array<SDL_Point, 4> diceCenters;
+  std::array<std::array<SDL_Point, 4>, 4> jailCenters;
+  static Layout compute(int width, int height, float density);
+};
+
 // forward declarations
 class Piece;
 class Player;
@@ -63,23 +121,42 @@ class View {
 
 private:
   WindowManager windowManager;
+  Layout layout;
+  bool boardCached; // the static board is in the window manager's cache
 
 public:
   void render();
   void updateWindowDimensions();
+  // true for the window events that change the layout, which is updated
+  bool handleWindowEvent(const SDL_Event &event);
+  // mouse positions in pixels, like everything drawn
+  bool toRenderCoordinates(SDL_Event &event) const;
+  const Layout &getLayout() const { return layout; }
   void drawBoard();
-  void drawPiece(int x, int y, const Color &c, int radius = TS / 8);
+  // an eighth of a tile wide, centered on x, y
+  void drawPiece(int x, int y, const Color &c);
   void drawConfigBase();
   void drawDice(const Color &c, int value);
   void preparePlayerDice(const Color &c);
-  void highLightPosition(int x, int y, const Color &c, int width = TS,
-                         int height = TS);
+  // the tile with its top left corner at x, y
+  void highLightPosition(int x, int y, const Color &c);
+  void drawWinProbability(const Color &c, float probability);
+  void drawMoveDelta(int x, int y, float delta);
+  void drawStatus(const char *text); // debug line in the top left corner
+  // tile shaded from clear (0) to dark red (1)
+  void drawHeat(int x, int y, float intensity);
+  bool saveImage(const char *path) const;
 
 private:
-  bool drawStar(int x, int y, int side, const Color &c) const;
+  // star outline for one tile size as line offsets x1, y1, x2, y2
+  int starSide;
+  std::array<std::array<int, 4>, 10> starLines;
+  bool drawStar(int x, int y, int side, const Color &c);
+  void drawBoardShapes();
 
 public:
-  View();
+  // offscreen: WINDOW_SIZE square
+  explicit View(bool offscreen = false, Backend backend = Backend::SDL);
   ~View();
 };
 } // namespace gamespace